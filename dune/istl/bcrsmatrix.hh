@@ -1061,6 +1061,53 @@ namespace Dune {
 		}
 	}
 
+    /**
+     * @brief Y = A X for a multi vector, see BlockMultiVector.
+     *
+     * The matrix is traversed only once for all columns of X, i.e.
+     * the memory traffic for the matrix is shared by all columns.
+     */
+    template<class X, class Y>
+    void mvmulti (const X& x, Y& y) const
+    {
+#ifdef DUNE_ISTL_WITH_CHECKING
+      if (x.N()!=M()) DUNE_THROW(ISTLError,"index out of range");
+      if (y.N()!=N()) DUNE_THROW(ISTLError,"index out of range");
+#endif
+      ConstRowIterator endi=end();
+      for (ConstRowIterator i=begin(); i!=endi; ++i)
+        {
+          y[i.index()]=0;
+          ConstColIterator endj = (*i).end();
+          for (ConstColIterator j=(*i).begin(); j!=endj; ++j)
+            usmvmultiblock(1,*j,x[j.index()],y[i.index()]);
+        }
+    }
+
+    //! Y += A X for a multi vector, see mvmulti
+    template<class X, class Y>
+    void umvmulti (const X& x, Y& y) const
+    {
+      usmvmulti(1,x,y);
+    }
+
+    //! Y += alpha A X for a multi vector, see mvmulti
+    template<class X, class Y>
+    void usmvmulti (const field_type& alpha, const X& x, Y& y) const
+    {
+#ifdef DUNE_ISTL_WITH_CHECKING
+      if (x.N()!=M()) DUNE_THROW(ISTLError,"index out of range");
+      if (y.N()!=N()) DUNE_THROW(ISTLError,"index out of range");
+#endif
+      ConstRowIterator endi=end();
+      for (ConstRowIterator i=begin(); i!=endi; ++i)
+        {
+          ConstColIterator endj = (*i).end();
+          for (ConstColIterator j=(*i).begin(); j!=endj; ++j)
+            usmvmultiblock(alpha,*j,x[j.index()],y[i.index()]);
+        }
+    }
+
     //! y = A^T x
     template<class X, class Y>
     void mtv (const X& x, Y& y) const
@@ -1299,6 +1346,21 @@ namespace Dune {
     Dune::shared_ptr<size_type> j;  // [nnz] column indices of entries
 
 
+    /**
+     * @brief y += alpha a x for one matrix block a and one block of a
+     * multi vector each.
+     *
+     * The blocks of the multi vector are dense matrices with one column
+     * per vector.
+     */
+    template<class XB, class YB>
+    static void usmvmultiblock (const field_type& alpha, const B& a, const XB& x, YB& y)
+    {
+      for (size_type r=0; r<a.N(); ++r)
+        for (size_type c=0; c<a.M(); ++c)
+          y[r].axpy(alpha*a[r][c],x[c]);
+    }
+
     void setWindowPointers(ConstRowIterator row)
     {
       row_type current_row(a,j.get(),0); // Pointers to current row data
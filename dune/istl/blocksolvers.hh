@@ -0,0 +1,732 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=4 sw=2 et sts=2:
+
+#ifndef DUNE_BLOCKSOLVERS_HH
+#define DUNE_BLOCKSOLVERS_HH
+
+#include<cmath>
+#include<iostream>
+#include<vector>
+
+#include "istlexception.hh"
+#include "multivector.hh"
+#include "operators.hh"
+#include "preconditioners.hh"
+#include "solvers.hh"
+#include <dune/common/timer.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/static_assert.hh>
+
+/** \file
+
+    \brief Block Krylov methods solving for several right hand sides at once.
+
+    The solvers work on BlockMultiVector. The operator is applied to all
+    columns at once, which allows streaming the matrix once per iteration
+    for all right hand sides (see MultiVectorMatrixAdapter).
+*/
+
+namespace Dune {
+
+  /** @addtogroup ISTL_Solvers
+      @{
+  */
+
+  /*!
+    \brief Adapter to turn a matrix into a linear operator on multi vectors.
+
+    The matrix is applied to all columns at once using BCRSMatrix::mvmulti.
+  */
+  template<class M, class X, class Y>
+  class MultiVectorMatrixAdapter : public AssembledLinearOperator<M,X,Y>
+  {
+  public:
+    //! export types
+    typedef M matrix_type;
+    typedef X domain_type;
+    typedef Y range_type;
+    typedef typename X::field_type field_type;
+
+    //! define the category
+    enum {category=SolverCategory::sequential};
+
+    //! constructor: just store a reference to a matrix
+    MultiVectorMatrixAdapter (const M& A) : _A_(A) {}
+
+    //! apply operator to x:  \f$ y = A(x) \f$
+    virtual void apply (const X& x, Y& y) const
+    {
+      _A_.mvmulti(x,y);
+    }
+
+    //! apply operator to x, scale and add:  \f$ y = y + \alpha A(x) \f$
+    virtual void applyscaleadd (field_type alpha, const X& x, Y& y) const
+    {
+      _A_.usmvmulti(alpha,x,y);
+    }
+
+    //! get matrix via *
+    virtual const M& getmat () const
+    {
+      return _A_;
+    }
+
+  private:
+    const M& _A_;
+  };
+
+  /*!
+    \brief Applies a preconditioner for single vectors to each column of
+    a multi vector.
+
+    This allows to use all existing preconditioners (e.g. ILU or AMG)
+    with the block Krylov methods. Preconditioner::pre and
+    Preconditioner::post are only called for the first column. They
+    set up and release the state of the preconditioner for one solve,
+    e.g. AMG allocates its vector hierarchies in pre, and calling them
+    once per column would repeat this without a matching post. Any
+    changes pre makes to x and b are therefore only applied to the
+    first column. The other columns have to be prepared by the caller,
+    e.g. by making Dirichlet rows consistent beforehand.
+
+    \tparam X The type of the multi vector.
+  */
+  template<class X>
+  class MultiVectorPreconditioner : public Preconditioner<X,X>
+  {
+  public:
+    //! \brief The domain type of the preconditioner.
+    typedef X domain_type;
+    //! \brief The range type of the preconditioner.
+    typedef X range_type;
+    //! \brief The field type of the preconditioner.
+    typedef typename X::field_type field_type;
+    //! \brief The type of a single column.
+    typedef typename X::column_type column_type;
+
+    //! \brief The category the preconditioner is part of.
+    enum {category=SolverCategory::sequential};
+
+    /**
+     * @brief Constructor.
+     * @param prec The preconditioner for single vectors.
+     */
+    MultiVectorPreconditioner (Preconditioner<column_type,column_type>& prec)
+      : _prec(prec)
+    {}
+
+    /*!
+      \brief Prepare the preconditioner.
+
+      \copydoc Preconditioner::pre(X&,Y&)
+    */
+    virtual void pre (X& x, X& b)
+    {
+      x.column(0,_v);
+      b.column(0,_d);
+      _prec.pre(_v,_d);
+      x.setColumn(0,_v);
+      b.setColumn(0,_d);
+    }
+
+    /*!
+      \brief Apply the precondioner to each column.
+
+      \copydoc Preconditioner::apply(X&,const Y&)
+    */
+    virtual void apply (X& v, const X& d)
+    {
+      for(int c=0; c<X::columns; ++c){
+        v.column(c,_v);
+        d.column(c,_d);
+        _prec.apply(_v,_d);
+        v.setColumn(c,_v);
+      }
+    }
+
+    /*!
+      \brief Clean up.
+
+      \copydoc Preconditioner::post(X&)
+    */
+    virtual void post (X& x)
+    {
+      x.column(0,_v);
+      _prec.post(_v);
+      x.setColumn(0,_v);
+    }
+
+  private:
+    Preconditioner<column_type,column_type>& _prec;
+    column_type _v;
+    column_type _d;
+  };
+
+  /*!
+    \brief Block conjugate gradient method.
+
+    Solves \f$ AX=B\f$ for k right hand sides simultaneously with the
+    block CG method of D. P. O'Leary, 'The block conjugate gradient
+    algorithm and related methods', Linear Algebra Appl. 29, 1980.
+
+    Compared to k independent CG solves the operator is applied to all
+    search directions at once and the iteration count usually drops, as
+    the Krylov space is shared between the right hand sides.
+    The right hand sides have to be linearly independent.
+    The iteration stops once the defect of every column is reduced
+    by the given factor.
+
+    \tparam X The type of the multi vector, e.g. BlockMultiVector.
+  */
+  template<class X>
+  class BlockCGSolver : public InverseOperator<X,X> {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted.
+    typedef typename X::field_type field_type;
+    //! \brief The real type of the field type
+    typedef typename FieldTraits<field_type>::real_type real_type;
+    //! \brief The type of the dense coefficient matrices.
+    typedef typename X::coefficient_type coefficient_type;
+    //! \brief The type of the vector holding the defects of all columns.
+    typedef typename X::column_norm_type column_norm_type;
+
+    /*!
+      \brief Set up block conjugate gradient solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+    */
+    template<class L, class P>
+    BlockCGSolver (L& op, P& prec, double reduction, int maxit, int verbose) :
+      _op(op), _prec(prec), _reduction(reduction), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
+        "L and P must have the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential),
+        "L must be sequential!");
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      res.clear();                  // clear solver statistics
+      Timer watch;                // start a timer
+      _prec.pre(x,b);             // prepare preconditioner
+      _op.applyscaleadd(-1,x,b);  // overwrite b with defect
+
+      X p(x);              // the search directions
+      X q(x);              // A times the search directions
+      X z(x);              // the preconditioned defects
+
+      column_norm_type def0, def;
+      b.columnNorms(def0);
+      real_type maxdef=def0.infinity_norm();
+
+      if (_verbose>0)             // printing
+      {
+        std::cout << "=== BlockCGSolver" << std::endl;
+        if (_verbose>1) {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,maxdef);
+        }
+      }
+
+      if (converged(def0,def0))
+      {
+        _prec.post(x);
+        res.converged  = true;
+        res.iterations = 0;               // fill statistics
+        res.reduction = 0;
+        res.conv_rate  = 0;
+        res.elapsed=watch.elapsed();
+        return;
+      }
+
+      coefficient_type rho, rhonew, alpha, beta, pq;
+
+      // determine initial search directions
+      z = 0;
+      _prec.apply(z,b);
+      p = z;
+      z.transposedMult(b,rho);
+
+      int i=1;
+      real_type maxdefold=maxdef;
+      for ( ; i<=_maxit; i++ )
+      {
+        // minimize in the space spanned by the search directions
+        _op.apply(p,q);
+        p.transposedMult(q,pq);
+        alpha = rho;
+        alpha.leftmultiply(invert(pq,i));
+        x.rightmultiplyadd(p,alpha);
+        alpha *= -1.0;
+        b.rightmultiplyadd(q,alpha);
+
+        b.columnNorms(def);
+        maxdef = def.infinity_norm();
+        if (_verbose>1)             // print
+          this->printOutput(std::cout,i,maxdef,maxdefold);
+        maxdefold = maxdef;
+
+        if (converged(def,def0))
+        {
+          res.converged  = true;
+          break;
+        }
+
+        // determine new search directions
+        z = 0;
+        _prec.apply(z,b);
+        z.transposedMult(b,rhonew);
+        beta = rhonew;
+        beta.leftmultiply(invert(rho,i));
+        p.rightmultiply(beta);
+        p += z;
+        rho = rhonew;
+      }
+
+      if (_verbose==1)                // printing for non verbose
+        this->printOutput(std::cout,i,maxdef);
+
+      _prec.post(x);                  // postprocess preconditioner
+      res.iterations = i;               // fill statistics
+      res.reduction = maxReduction(def,def0);
+      res.conv_rate  = pow(res.reduction,1.0/i);
+      res.elapsed = watch.elapsed();
+
+      if (_verbose>0)                 // final print
+      {
+        std::cout << "=== rate=" << res.conv_rate
+                  << ", T=" << res.elapsed
+                  << ", TIT=" << res.elapsed/i
+                  << ", IT=" << i << std::endl;
+      }
+    }
+
+    /*!
+      \brief Apply inverse operator with given reduction factor.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction,
+      InverseOperatorResult& res)
+    {
+      std::swap(_reduction,reduction);
+      (*this).apply(x,b,res);
+      std::swap(_reduction,reduction);
+    }
+
+  private:
+    bool converged(const column_norm_type& def, const column_norm_type& def0) const
+    {
+      for(int c=0; c<X::columns; ++c)
+        if(def[c]>=def0[c]*_reduction && def[c]>=1E-30)
+          return false;
+      return true;
+    }
+
+    real_type maxReduction(const column_norm_type& def, const column_norm_type& def0) const
+    {
+      real_type red=0;
+      for(int c=0; c<X::columns; ++c)
+        if(def0[c]>0)
+          red=std::max(red,def[c]/def0[c]);
+      return red;
+    }
+
+    coefficient_type invert(coefficient_type m, int i) const
+    {
+      try{
+        m.invert();
+      }catch(const FMatrixError&){
+        DUNE_THROW(ISTLError,"breakdown in block CG - singular coefficient matrix"
+          << " after " << i << " iterations."
+          << " Are the right hand sides linearly independent?");
+      }
+      return m;
+    }
+
+    LinearOperator<X,X>& _op;
+    Preconditioner<X,X>& _prec;
+    double _reduction;
+    int _maxit;
+    int _verbose;
+  };
+
+  /**
+     \brief Restarted block GMRes method.
+
+     Solves \f$ AX=B\f$ for k right hand sides simultaneously using a
+     block Arnoldi process, i.e. the Krylov space is built from blocks of
+     k vectors and shared between all right hand sides. Like
+     RestartedGMResSolver the preconditioner is applied from the left and
+     the convergence test uses the preconditioned defects. The
+     iteration stops once the defect of every column is reduced
+     by the given factor.
+
+     The blocks of the Krylov basis are orthonormalized by a Cholesky QR
+     factorization, which fails if the right hand sides are linearly
+     dependent.
+
+     \tparam X The type of the multi vector, e.g. BlockMultiVector.
+  */
+  template<class X>
+  class BlockGMResSolver : public InverseOperator<X,X>
+  {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted
+    typedef typename X::field_type field_type;
+    //! \brief The real type of the field type
+    typedef typename FieldTraits<field_type>::real_type real_type;
+    //! \brief The type of the dense coefficient matrices.
+    typedef typename X::coefficient_type coefficient_type;
+    //! \brief The type of the vector holding the defects of all columns.
+    typedef typename X::column_norm_type column_norm_type;
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+      \param restart number of block GMRes cycles before restart
+    */
+    template<class L, class P>
+    BlockGMResSolver (L& op, P& prec, double reduction, int restart, int maxit, int verbose) :
+      _A_(op), _M(prec), _restart(restart),
+      _reduction(reduction), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert(static_cast<int>(P::category) == static_cast<int>(L::category),
+        "P and L must be the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential),
+        "L must be sequential!");
+    }
+
+    //! \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      apply(x,b,_reduction,res);
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction, InverseOperatorResult& res)
+    {
+      const int k = X::columns;
+      const int m = _restart;
+      column_norm_type norm, norm_0;
+      real_type maxnorm, maxnorm_old;
+      int j = 1;
+
+      // helper vectors
+      X w(b);
+      X t(b);
+      std::vector<X> v(m+1,b);
+
+      // the block Hessenberg matrix and the right hand side of the
+      // least squares problem, stored densely
+      std::vector<std::vector<field_type> > H((m+1)*k, std::vector<field_type>(m*k));
+      std::vector<std::vector<field_type> > G((m+1)*k, std::vector<field_type>(k));
+      // Givens rotations (cs,sn) eliminating H[c+l+1][c] against H[c][c]
+      std::vector<std::vector<field_type> > cs(m*k, std::vector<field_type>(k));
+      std::vector<std::vector<field_type> > sn(m*k, std::vector<field_type>(k));
+      coefficient_type S, Hij;
+
+      Timer watch;                // start a timer
+
+      // clear solver statistics
+      res.clear();
+      _M.pre(x,b);
+
+      _A_.applyscaleadd(-1,x,b);  // b = b - Ax;
+      v[0] = 0.0; _M.apply(v[0],b); // r = M^-1 b
+      v[0].columnNorms(norm_0);
+      norm = norm_0;
+      maxnorm = maxnorm_old = norm_0.infinity_norm();
+
+      // print header
+      if (_verbose > 0)
+      {
+        std::cout << "=== BlockGMResSolver" << std::endl;
+        if (_verbose > 1)
+        {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,maxnorm);
+        }
+      }
+
+      if (converged(norm,norm_0,reduction)) {
+        _M.post(x);                  // postprocess preconditioner
+        res.converged  = true;
+        res.elapsed = watch.elapsed();
+        return;
+      }
+
+      while (j <= _maxit && res.converged != true) {
+        int i;
+        // v[0] S = r
+        orthonormalize(v[0],S,j);
+        for (int r=0; r<(m+1)*k; ++r)
+          for (int q=0; q<k; ++q)
+            G[r][q] = (r<k) ? S[r][q] : field_type(0);
+
+        for (i = 0; i < m && j <= _maxit && res.converged != true; i++, j++) {
+          // w = M^-1 A v[i]
+          _A_.apply(v[i], t);
+          w = 0.0;
+          _M.apply(w, t);
+
+          // block modified Gram-Schmidt, applied twice for stability
+          for (int l=0; l<=i; ++l)
+            setBlock(H,l,i,0.0);
+          for (int pass=0; pass<2; ++pass)
+            for (int l=0; l<=i; ++l) {
+              v[l].transposedMult(w,Hij);
+              addBlock(H,l,i,Hij);
+              Hij *= -1.0;
+              w.rightmultiplyadd(v[l],Hij);
+            }
+          orthonormalize(w,S,j);
+          setBlock(H,i+1,i,S);
+          v[i+1] = w;
+
+          // update the QR factorization of H and the right hand side
+          for (int a=0; a<k; ++a) {
+            const int c = i*k+a;
+            for (int cc=0; cc<c; ++cc)
+              for (int l=0; l<k; ++l)
+                applyPlaneRotation(H[cc][c], H[cc+l+1][c], cs[cc][l], sn[cc][l]);
+            for (int l=0; l<k; ++l) {
+              generatePlaneRotation(H[c][c], H[c+l+1][c], cs[c][l], sn[c][l]);
+              applyPlaneRotation(H[c][c], H[c+l+1][c], cs[c][l], sn[c][l]);
+              for (int q=0; q<k; ++q)
+                applyPlaneRotation(G[c][q], G[c+l+1][q], cs[c][l], sn[c][l]);
+            }
+          }
+
+          // the defects of the least squares problem
+          for (int q=0; q<k; ++q) {
+            real_type sum = 0;
+            for (int r=(i+1)*k; r<(i+2)*k; ++r)
+              sum += std::abs(G[r][q])*std::abs(G[r][q]);
+            norm[q] = std::sqrt(sum);
+          }
+          maxnorm = norm.infinity_norm();
+
+          if (_verbose > 1)             // print
+            this->printOutput(std::cout,j,maxnorm,maxnorm_old);
+          maxnorm_old = maxnorm;
+
+          if (converged(norm,norm_0,reduction))
+            res.converged = true;
+        }
+
+        // calc update vector
+        w = 0;
+        update(w, i*k, H, G, v);
+
+        // update x
+        x += w;
+
+        // update defect, r = M^-1 (b - A * x);
+        _A_.applyscaleadd(-1,w, /* => */ b);
+        v[0] = 0.0; _M.apply(v[0],b);
+        v[0].columnNorms(norm);
+        maxnorm = norm.infinity_norm();
+
+        if (_verbose > 1)             // print
+          this->printOutput(std::cout,j,maxnorm,maxnorm_old);
+        maxnorm_old = maxnorm;
+
+        res.converged = converged(norm,norm_0,reduction);
+
+        if (res.converged != true && _verbose > 0)
+          std::cout << "=== BlockGMRes::restart\n";
+      }
+
+      _M.post(x);                  // postprocess preconditioner
+
+      res.iterations = j;
+      res.reduction = maxReduction(norm,norm_0);
+      res.conv_rate  = pow(res.reduction,1.0/j);
+      res.elapsed = watch.elapsed();
+
+      if (_verbose>0)
+        std::cout << "=== rate=" << res.conv_rate
+                  << ", T=" << res.elapsed
+                  << ", TIT=" << res.elapsed/j
+                  << ", IT=" << res.iterations
+                  << std::endl;
+    }
+
+  private:
+    bool converged(const column_norm_type& def, const column_norm_type& def0,
+                   double reduction) const
+    {
+      for(int c=0; c<X::columns; ++c)
+        if(def[c]>def0[c]*reduction && def[c]>=1E-30)
+          return false;
+      return true;
+    }
+
+    real_type maxReduction(const column_norm_type& def, const column_norm_type& def0) const
+    {
+      real_type red=0;
+      for(int c=0; c<X::columns; ++c)
+        if(def0[c]>0)
+          red=std::max(red,def[c]/def0[c]);
+      return red;
+    }
+
+    static void setBlock(std::vector<std::vector<field_type> >& h, int bi, int bj,
+                         const field_type& f)
+    {
+      const int k = X::columns;
+      for (int r=0; r<k; ++r)
+        for (int c=0; c<k; ++c)
+          h[bi*k+r][bj*k+c] = f;
+    }
+
+    static void setBlock(std::vector<std::vector<field_type> >& h, int bi, int bj,
+                         const coefficient_type& b)
+    {
+      const int k = X::columns;
+      for (int r=0; r<k; ++r)
+        for (int c=0; c<k; ++c)
+          h[bi*k+r][bj*k+c] = b[r][c];
+    }
+
+    static void addBlock(std::vector<std::vector<field_type> >& h, int bi, int bj,
+                         const coefficient_type& b)
+    {
+      const int k = X::columns;
+      for (int r=0; r<k; ++r)
+        for (int c=0; c<k; ++c)
+          h[bi*k+r][bj*k+c] += b[r][c];
+    }
+
+    /**
+     * @brief Computes the QR factorization w = Q S by Cholesky QR.
+     *
+     * On return w contains the orthonormal factor Q and s the upper
+     * triangular factor. The factorization is computed twice to
+     * retain orthogonality.
+     */
+    void orthonormalize(X& w, coefficient_type& s, int j) const
+    {
+      const int k = X::columns;
+      coefficient_type c, r, rinv;
+      s = 0;
+      for (int a=0; a<k; ++a)
+        s[a][a] = 1.0;
+      for (int pass=0; pass<2; ++pass) {
+        w.transposedMult(w,c);
+        // Cholesky factorization c = r^T r
+        r = 0;
+        for (int a=0; a<k; ++a) {
+          field_type d = c[a][a];
+          for (int l=0; l<a; ++l)
+            d -= r[l][a]*r[l][a];
+          if (std::abs(d) <= 0.0 || d != d)
+            DUNE_THROW(ISTLError,"breakdown in block GMRes - block of basis"
+              << " vectors is rank deficient after " << j << " iterations");
+          r[a][a] = std::sqrt(d);
+          for (int b=a+1; b<k; ++b) {
+            field_type e = c[a][b];
+            for (int l=0; l<a; ++l)
+              e -= r[l][a]*r[l][b];
+            r[a][b] = e/r[a][a];
+          }
+        }
+        // invert the triangular factor
+        rinv = 0;
+        for (int a=k-1; a>=0; --a) {
+          rinv[a][a] = 1.0/r[a][a];
+          for (int b=a+1; b<k; ++b) {
+            field_type e = 0;
+            for (int l=a+1; l<=b; ++l)
+              e += r[a][l]*rinv[l][b];
+            rinv[a][b] = -e/r[a][a];
+          }
+        }
+        w.rightmultiply(rinv);
+        s.leftmultiply(r);
+      }
+    }
+
+    static void
+    update(X &x, int n,
+      std::vector<std::vector<field_type> > & h,
+      std::vector<std::vector<field_type> > & g, std::vector<X>& v)
+    {
+      const int k = X::columns;
+      std::vector<std::vector<field_type> > y(g);
+
+      // Backsolve:
+      for (int i = n-1; i >= 0; i--)
+        for (int q = 0; q < k; q++) {
+          y[i][q] /= h[i][i];
+          for (int j = i - 1; j >= 0; j--)
+            y[j][q] -= h[j][i] * y[i][q];
+        }
+
+      coefficient_type yb;
+      for (int l = 0; l < n/k; l++) {
+        for (int r = 0; r < k; r++)
+          for (int q = 0; q < k; q++)
+            yb[r][q] = y[l*k+r][q];
+        x.rightmultiplyadd(v[l],yb);
+      }
+    }
+
+    void
+    generatePlaneRotation(field_type &dx, field_type &dy, field_type &cs, field_type &sn)
+    {
+      if (dy == 0.0) {
+        cs = 1.0;
+        sn = 0.0;
+      } else if (std::abs(dy) > std::abs(dx)) {
+        field_type temp = dx / dy;
+        sn = 1.0 / std::sqrt( 1.0 + temp*temp );
+        cs = temp * sn;
+      } else {
+        field_type temp = dy / dx;
+        cs = 1.0 / std::sqrt( 1.0 + temp*temp );
+        sn = temp * cs;
+      }
+    }
+
+    void
+    applyPlaneRotation(field_type &dx, field_type &dy, field_type &cs, field_type &sn)
+    {
+      field_type temp  =  cs * dx + sn * dy;
+      dy = -sn * dx + cs * dy;
+      dx = temp;
+    }
+
+    LinearOperator<X,X>& _A_;
+    Preconditioner<X,X>& _M;
+    int _restart;
+    double _reduction;
+    int _maxit;
+    int _verbose;
+  };
+
+  /** @} end documentation */
+
+} // end namespace
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef DUNE_ISTLEXC_HH
 #define DUNE_ISTLEXC_HH
 
+#include <exception>
 #include <dune/common/exceptions.hh>
 
 namespace Dune {
@@ -13,6 +14,70 @@ namespace Dune {
   //! derive error class from the base class in common
   class ISTLError : public Dune::MathError {};
 
+  /**
+   * @brief Keeps the first exception thrown inside an OpenMP region.
+   *
+   * Exceptions must not leave a parallel region. They are caught inside
+   * the region by calling store() in a catch(...) block and thrown again
+   * after the region by rethrow(). With C++11 the original exception is
+   * rethrown. Older compilers have no std::exception_ptr, there it is
+   * rethrown as a Dune::Exception with the message of the original one.
+   * Therefore only catch the exceptions if the region is compiled with
+   * OpenMP.
+   */
+  class DeferredException
+  {
+  public:
+    DeferredException()
+      : thrown_(false)
+    {}
+
+    /** @brief Store the exception currently handled if it is the first one. */
+    void store()
+    {
+#ifdef _OPENMP
+#pragma omp critical(DuneDeferredException)
+#endif
+      {
+        if(!thrown_){
+          thrown_=true;
+#if __cplusplus >= 201103L
+          error_=std::current_exception();
+#else
+          try{
+            throw;
+          }catch(const Exception& e){
+            error_=e;
+          }catch(const std::exception& e){
+            error_.message(e.what());
+          }catch(...){
+            error_.message("Unknown exception");
+          }
+#endif
+        }
+      }
+    }
+
+    /** @brief Throw the stored exception, if any. */
+    void rethrow() const
+    {
+      if(thrown_)
+#if __cplusplus >= 201103L
+        std::rethrow_exception(error_);
+#else
+        throw error_;
+#endif
+    }
+
+  private:
+    bool thrown_;
+#if __cplusplus >= 201103L
+    std::exception_ptr error_;
+#else
+    Exception error_;
+#endif
+  };
+
   /** @} end documentation */
 
 } // end namespace
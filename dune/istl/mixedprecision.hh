@@ -0,0 +1,275 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=4 sw=2 et sts=2:
+
+#ifndef DUNE_MIXEDPRECISION_HH
+#define DUNE_MIXEDPRECISION_HH
+
+#include<algorithm>
+#include<cmath>
+#include<iostream>
+
+#include "istlexception.hh"
+#include "bcrsmatrix.hh"
+#include "operators.hh"
+#include "preconditioners.hh"
+#include "scalarproducts.hh"
+#include "solvers.hh"
+#include <dune/common/timer.hh>
+#include <dune/common/static_assert.hh>
+
+/** \file
+
+    \brief Mixed precision iterative refinement.
+
+    The inner solver works on a low precision (e.g. float) copy of the
+    system, which halves the memory traffic of matrix and vectors, while
+    the defects of the outer iteration are computed in full precision.
+*/
+
+namespace Dune {
+
+  /** @addtogroup ISTL_Solvers
+      @{
+  */
+
+  /**
+   * @brief Copy a block vector into a vector with a different field type.
+   *
+   * Both vectors need blocks of the same size with one level of blocking,
+   * e.g. BlockVector<FieldVector<double,n> > and
+   * BlockVector<FieldVector<float,n> >. The target is resized if needed.
+   */
+  template<class X, class XF>
+  void convertVector(const X& x, XF& xf)
+  {
+    dune_static_assert(static_cast<int>(X::block_type::dimension)
+                       == static_cast<int>(XF::block_type::dimension),
+                       "The block sizes have to match!");
+    if(xf.N()!=x.N())
+      xf.resize(x.N(), false);
+    for(typename X::size_type i=0; i<x.N(); ++i)
+      for(int j=0; j<X::block_type::dimension; ++j)
+        xf[i][j]=x[i][j];
+  }
+
+  /**
+   * @brief Copy a sparse matrix into a matrix with a different field type.
+   *
+   * The sparsity pattern of a is copied, the blocks have to be dense
+   * matrices of the same size, e.g. FieldMatrix<double,n,n> and
+   * FieldMatrix<float,n,n>.
+   */
+  template<class B, class A, class BF, class AF>
+  void convertMatrix(const BCRSMatrix<B,A>& a, BCRSMatrix<BF,AF>& af)
+  {
+    typedef BCRSMatrix<B,A> Matrix;
+    typedef BCRSMatrix<BF,AF> MatrixF;
+    dune_static_assert(static_cast<int>(B::rows)==static_cast<int>(BF::rows)
+                       && static_cast<int>(B::cols)==static_cast<int>(BF::cols),
+                       "The block sizes have to match!");
+
+    af.setSize(a.N(), a.M(), a.nonzeroes());
+    af.setBuildMode(MatrixF::row_wise);
+    typedef typename Matrix::ConstRowIterator RowIterator;
+    typedef typename Matrix::ConstColIterator ColIterator;
+
+    typename MatrixF::CreateIterator ci=af.createbegin();
+    for(RowIterator row=a.begin(); row!=a.end(); ++row, ++ci)
+      for(ColIterator col=row->begin(); col!=row->end(); ++col)
+        ci.insert(col.index());
+
+    typename MatrixF::RowIterator rowf=af.begin();
+    for(RowIterator row=a.begin(); row!=a.end(); ++row, ++rowf){
+      typename MatrixF::ColIterator colf=rowf->begin();
+      for(ColIterator col=row->begin(); col!=row->end(); ++col, ++colf)
+        for(int r=0; r<B::rows; ++r)
+          for(int c=0; c<B::cols; ++c)
+            (*colf)[r][c]=(*col)[r][c];
+    }
+  }
+
+  /*!
+    \brief Iterative refinement with an inner solver in lower precision.
+
+    Each outer step computes the defect \f$ d=b-Ax\f$ in the precision of
+    X, rounds it to the precision of XF, solves \f$ A_F v=d\f$ approximately
+    with the inner solver or preconditioner and adds the correction to x.
+    For well conditioned problems the iteration converges to the accuracy
+    of X while the inner solver (e.g. AMG, ILU or SuperLU on a float copy
+    of the matrix created with convertMatrix) only touches data in the
+    precision of XF.
+
+    \tparam X The vector type of the outer iteration, e.g. BlockVector<FieldVector<double,n> >.
+    \tparam XF The vector type of the inner solver, e.g. BlockVector<FieldVector<float,n> >.
+  */
+  template<class X, class XF>
+  class IterativeRefinementSolver : public InverseOperator<X,X> {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted.
+    typedef typename X::field_type field_type;
+    //! \brief The vector type of the inner solver.
+    typedef XF inner_domain_type;
+
+    /*!
+      \brief Set up the solver using an inner solver.
+
+      \param op The operator in full precision used to compute the defects.
+      \param inner The solver for the low precision system.
+      \param reduction The minimal defect reduction to achieve.
+      \param innerReduction The defect reduction requested from the inner
+      solver in each step.
+      \param maxit The maximum number of outer steps.
+      \param verbose The verbosity level.
+    */
+    template<class L>
+    IterativeRefinementSolver (L& op, InverseOperator<XF,XF>& inner, double reduction,
+                               double innerReduction, int maxit, int verbose) :
+      ssp(), _op(op), _inner(&inner), _prec(0), _sp(ssp), _reduction(reduction),
+      _innerReduction(innerReduction), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential),
+        "L must be sequential!");
+    }
+
+    /*!
+      \brief Set up the solver using a preconditioner as inner solver.
+
+      One application of the preconditioner is used as inner solver.
+
+      \param op The operator in full precision used to compute the defects.
+      \param prec The preconditioner for the low precision system.
+      \param reduction The minimal defect reduction to achieve.
+      \param maxit The maximum number of outer steps.
+      \param verbose The verbosity level.
+    */
+    template<class L, class P>
+    IterativeRefinementSolver (L& op, P& prec, double reduction, int maxit, int verbose) :
+      ssp(), _op(op), _inner(0), _prec(&prec), _sp(ssp), _reduction(reduction),
+      _innerReduction(0), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
+        "L and P must have the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential),
+        "L must be sequential!");
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      res.clear();                  // clear solver statistics
+      Timer watch;                // start a timer
+      _op.applyscaleadd(-1,x,b);  // overwrite b with defect
+
+      XF vf(b.N()), df(b.N());
+      X v(b.N());
+      InverseOperatorResult innerRes;
+
+      double def0 = _sp.norm(b);// compute norm
+      double def = def0;
+
+      if (_verbose>0)             // printing
+      {
+        std::cout << "=== IterativeRefinementSolver" << std::endl;
+        if (_verbose>1) {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,def0);
+        }
+      }
+
+      int i=0;
+      if (def0<1E-30)
+        res.converged = true;
+      else{
+        convertVector(x,vf);
+        convertVector(b,df);
+        if (_prec)
+          _prec->pre(vf,df);
+        for (i=1; i<=_maxit; i++)
+        {
+          // solve for the correction in low precision
+          convertVector(b,df);
+          vf = 0;
+          if (_prec)
+            _prec->apply(vf,df);
+          else
+            _inner->apply(vf,df,_innerReduction,innerRes);
+          convertVector(vf,v);
+
+          // update solution and defect in full precision
+          x += v;
+          _op.applyscaleadd(-1,v,b);
+
+          double defnew=_sp.norm(b);
+          if (_verbose>1)             // print
+            this->printOutput(std::cout,i,defnew,def);
+          if (defnew>=def && _verbose>0)
+            std::cout << "=== IterativeRefinementSolver: defect did not decrease"
+                      << std::endl;
+          def = defnew;
+          if (def<def0*_reduction || def<1E-30)    // convergence check
+          {
+            res.converged  = true;
+            break;
+          }
+        }
+        if (i>_maxit)
+          i=_maxit;
+        if (_prec)
+          _prec->post(vf);
+      }
+
+      if (_verbose==1)                // printing for non verbose
+        this->printOutput(std::cout,i,def);
+
+      res.iterations = i;               // fill statistics
+      res.reduction = def0>0 ? def/def0 : 0;
+      res.conv_rate  = i>0 ? pow(res.reduction,1.0/i) : 0;
+      res.elapsed = watch.elapsed();
+
+      if (_verbose>0)                 // final print
+      {
+        std::cout << "=== rate=" << res.conv_rate
+                  << ", T=" << res.elapsed
+                  << ", TIT=" << res.elapsed/std::max(i,1)
+                  << ", IT=" << i << std::endl;
+      }
+    }
+
+    /*!
+      \brief Apply inverse operator with given reduction factor.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction,
+      InverseOperatorResult& res)
+    {
+      std::swap(_reduction,reduction);
+      (*this).apply(x,b,res);
+      std::swap(_reduction,reduction);
+    }
+
+  private:
+    SeqScalarProduct<X> ssp;
+    LinearOperator<X,X>& _op;
+    InverseOperator<XF,XF>* _inner;
+    Preconditioner<XF,XF>* _prec;
+    ScalarProduct<X>& _sp;
+    double _reduction;
+    double _innerReduction;
+    int _maxit;
+    int _verbose;
+  };
+
+  /** @} end documentation */
+
+} // end namespace
+
+#endif
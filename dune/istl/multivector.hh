@@ -0,0 +1,219 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set et ts=4 sw=2 sts=2:
+#ifndef DUNE_MULTIVECTOR_HH
+#define DUNE_MULTIVECTOR_HH
+
+#include<cmath>
+#include<memory>
+
+#include "istlexception.hh"
+#include "bvector.hh"
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/common/ftraits.hh>
+
+/*! \file
+
+  \brief A block vector holding several vectors with interleaved storage.
+*/
+
+namespace Dune {
+
+  /**
+     @addtogroup ISTL_SPMV
+     @{
+  */
+
+  /**
+     \brief A block vector with k columns stored interleaved.
+
+     A BlockMultiVector represents k vectors of type BlockVector<B> at once.
+     Block i stores the i-th block of all k vectors as a dense
+     FieldMatrix with B::dimension rows and k columns, i.e. the entries of
+     the k vectors that belong to the same unknown are contiguous in memory.
+
+     With this layout a sparse matrix can be applied to all k vectors while
+     streaming the matrix only once, see BCRSMatrix::mvmulti. The methods
+     transposedMult, rightmultiplyadd and rightmultiply provide the
+     dense k x k kernels needed by block Krylov methods.
+
+     \tparam B The block type of the corresponding single vector, e.g.
+     FieldVector<double,n>.
+     \tparam k The number of columns (vectors).
+     \tparam A The allocator used for the blocks.
+  */
+  template<class B, int k,
+      class A=std::allocator<FieldMatrix<typename B::field_type,B::dimension,k> > >
+  class BlockMultiVector
+    : public BlockVector<FieldMatrix<typename B::field_type,B::dimension,k>,A>
+  {
+  public:
+    //! \brief The type of the base class.
+    typedef BlockVector<FieldMatrix<typename B::field_type,B::dimension,k>,A> Base;
+
+    //! \brief The type representing the field.
+    typedef typename B::field_type field_type;
+
+    //! \brief The real type of the field type.
+    typedef typename FieldTraits<field_type>::real_type real_type;
+
+    //! \brief The type of the blocks, i.e. one block of all columns.
+    typedef typename Base::block_type block_type;
+
+    //! \brief The type for the index access.
+    typedef typename Base::size_type size_type;
+
+    //! \brief The type of a single column.
+    typedef BlockVector<B> column_type;
+
+    //! \brief The type of the dense k x k coefficient matrices.
+    typedef FieldMatrix<field_type,k,k> coefficient_type;
+
+    //! \brief The type of vectors holding one value per column.
+    typedef FieldVector<real_type,k> column_norm_type;
+
+    enum {
+      //! \brief The number of rows of each block.
+      blocksize = B::dimension,
+      //! \brief The number of columns.
+      columns = k
+    };
+
+    //! \brief Makes empty multi vector.
+    BlockMultiVector()
+      : Base()
+    {}
+
+    //! \brief Makes multi vector with n blocks.
+    explicit BlockMultiVector(size_type n)
+      : Base(n)
+    {}
+
+    //! \brief copy constructor
+    BlockMultiVector(const BlockMultiVector& other)
+      : Base(other)
+    {}
+
+    //! \brief assignment
+    BlockMultiVector& operator=(const BlockMultiVector& other)
+    {
+      Base::operator=(other);
+      return *this;
+    }
+
+    //! \brief assign from scalar
+    BlockMultiVector& operator=(const field_type& f)
+    {
+      Base::operator=(f);
+      return *this;
+    }
+
+    /**
+     * @brief Copy a column into a single vector.
+     * @param c The index of the column.
+     * @param v The vector to store the column in. It is resized if needed.
+     */
+    void column(int c, column_type& v) const
+    {
+#ifdef DUNE_ISTL_WITH_CHECKING
+      if (c<0 || c>=k) DUNE_THROW(ISTLError,"column index out of range");
+#endif
+      if(v.N()!=this->N())
+        v.resize(this->N(), false);
+      for(size_type i=0; i<this->N(); ++i)
+        for(int r=0; r<blocksize; ++r)
+          v[i][r]=(*this)[i][r][c];
+    }
+
+    /**
+     * @brief Overwrite a column with a single vector.
+     * @param c The index of the column.
+     * @param v The vector holding the new values.
+     */
+    void setColumn(int c, const column_type& v)
+    {
+#ifdef DUNE_ISTL_WITH_CHECKING
+      if (c<0 || c>=k) DUNE_THROW(ISTLError,"column index out of range");
+      if (v.N()!=this->N()) DUNE_THROW(ISTLError,"vector size mismatch");
+#endif
+      for(size_type i=0; i<this->N(); ++i)
+        for(int r=0; r<blocksize; ++r)
+          (*this)[i][r][c]=v[i][r];
+    }
+
+    /**
+     * @brief Computes the k x k matrix \f$ C = X^H Y\f$ of all pairwise
+     * scalar products, where X is this multi vector.
+     *
+     * As for the scalar product of single vectors, the entries of X are
+     * conjugated for complex field types.
+     */
+    void transposedMult(const BlockMultiVector& y, coefficient_type& c) const
+    {
+#ifdef DUNE_ISTL_WITH_CHECKING
+      if (y.N()!=this->N()) DUNE_THROW(ISTLError,"vector size mismatch");
+#endif
+      c=0;
+      for(size_type i=0; i<this->N(); ++i){
+        const block_type& xi=(*this)[i];
+        const block_type& yi=y[i];
+        for(int r=0; r<blocksize; ++r)
+          for(int a=0; a<k; ++a)
+            c[a].axpy(conjugateComplex(xi[r][a]), yi[r]);
+      }
+    }
+
+    /**
+     * @brief Computes \f$ X \leftarrow X + Y C\f$ where X is this multi vector.
+     */
+    void rightmultiplyadd(const BlockMultiVector& y, const coefficient_type& c)
+    {
+#ifdef DUNE_ISTL_WITH_CHECKING
+      if (y.N()!=this->N()) DUNE_THROW(ISTLError,"vector size mismatch");
+#endif
+      for(size_type i=0; i<this->N(); ++i){
+        block_type& xi=(*this)[i];
+        const block_type& yi=y[i];
+        for(int r=0; r<blocksize; ++r)
+          for(int a=0; a<k; ++a)
+            xi[r].axpy(yi[r][a], c[a]);
+      }
+    }
+
+    /**
+     * @brief Computes \f$ X \leftarrow X C\f$ where X is this multi vector.
+     */
+    void rightmultiply(const coefficient_type& c)
+    {
+      typename block_type::row_type row;
+      for(size_type i=0; i<this->N(); ++i){
+        block_type& xi=(*this)[i];
+        for(int r=0; r<blocksize; ++r){
+          row=0;
+          for(int a=0; a<k; ++a)
+            row.axpy(xi[r][a], c[a]);
+          xi[r]=row;
+        }
+      }
+    }
+
+    /**
+     * @brief Computes the euclidean norms of all columns.
+     */
+    void columnNorms(column_norm_type& norms) const
+    {
+      norms=0;
+      for(size_type i=0; i<this->N(); ++i)
+        for(int r=0; r<blocksize; ++r)
+          for(int a=0; a<k; ++a)
+            norms[a]+=std::abs((*this)[i][r][a])*std::abs((*this)[i][r][a]);
+      for(int a=0; a<k; ++a)
+        norms[a]=std::sqrt(norms[a]);
+    }
+  };
+
+  /** @} end documentation */
+
+} // end namespace
+
+#endif
@@ -3,7 +3,9 @@
 #ifndef DUNE_OVERLAPPINGSCHWARZ_HH
 #define DUNE_OVERLAPPINGSCHWARZ_HH
 #include<cassert>
+#include<cstddef>
 #include<algorithm>
+#include<limits>
 #include<functional>
 #include<vector>
 #include<set>
@@ -13,6 +15,7 @@
 #include"superlu.hh"
 #include"bvector.hh"
 #include"bcrsmatrix.hh"
+#include"istlexception.hh"
 #include"ilusubdomainsolver.hh"
 
 namespace Dune
@@ -34,6 +37,9 @@ namespace Dune
   
   /**
    * @brief Initializer for SuperLU Matrices representing the subdomains.
+   *
+   * @deprecated SeqOverlappingSchwarz extracts the subdomain matrices
+   * directly and does not use this class anymore.
    */
   template<class I, class S, class D>
   class OverlappingSchwarzInitializer
@@ -53,7 +59,7 @@ namespace Dune
     
     OverlappingSchwarzInitializer(InitializerList& il,
                                   const IndexSet& indices,
-                                  const subdomain_vector& domains);
+                                  const subdomain_vector& domains) DUNE_DEPRECATED;
     
     
     void addRowNnz(const Iter& row);
@@ -1125,13 +1131,12 @@ namespace Dune
 #if HAVE_SUPERLU
   template<class T>
   template<class RowToDomain, class Solvers, class SubDomains>
-  std::size_t SeqOverlappingSchwarzAssembler<SuperLU<T> >::assembleLocalProblems(const RowToDomain& rowToDomain, 
+  std::size_t SeqOverlappingSchwarzAssembler<SuperLU<T> >::assembleLocalProblems(const RowToDomain&, 
                                                                                 const matrix_type& mat,
                                                                                 Solvers& solvers,
                                                                                 const SubDomains& subDomains,
                                                                                 bool onTheFly)
   {
-    typedef typename std::vector<SuperMatrixInitializer<matrix_type> >::iterator InitializerIterator;
     typedef typename SubDomains::const_iterator DomainIterator;
     typedef typename Solvers::iterator SolverIterator;
     std::size_t maxlength = 0;
@@ -1141,34 +1146,42 @@ namespace Dune
 	maxlength=std::max(maxlength, domain->size());
       maxlength*=mat[0].begin()->N();
     }else{
-      // initialize the initializers
-      DomainIterator domain=subDomains.begin();
-    
-      // Create the initializers list.
-      std::vector<SuperMatrixInitializer<matrix_type> > initializers(subDomains.size());    
-      
-      SolverIterator solver=solvers.begin();
-      for(InitializerIterator initializer=initializers.begin(); initializer!=initializers.end();
-	  ++initializer, ++solver, ++domain){
-	solver->mat.N_=SeqOverlappingSchwarzDomainSize<matrix_type>::size(*domain);
-	solver->mat.M_=SeqOverlappingSchwarzDomainSize<matrix_type>::size(*domain);
-	//solver->setVerbosity(true);
-	*initializer=SuperMatrixInitializer<matrix_type>(solver->mat);
+      typedef typename matrix_type::size_type size_type;
+      const std::ptrdiff_t domains=subDomains.size();
+
+      // Extract the subdomain matrices directly into the column
+      // storage of SuperLU. Each thread marks the rows of its current
+      // subdomain in its own workspace, which is reset after each domain.
+      // Exceptions must not leave the parallel region.
+#ifdef _OPENMP
+      DeferredException error;
+#pragma omp parallel
+#endif
+      {
+        std::vector<size_type> subMatrixIndex(mat.N(), std::numeric_limits<size_type>::max());
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+        for(std::ptrdiff_t d=0; d<domains; ++d){
+#ifdef _OPENMP
+          try{
+#endif
+            solvers[d].mat.setMatrix(mat, subDomains[d], subMatrixIndex);
+#ifdef _OPENMP
+          }catch(...){
+            error.store();
+          }
+#endif
+        }
       }
-
-      // Set up the supermatrices according to the subdomains
-      typedef OverlappingSchwarzInitializer<std::vector<SuperMatrixInitializer<matrix_type> >,
-	RowToDomain, SubDomains> Initializer;
-
-      Initializer initializer(initializers, rowToDomain, subDomains);
-      copyToSuperMatrix(initializer, mat);
+#ifdef _OPENMP
+      error.rethrow();
+#endif
       if(solvers.size()==1)
 	assert(solvers[0].mat==mat);
-    
-      /*    for(SolverIterator solver=solvers.begin(); solver!=solvers.end(); ++solver)
-	    dPrint_CompCol_Matrix("superlu", &static_cast<SuperMatrix&>(solver->mat)); */
       
-      // Calculate the LU decompositions
+      // Calculate the LU decompositions. SuperLU uses global state,
+      // therefore this is done sequentially.
       std::for_each(solvers.begin(), solvers.end(), std::mem_fun_ref(&SuperLU<matrix_type>::decompose));
       for(SolverIterator solver=solvers.begin(); solver!=solvers.end(); ++solver){
 	assert(solver->mat.N()==solver->mat.M());
@@ -1190,20 +1203,36 @@ namespace Dune
                                                                                                  bool onTheFly)
   {
     typedef typename SubDomains::const_iterator DomainIterator;
-    typedef typename Solvers::iterator SolverIterator;
     std::size_t maxlength = 0;
     
     if(onTheFly){
       for(DomainIterator domain=subDomains.begin();domain!=subDomains.end();++domain)
 	maxlength=std::max(maxlength, domain->size());
     }else{
-      // initialize the solvers of the local prolems.
-      SolverIterator solver=solvers.begin();
-      for(DomainIterator domain=subDomains.begin(); domain!=subDomains.end();
-          ++domain, ++solver){
-        solver->setSubMatrix(mat, *domain);
-	maxlength=std::max(maxlength, domain->size());
+      // initialize the solvers of the local prolems. They are independent
+      // of each other.
+      const std::ptrdiff_t domains=subDomains.size();
+#ifdef _OPENMP
+      // Exceptions must not leave the parallel region.
+      DeferredException error;
+#pragma omp parallel for schedule(dynamic)
+#endif
+      for(std::ptrdiff_t d=0; d<domains; ++d){
+#ifdef _OPENMP
+        try{
+#endif
+          solvers[d].setSubMatrix(mat, subDomains[d]);
+#ifdef _OPENMP
+        }catch(...){
+          error.store();
+        }
+#endif
       }
+#ifdef _OPENMP
+      error.rethrow();
+#endif
+      for(DomainIterator domain=subDomains.begin();domain!=subDomains.end();++domain)
+	maxlength=std::max(maxlength, domain->size());
     }
     
     return maxlength;
@@ -18,7 +18,9 @@
 
 #include<utility>
 #include<set>
+#include<vector>
 #include<algorithm>
+#include<cmath>
 #include<limits>
 #include<ostream>
 
@@ -1231,6 +1233,172 @@ namespace Dune
       void growIsolatedAggregate(const Vertex& vertex, const AggregatesMap<Vertex>& aggregates, const C& c);
     };
 
+    /**
+     * @brief Class for building the aggregates with several threads.
+     *
+     * The aggregation works in phases. Each phase computes a maximal
+     * independent set of distance two (MIS(2)) of the strong connection
+     * graph of the vertices not aggregated yet, using the randomized
+     * algorithm of N. Bell, S. Dalton and L. Olson, 'Exposing fine-grained
+     * parallelism in algebraic multigrid methods', SIAM J. Sci. Comput. 34,
+     * 2012. The vertices of the set become the roots of new aggregates.
+     * Then the unaggregated neighbours of each root are added to its
+     * aggregate and afterwards further layers of vertices join the
+     * neighbouring aggregate they are connected to most strongly.
+     *
+     * All passes over the vertices are data parallel and run with OpenMP
+     * if the code is compiled with OpenMP support. The result does not
+     * depend on the number of threads used.
+     *
+     * The aggregates honour maxAggregateSize(). The distance of each vertex
+     * to the root of its aggregate is at most maxDistance()/2, thus
+     * the distance between two vertices of an aggregate is at most
+     * maxDistance(). Finally aggregates smaller than minAggregateSize(),
+     * and at least those of only one vertex, are merged into the smallest
+     * strongly connected neighbouring aggregate if the result does not
+     * exceed maxAggregateSize(). Otherwise their vertices are distributed
+     * over the neighbouring aggregates if all of them find room. Merged
+     * aggregates may exceed the maximum distance. Aggregates whose
+     * neighbours are all too large to take them stay below the minimum
+     * size. maxConnectivity() is not used.
+     */
+    template<class G>
+    class MISAggregator
+    {
+    public:
+
+      /**
+       * @brief The matrix graph type used.
+       */
+      typedef G MatrixGraph;
+
+      /**
+       * @brief The vertex identifier
+       */
+      typedef typename MatrixGraph::VertexDescriptor Vertex;
+
+      /** @brief The type of the aggregate descriptor. */
+      typedef typename MatrixGraph::VertexDescriptor AggregateDescriptor;
+
+      /**
+       * @brief Build the aggregates.
+       *
+       * @see Aggregator::build
+       */
+      template<class M, class C>
+      tuple<int,int,int,int> build(const M& m, G& graph,
+                                   AggregatesMap<Vertex>& aggregates, const C& c,
+                                   bool finestLevel);
+    private:
+      /**
+       * @brief The states of a vertex during the computation of the
+       * independent set.
+       */
+      enum MISState { OUT=0, UNDECIDED=1, IN=2 };
+
+      /**
+       * @brief The random priority of a vertex used for finding
+       * the independent set.
+       */
+      struct Priority
+      {
+        char state;
+        unsigned int hash;
+        Vertex vertex;
+
+        bool operator<(const Priority& other) const
+        {
+          if(state!=other.state)
+            return state<other.state;
+          if(hash!=other.hash)
+            return hash<other.hash;
+          return vertex<other.vertex;
+        }
+      };
+
+      /**
+       * @brief Whether an edge is used for aggregation.
+       *
+       * Non isolated vertices are aggregated along strong connections,
+       * isolated vertices with their isolated neighbours.
+       */
+      bool connected(const G& graph, const Vertex& vertex,
+                     const typename G::ConstEdgeIterator& edge) const;
+
+      /** @brief Deterministic pseudo random number for a vertex. */
+      static unsigned int hash(const Vertex& vertex);
+
+      /**
+       * @brief Computes a maximal independent set of distance two.
+       *
+       * @param graph The graph.
+       * @param vertices The vertices of the graph.
+       * @param participating Flags marking the vertices of the subgraph
+       * to compute the set for.
+       * @param root Flags marking the vertices in the set on return.
+       */
+      void maximalIndependentSet(const G& graph, const std::vector<Vertex>& vertices,
+                                 const std::vector<char>& participating,
+                                 std::vector<char>& root) const;
+    };
+
+    /**
+     * @brief Class for building the aggregates by pairwise matching.
+     *
+     * The aggregation works in two passes similar to the double pairwise
+     * aggregation of Y. Notay, 'An aggregation-based algebraic multigrid
+     * method', Electron. Trans. Numer. Anal. 37, 2010. In the first pass
+     * each unaggregated vertex is paired with the unaggregated neighbour
+     * it is most strongly connected to. In the second pass the pairs are
+     * matched again, where the coupling of two pairs is the sum of the
+     * couplings of their vertices. This results in aggregates of at most
+     * four vertices.
+     *
+     * Only the strong connections found by the criterion are used. The
+     * coupling of a connection is the absolute value of the norm of the
+     * criterion applied to the matrix entry. The aggregates honour
+     * maxAggregateSize(), but neither the distance nor the connectivity
+     * parameters are used. Therefore the setup is much cheaper than with
+     * Aggregator, at the price of a slightly slower convergence.
+     */
+    template<class G>
+    class PairwiseAggregator
+    {
+    public:
+
+      /**
+       * @brief The matrix graph type used.
+       */
+      typedef G MatrixGraph;
+
+      /**
+       * @brief The vertex identifier
+       */
+      typedef typename MatrixGraph::VertexDescriptor Vertex;
+
+      /** @brief The type of the aggregate descriptor. */
+      typedef typename MatrixGraph::VertexDescriptor AggregateDescriptor;
+
+      /**
+       * @brief Build the aggregates.
+       *
+       * @see Aggregator::build
+       */
+      template<class M, class C>
+      tuple<int,int,int,int> build(const M& m, G& graph,
+                                   AggregatesMap<Vertex>& aggregates, const C& c,
+                                   bool finestLevel);
+    private:
+      /**
+       * @brief Whether an edge is used for aggregation.
+       *
+       * Non isolated vertices are aggregated along strong connections,
+       * isolated vertices with their isolated neighbours.
+       */
+      bool connected(const G& graph, const Vertex& vertex,
+                     const typename G::ConstEdgeIterator& edge) const;
+    };
+
 #ifndef DOXYGEN
 
     template<class M, class N>
@@ -2159,11 +2327,545 @@ namespace Dune
       }
     }
       
+    template<class G>
+    inline bool MISAggregator<G>::connected(const G& graph, const Vertex& vertex,
+                                            const typename G::ConstEdgeIterator& edge) const
+    {
+      const Vertex target = edge.target();
+      if(graph.getVertexProperties(target).excludedBorder())
+        return false;
+      if(graph.getVertexProperties(vertex).isolated())
+        return graph.getVertexProperties(target).isolated();
+      return !graph.getVertexProperties(target).isolated() && edge.properties().isStrong();
+    }
+
+    template<class G>
+    inline unsigned int MISAggregator<G>::hash(const Vertex& vertex)
+    {
+      unsigned int h = static_cast<unsigned int>(vertex);
+      h ^= h >> 16;
+      h *= 0x7feb352dU;
+      h ^= h >> 15;
+      h *= 0x846ca68bU;
+      h ^= h >> 16;
+      return h;
+    }
+
+    template<class G>
+    void MISAggregator<G>::maximalIndependentSet(const G& graph, const std::vector<Vertex>& vertices,
+                                                 const std::vector<char>& participating,
+                                                 std::vector<char>& root) const
+    {
+      typedef typename G::ConstEdgeIterator EdgeIterator;
+      const int nv = vertices.size();
+      std::vector<Priority> priority(root.size()), max1(root.size()), max2(root.size());
+
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for(int i=0; i<nv; ++i){
+        const Vertex v = vertices[i];
+        root[v] = false;
+        priority[v].state = participating[v] ? UNDECIDED : OUT;
+        priority[v].hash = hash(v);
+        priority[v].vertex = v;
+      }
+
+      int undecided = 1;
+      while(undecided>0){
+        // maximum priority in the neighbourhood of distance one
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i=0; i<nv; ++i){
+          const Vertex v = vertices[i];
+          if(!participating[v])
+            continue;
+          Priority m = priority[v];
+          const EdgeIterator end = graph.endEdges(v);
+          for(EdgeIterator edge = graph.beginEdges(v); edge != end; ++edge)
+            if(participating[edge.target()] && connected(graph, v, edge))
+              m = std::max(m, priority[edge.target()]);
+          max1[v] = m;
+        }
+        // and of distance two
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i=0; i<nv; ++i){
+          const Vertex v = vertices[i];
+          if(!participating[v])
+            continue;
+          Priority m = max1[v];
+          const EdgeIterator end = graph.endEdges(v);
+          for(EdgeIterator edge = graph.beginEdges(v); edge != end; ++edge)
+            if(participating[edge.target()] && connected(graph, v, edge))
+              m = std::max(m, max1[edge.target()]);
+          max2[v] = m;
+        }
+
+        undecided = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:undecided)
+#endif
+        for(int i=0; i<nv; ++i){
+          const Vertex v = vertices[i];
+          if(!participating[v] || priority[v].state!=UNDECIDED)
+            continue;
+          if(max2[v].vertex==v){
+            priority[v].state = IN;
+            root[v] = true;
+          }else if(max2[v].state==IN)
+            priority[v].state = OUT;
+          else
+            ++undecided;
+        }
+      }
+    }
+
+    template<class G>
+    template<class M, class C>
+    tuple<int,int,int,int> MISAggregator<G>::build(const M& m, G& graph, AggregatesMap<Vertex>& aggregates,
+                                                   const C& c, bool finestLevel)
+    {
+      typedef typename G::ConstEdgeIterator EdgeIterator;
+      typedef typename G::VertexIterator VertexIterator;
+      const Vertex unaggregated = AggregatesMap<Vertex>::UNAGGREGATED;
+      const Vertex isolated = AggregatesMap<Vertex>::ISOLATED;
+
+      Timer watch;
+      watch.reset();
+
+      buildDependency(graph, m, c, finestLevel);
+
+      dverb<<"Build dependency took "<< watch.elapsed()<<" seconds."<<std::endl;
+
+      // The vertices for index based loops
+      std::vector<Vertex> vertices;
+      vertices.reserve(graph.noVertices());
+      for(VertexIterator vertex = graph.begin(); vertex != graph.end(); ++vertex)
+        vertices.push_back(*vertex);
+      const int nv = vertices.size();
+      const std::size_t n = graph.maxVertex()+1;
+
+      const G& cgraph = graph;
+      const std::size_t radius = std::max<std::size_t>(1, c.maxDistance()/2);
+      const std::size_t maxSize = std::max<std::size_t>(1, c.maxAggregateSize());
+
+      // the distance to the root of the aggregate
+      std::vector<std::size_t> depth(n, 0);
+      // the size of the aggregates indexed by their root
+      std::vector<std::size_t> size(n, 0);
+      std::vector<char> participating(n, false), root(n, false);
+      std::vector<Vertex> proposal(n, unaggregated);
+
+      int skippedAggregates=0;
+      int left=0;
+      for(int i=0; i<nv; ++i){
+        const Vertex v = vertices[i];
+        if(graph.getVertexProperties(v).excludedBorder() ||
+           (graph.getVertexProperties(v).isolated() && c.skipIsolated())){
+          aggregates[v] = isolated;
+          ++skippedAggregates;
+        }else
+          ++left;
+      }
+
+      while(left>0){
+        // compute the roots of the new aggregates
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i=0; i<nv; ++i)
+          participating[vertices[i]] = (aggregates[vertices[i]]==unaggregated);
+
+        maximalIndependentSet(cgraph, vertices, participating, root);
+
+        // add the neighbours of the roots. As the roots have at least
+        // distance three, no vertex is a neighbour of two roots.
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+        for(int i=0; i<nv; ++i){
+          const Vertex v = vertices[i];
+          if(!root[v])
+            continue;
+          aggregates[v] = v;
+          depth[v] = 0;
+          size[v] = 1;
+          const EdgeIterator end = cgraph.endEdges(v);
+          for(EdgeIterator edge = cgraph.beginEdges(v); edge != end && size[v]<maxSize; ++edge)
+            if(aggregates[edge.target()]==unaggregated && participating[edge.target()]
+               && connected(cgraph, v, edge)){
+              aggregates[edge.target()] = v;
+              depth[edge.target()] = 1;
+              ++size[v];
+            }
+        }
+
+        // add further layers to the aggregates
+        for(std::size_t layer=2; layer<=radius; ++layer){
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+          for(int i=0; i<nv; ++i){
+            const Vertex v = vertices[i];
+            proposal[v] = unaggregated;
+            if(aggregates[v]!=unaggregated)
+              continue;
+            // the aggregate with the most connections
+            int best = 0;
+            const EdgeIterator end = cgraph.endEdges(v);
+            for(EdgeIterator edge = cgraph.beginEdges(v); edge != end; ++edge){
+              const Vertex a = aggregates[edge.target()];
+              if(a==unaggregated || a==isolated || depth[edge.target()]+1!=layer
+                 || size[a]>=maxSize || !connected(cgraph, v, edge))
+                continue;
+              int count = 0;
+              for(EdgeIterator other = cgraph.beginEdges(v); other != end; ++other)
+                if(aggregates[other.target()]==a && connected(cgraph, v, other))
+                  ++count;
+              if(count>best || (count==best && a<proposal[v])){
+                best = count;
+                proposal[v] = a;
+              }
+            }
+          }
+          // accept in a fixed order to respect the maximum size
+          for(int i=0; i<nv; ++i){
+            const Vertex v = vertices[i];
+            const Vertex a = proposal[v];
+            if(a!=unaggregated && size[a]<maxSize){
+              aggregates[v] = a;
+              depth[v] = layer;
+              ++size[a];
+            }
+          }
+        }
+
+        left = 0;
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+:left)
+#endif
+        for(int i=0; i<nv; ++i)
+          if(aggregates[vertices[i]]==unaggregated)
+            ++left;
+      }
+
+      // Merge aggregates smaller than the minimum size (at least those
+      // consisting of only one nonisolated vertex) into the smallest
+      // strongly connected neighbouring aggregate, preferring more
+      // connections, as long as the maximum size is not exceeded.
+      const std::size_t minSize = std::max<std::size_t>(2, c.minAggregateSize());
+      if(maxSize>1){
+        const std::size_t none = std::numeric_limits<std::size_t>::max();
+        std::vector<Vertex> smallRoots;
+        std::vector<std::size_t> smallIndex(n, none);
+        for(int i=0; i<nv; ++i){
+          const Vertex v = vertices[i];
+          if(aggregates[v]==v && size[v]<minSize && !graph.getVertexProperties(v).isolated()){
+            smallIndex[v] = smallRoots.size();
+            smallRoots.push_back(v);
+          }
+        }
+        std::vector<std::vector<Vertex> > members(smallRoots.size());
+        for(int i=0; i<nv; ++i){
+          const Vertex a = aggregates[vertices[i]];
+          if(a!=isolated && a!=unaggregated && smallIndex[a]!=none)
+            members[smallIndex[a]].push_back(vertices[i]);
+        }
+
+        std::vector<int> connections(n, 0);
+        std::vector<Vertex> neighbours;
+        for(std::size_t k=0; k<smallRoots.size(); ++k){
+          const Vertex a = smallRoots[k];
+          if(size[a]==0 || size[a]>=minSize)
+            // merged away or grown big enough meanwhile
+            continue;
+          // count the strong connections to the neighbouring aggregates
+          neighbours.clear();
+          for(typename std::vector<Vertex>::const_iterator v=members[k].begin();
+              v!=members[k].end(); ++v){
+            const EdgeIterator end = cgraph.endEdges(*v);
+            for(EdgeIterator edge = cgraph.beginEdges(*v); edge != end; ++edge){
+              const Vertex b = aggregates[edge.target()];
+              if(b==a || b==isolated || b==unaggregated || !connected(cgraph, *v, edge))
+                continue;
+              if(connections[b]==0)
+                neighbours.push_back(b);
+              ++connections[b];
+            }
+          }
+          Vertex target = unaggregated;
+          int best = 0;
+          for(typename std::vector<Vertex>::const_iterator b=neighbours.begin();
+              b!=neighbours.end(); ++b){
+            if(size[*b]+size[a]<=maxSize &&
+               (target==unaggregated || size[*b]<size[target] ||
+                (size[*b]==size[target] && connections[*b]>best))){
+              best = connections[*b];
+              target = *b;
+            }
+            connections[*b] = 0;
+          }
+          if(target==unaggregated){
+            // No neighbour can take the whole aggregate. Try to
+            // distribute its vertices individually.
+            std::vector<Vertex> targets;
+            for(typename std::vector<Vertex>::const_iterator v=members[k].begin();
+                v!=members[k].end(); ++v){
+              Vertex t = unaggregated;
+              const EdgeIterator end = cgraph.endEdges(*v);
+              for(EdgeIterator edge = cgraph.beginEdges(*v); edge != end; ++edge){
+                const Vertex b = aggregates[edge.target()];
+                if(b!=a && b!=isolated && b!=unaggregated && size[b]<maxSize
+                   && connected(cgraph, *v, edge) && (t==unaggregated || size[b]<size[t]))
+                  t = b;
+              }
+              if(t==unaggregated)
+                break;
+              targets.push_back(t);
+              ++size[t];
+            }
+            if(targets.size()<members[k].size()){
+              // undo the reservations
+              for(typename std::vector<Vertex>::const_iterator t=targets.begin(); t!=targets.end(); ++t)
+                --size[*t];
+              continue;
+            }
+            for(std::size_t j=0; j<targets.size(); ++j){
+              aggregates[members[k][j]] = targets[j];
+              if(smallIndex[targets[j]]!=none)
+                members[smallIndex[targets[j]]].push_back(members[k][j]);
+            }
+            std::vector<Vertex>().swap(members[k]);
+            size[a] = 0;
+            continue;
+          }
+
+          for(typename std::vector<Vertex>::const_iterator v=members[k].begin();
+              v!=members[k].end(); ++v)
+            aggregates[*v] = target;
+          if(smallIndex[target]!=none){
+            std::vector<Vertex>& targetMembers = members[smallIndex[target]];
+            targetMembers.insert(targetMembers.end(), members[k].begin(), members[k].end());
+          }
+          std::vector<Vertex>().swap(members[k]);
+          size[target] += size[a];
+          size[a] = 0;
+        }
+      }
+
+      int conAggregates=0, isoAggregates=0, oneAggregates=0;
+      std::size_t maxA=0, minA=1000000, avg=0;
+      for(int i=0; i<nv; ++i){
+        const Vertex v = vertices[i];
+        if(aggregates[v]!=v || size[v]==0)
+          continue;
+        if(graph.getVertexProperties(v).isolated())
+          ++isoAggregates;
+        else
+          ++conAggregates;
+        if(size[v]==1)
+          ++oneAggregates;
+        avg+=size[v];
+        minA=std::min(minA,size[v]);
+        maxA=std::max(maxA,size[v]);
+      }
+
+      Dune::dinfo<<"connected aggregates: "<<conAggregates;
+      Dune::dinfo<<" isolated aggregates: "<<isoAggregates;
+      if(conAggregates+isoAggregates>0)
+        Dune::dinfo<<" one node aggregates: "<<oneAggregates<<" min size="
+                   <<minA<<" max size="<<maxA
+                   <<" avg="<<avg/(conAggregates+isoAggregates)<<std::endl;
+
+      return make_tuple(conAggregates+isoAggregates,isoAggregates,
+			oneAggregates,skippedAggregates);
+    }
+
+    template<class G>
+    inline bool PairwiseAggregator<G>::connected(const G& graph, const Vertex& vertex,
+                                                 const typename G::ConstEdgeIterator& edge) const
+    {
+      const Vertex target = edge.target();
+      if(graph.getVertexProperties(target).excludedBorder())
+        return false;
+      if(graph.getVertexProperties(vertex).isolated())
+        return graph.getVertexProperties(target).isolated();
+      return !graph.getVertexProperties(target).isolated() && edge.properties().isStrong();
+    }
+
+    template<class G>
+    template<class M, class C>
+    tuple<int,int,int,int> PairwiseAggregator<G>::build(const M& m, G& graph, AggregatesMap<Vertex>& aggregates,
+                                                        const C& c, bool finestLevel)
+    {
+      typedef typename G::ConstEdgeIterator EdgeIterator;
+      typedef typename G::VertexIterator VertexIterator;
+      typedef typename M::ConstColIterator ColIterator;
+      typedef typename M::field_type field_type;
+      const Vertex unaggregated = AggregatesMap<Vertex>::UNAGGREGATED;
+      const Vertex isolated = AggregatesMap<Vertex>::ISOLATED;
+
+      Timer watch;
+      watch.reset();
+
+      buildDependency(graph, m, c, finestLevel);
+
+      dverb<<"Build dependency took "<< watch.elapsed()<<" seconds."<<std::endl;
+
+      const G& cgraph = graph;
+      const std::size_t n = graph.maxVertex()+1;
+      const std::size_t maxSize = std::max<std::size_t>(1, c.maxAggregateSize());
+      typename C::Norm norm;
+
+      // The vertices and the couplings along the connections used
+      std::vector<Vertex> vertices;
+      vertices.reserve(graph.noVertices());
+      std::vector<std::pair<Vertex,field_type> > couplings;
+      couplings.reserve(graph.noEdges());
+      std::vector<std::size_t> first(n, 0), last(n, 0);
+
+      int skippedAggregates=0;
+      for(VertexIterator vertex = graph.begin(); vertex != graph.end(); ++vertex){
+        const Vertex v = *vertex;
+        vertices.push_back(v);
+        if(graph.getVertexProperties(v).excludedBorder() ||
+           (graph.getVertexProperties(v).isolated() && c.skipIsolated())){
+          aggregates[v] = isolated;
+          ++skippedAggregates;
+          continue;
+        }
+        first[v] = couplings.size();
+        ColIterator col = m[v].begin();
+        const EdgeIterator end = cgraph.endEdges(v);
+        for(EdgeIterator edge = cgraph.beginEdges(v); edge != end; ++edge)
+          if(connected(cgraph, v, edge)){
+            // Move to the right column.
+            while(col.index()!=edge.target())
+              ++col;
+            couplings.push_back(std::make_pair(edge.target(), std::abs(norm(*col))));
+          }
+        last[v] = couplings.size();
+      }
+      const int nv = vertices.size();
+
+      // the size of the aggregates indexed by their root
+      std::vector<std::size_t> size(n, 0);
+      // the vertex matched with the root in the first pass
+      std::vector<Vertex> partner(n, unaggregated);
+
+      // first pass: match the vertices
+      for(int i=0; i<nv; ++i){
+        const Vertex v = vertices[i];
+        if(aggregates[v]!=unaggregated)
+          continue;
+        aggregates[v] = v;
+        size[v] = 1;
+        if(maxSize<2)
+          continue;
+        field_type max = 0;
+        for(std::size_t k=first[v]; k<last[v]; ++k)
+          if(aggregates[couplings[k].first]==unaggregated &&
+             (partner[v]==unaggregated || couplings[k].second>max)){
+            partner[v] = couplings[k].first;
+            max = couplings[k].second;
+          }
+        if(partner[v]!=unaggregated){
+          aggregates[partner[v]] = v;
+          size[v] = 2;
+        }
+      }
+
+      // second pass: match the pairs
+      if(maxSize>2){
+        std::vector<field_type> weight(n, 0);
+        std::vector<char> marked(n, false), matched(n, false);
+        std::vector<Vertex> neighbours;
+        for(int i=0; i<nv; ++i){
+          const Vertex v = vertices[i];
+          if(aggregates[v]!=v || matched[v])
+            continue;
+          matched[v] = true;
+
+          // sum up the couplings to the neighbouring pairs
+          neighbours.clear();
+          for(int j=0; j<2; ++j){
+            const Vertex u = j==0 ? v : partner[v];
+            if(u==unaggregated)
+              continue;
+            for(std::size_t k=first[u]; k<last[u]; ++k){
+              const Vertex a = aggregates[couplings[k].first];
+              if(a==isolated || matched[a] || size[v]+size[a]>maxSize)
+                continue;
+              if(!marked[a]){
+                marked[a] = true;
+                weight[a] = 0;
+                neighbours.push_back(a);
+              }
+              weight[a] += couplings[k].second;
+            }
+          }
+
+          Vertex best = unaggregated;
+          for(typename std::vector<Vertex>::const_iterator a = neighbours.begin();
+              a != neighbours.end(); ++a){
+            marked[*a] = false;
+            if(best==unaggregated || weight[*a]>weight[best])
+              best = *a;
+          }
+          if(best!=unaggregated){
+            aggregates[best] = v;
+            if(partner[best]!=unaggregated)
+              aggregates[partner[best]] = v;
+            size[v] += size[best];
+            matched[best] = true;
+          }
+        }
+      }
+
+      int conAggregates=0, isoAggregates=0, oneAggregates=0;
+      std::size_t maxA=0, minA=1000000, avg=0;
+      for(int i=0; i<nv; ++i){
+        const Vertex v = vertices[i];
+        if(aggregates[v]!=v)
+          continue;
+        if(graph.getVertexProperties(v).isolated())
+          ++isoAggregates;
+        else
+          ++conAggregates;
+        if(size[v]==1)
+          ++oneAggregates;
+        avg+=size[v];
+        minA=std::min(minA,size[v]);
+        maxA=std::max(maxA,size[v]);
+      }
+
+      Dune::dinfo<<"connected aggregates: "<<conAggregates;
+      Dune::dinfo<<" isolated aggregates: "<<isoAggregates;
+      if(conAggregates+isoAggregates>0)
+        Dune::dinfo<<" one node aggregates: "<<oneAggregates<<" min size="
+                   <<minA<<" max size="<<maxA
+                   <<" avg="<<avg/(conAggregates+isoAggregates)<<std::endl;
+
+      return make_tuple(conAggregates+isoAggregates,isoAggregates,
+			oneAggregates,skippedAggregates);
+    }
+
     template<typename V>
     template<typename M, typename G, typename C>
     tuple<int,int,int,int> AggregatesMap<V>::buildAggregates(const M& matrix, G& graph, const C& criterion,
                                                              bool finestLevel)
     {
+      if(criterion.aggregationAlgorithm()==misAggregation){
+        MISAggregator<G> aggregator;
+        return aggregator.build(matrix, graph, *this, criterion, finestLevel);
+      }
+      if(criterion.aggregationAlgorithm()==pairwiseAggregation){
+        PairwiseAggregator<G> aggregator;
+        return aggregator.build(matrix, graph, *this, criterion, finestLevel);
+      }
       Aggregator<G> aggregator;
       return aggregator.build(matrix, graph, *this, criterion, finestLevel);
     }
@@ -3,11 +3,17 @@
 #define DUNE_AMG_AMG_HH
 
 #include<memory>
+#include<vector>
+#ifdef _OPENMP
+#include<omp.h>
+#endif
 #include<dune/common/exceptions.hh>
 #include<dune/istl/paamg/smoother.hh>
 #include<dune/istl/paamg/transfer.hh>
 #include<dune/istl/paamg/hierarchy.hh>
+#include<dune/istl/paamg/replicatedcoarsesolver.hh>
 #include<dune/istl/solvers.hh>
+#include<dune/istl/istlexception.hh>
 #include<dune/istl/scalarproducts.hh>
 #include<dune/istl/superlu.hh>
 #include<dune/istl/solvertype.hh>
@@ -122,6 +128,9 @@ namespace Dune
        * @param smootherArgs The  arguments needed for thesmoother to use 
        * for pre and post smoothing.
        * @param parms The parameters for the AMG.
+       *
+       * The given coarse solver is always used. Parameters::getReplicatedCoarseSolve()
+       * is ignored, as the coarse solver is not set up by the AMG.
        */
       AMG(const OperatorHierarchy& matrices, CoarseSolver& coarseSolver, 
 	  const SmootherArgs& smootherArgs, const Parameters& parms);
@@ -168,8 +177,36 @@ namespace Dune
 	  const SmootherArgs& smootherArgs,
           const ParallelInformation& pinfo=ParallelInformation());
 
+      /**
+       * @brief Construct an AMG from a matrix hierarchy saved with saveHierarchy.
+       *
+       * Aggregation and the Galerkin products are skipped, the coarse levels
+       * are read from the stream. As coarse solver the same solver is used as
+       * for a hierarchy built automatically.
+       * @param fineOperator The operator on the fine level. It has to be the
+       * one the saved hierarchy was built for.
+       * @param hierarchy The stream to read the hierarchy from.
+       * @param smootherArgs The arguments for constructing the smoothers.
+       * @param parms The parameters for the AMG.
+       * @param pinfo The information about the parallel distribution of the data.
+       */
+      AMG(const Operator& fineOperator, std::istream& hierarchy,
+          const SmootherArgs& smootherArgs, const Parameters& parms,
+          const ParallelInformation& pinfo=ParallelInformation());
+
       ~AMG();
 
+      /**
+       * @brief Save the matrix hierarchy to a binary stream.
+       *
+       * In parallel each process saves its own part.
+       * @see MatrixHierarchy::save
+       */
+      void saveHierarchy(std::ostream& os) const
+      {
+        matrices_->save(os);
+      }
+
       /** \copydoc Preconditioner::pre */
       void pre(Domain& x, Range& b);
 
@@ -196,11 +233,39 @@ namespace Dune
        * It is assumed that the coarsening for the changed fine level
        * matrix would yield the same aggregates. In this case it suffices
        * to recalculate all the Galerkin products for the matrices of the 
-       * coarser levels.
+       * coarser levels. The smoothers are set up again for the new values.
+       * Must not be called between pre and post.
        */
       void recalculateHierarchy()
       {
         matrices_->recalculateGalerkin(NegateSet<typename PI::OwnerSet>());
+        for(std::size_t l=0; l<statistics_.levels.size(); ++l)
+          statistics_.levels[l].galerkinTime = matrices_->statistics().levels[l].galerkinTime;
+        smoothers_.clear();
+        matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
+      }
+
+      /**
+       * @brief Rebuild the matrix hierarchy from scratch.
+       *
+       * In contrast to recalculateHierarchy the aggregation is done
+       * again for the current values of the fine level matrix. The
+       * level parameters are taken from the criterion. Only
+       * possible if the hierarchy was built by the AMG. Must not be
+       * called between pre and post.
+       * @param criterion The criterion describing the coarsening strategy.
+       */
+      template<class C>
+      void rebuildHierarchy(const C& criterion);
+
+      /**
+       * @brief Get the statistics about the setup and the cycles.
+       *
+       * The cycle data is accumulated since the last call to pre.
+       */
+      const AMGStatistics& statistics() const
+      {
+        return statistics_;
       }
 
       /**
@@ -210,14 +275,54 @@ namespace Dune
       bool usesDirectCoarseLevelSolver() const;
       
     private:
+      /** @brief The kind of multigrid cycle done on a level. */
+      enum CycleMode{
+        /** @brief Visit the coarser level once. */
+        vCycle,
+        /** @brief Visit the coarser level gamma_ times. */
+        gammaCycle,
+        /** @brief Visit the coarser level with an F-cycle and then a V-cycle. */
+        fCycle
+      };
+
       /** @brief Multigrid cycle on a level. */
-      void mgc();
+      void mgc()
+      {
+        mgc(fCycle_ ? fCycle : gammaCycle);
+      }
+
+      /**
+       * @brief Multigrid cycle on a level.
+       * @param mode The kind of cycle to do.
+       */
+      void mgc(CycleMode mode);
+
+      /**
+       * @brief Store the smoothing parameters of each level.
+       *
+       * Has to be called after the matrix hierarchy was built.
+       */
+      void setupLevelParameters(const Parameters& parms);
+
+      /** @brief Get the number of presmoothing steps on a level. */
+      std::size_t preSteps(std::size_t l) const
+      {
+        return l<levelPreSteps_.size() ? levelPreSteps_[l] : preSteps_;
+      }
+
+      /** @brief Get the number of postsmoothing steps on a level. */
+      std::size_t postSteps(std::size_t l) const
+      {
+        return l<levelPostSteps_.size() ? levelPostSteps_[l] : postSteps_;
+      }
 
       typename Hierarchy<Smoother,A>::Iterator smoother;
       typename OperatorHierarchy::ParallelMatrixHierarchy::ConstIterator matrix;
       typename ParallelInformationHierarchy::Iterator pinfo;
       typename OperatorHierarchy::RedistributeInfoList::const_iterator redist;
       typename OperatorHierarchy::AggregatesMapList::const_iterator aggregates;
+      typename OperatorHierarchy::ProlongationList::const_iterator prolongation;
+      typename OperatorHierarchy::TransferOperatorList::const_iterator transfer;
       typename Hierarchy<Domain,A>::Iterator lhs;
       typename Hierarchy<Domain,A>::Iterator update;
       typename Hierarchy<Range,A>::Iterator rhs;
@@ -241,6 +346,32 @@ namespace Dune
       /** @brief Initialize iterators over levels with fine level */
       void initIteratorsWithFineLevel();
 
+      /**
+       * @brief Restrict a defect to the next coarser level.
+       *
+       * Uses the explicit transfer operator if there is one, else the
+       * prolongation matrix if there is one (smoothed aggregation), and
+       * the aggregates otherwise.
+       */
+      void restrictDefect(const typename OperatorHierarchy::AggregatesMap& aggregates,
+                          const typename M::matrix_type* prolongation,
+                          const typename OperatorHierarchy::TransferOperator* transfer,
+                          Range& coarse, const Range& fine, ParallelInformation& info);
+
+      /**
+       * @brief Prolongate a correction from the next coarser level and add it.
+       *
+       * Uses the explicit transfer operator if there is one, else the
+       * prolongation matrix if there is one (smoothed aggregation), and
+       * the aggregates otherwise. The damping factor is not applied for
+       * smoothed aggregation.
+       */
+      void prolongateCorrection(const typename OperatorHierarchy::AggregatesMap& aggregates,
+                                const typename M::matrix_type* prolongation,
+                                const typename OperatorHierarchy::TransferOperator* transfer,
+                                Domain& coarse, Domain& fine,
+                                typename M::field_type damp, ParallelInformation& info);
+
       /**  @brief The matrix we solve. */
       OperatorHierarchy* matrices_;
       /** @brief The arguments to construct the smoother */
@@ -267,13 +398,27 @@ namespace Dune
       std::size_t preSteps_;
       /** @brief The number of postsmoothing steps. */
       std::size_t postSteps_;
+      /** @brief Whether to use F-cycles instead of gamma_. */
+      bool fCycle_;
+      /** @brief The number of presmoothing steps of each level. */
+      std::vector<std::size_t> levelPreSteps_;
+      /** @brief The number of postsmoothing steps of each level. */
+      std::vector<std::size_t> levelPostSteps_;
+      /** @brief The arguments for the smoothers of each level. */
+      std::vector<SmootherArgs> levelSmootherArgs_;
       std::size_t level;
       bool buildHierarchy_;
       bool additive;
+      /** @brief Whether the coarsest system should be solved on every process. */
+      bool replicateCoarseSolve_;
+      /** @brief Whether solver_ solves the gathered coarsest system. */
+      bool replicatedCoarseSolver_;
       bool coarsesolverconverged;
       Smoother *coarseSmoother_;
       /** @brief The verbosity level. */
       std::size_t verbosity_;
+      /** @brief The statistics about the setup and the cycles. */
+      AMGStatistics statistics_;
     };
 
     template<class M, class X, class S, class PI, class A>
@@ -283,14 +428,17 @@ namespace Dune
 			std::size_t postSmoothingSteps, bool additive_)
       : matrices_(&matrices), smootherArgs_(smootherArgs),
 	smoothers_(), solver_(&coarseSolver), scalarProduct_(0),
-	gamma_(gamma), preSteps_(preSmoothingSteps), postSteps_(postSmoothingSteps), buildHierarchy_(false),
-	additive(additive_), coarsesolverconverged(true),
+	gamma_(gamma), preSteps_(preSmoothingSteps), postSteps_(postSmoothingSteps), fCycle_(false),
+	levelSmootherArgs_(1, smootherArgs), buildHierarchy_(false),
+	additive(additive_), replicateCoarseSolve_(false),
+	replicatedCoarseSolver_(false), coarsesolverconverged(true),
 	coarseSmoother_(), verbosity_(2)
     {
       assert(matrices_->isBuilt());
       
       // build the necessary smoother hierarchies
-      matrices_->coarsenSmoother(smoothers_, smootherArgs_);
+      statistics_ = matrices_->statistics();
+      matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
     }
 
     template<class M, class X, class S, class PI, class A>
@@ -300,14 +448,17 @@ namespace Dune
       : matrices_(&matrices), smootherArgs_(smootherArgs),
 	smoothers_(), solver_(&coarseSolver), scalarProduct_(0),
 	gamma_(parms.getGamma()), preSteps_(parms.getNoPreSmoothSteps()), 
-        postSteps_(parms.getNoPostSmoothSteps()), buildHierarchy_(false),
-	additive(parms.getAdditive()), coarsesolverconverged(true),
+        postSteps_(parms.getNoPostSmoothSteps()), fCycle_(parms.getFCycle()), buildHierarchy_(false),
+	additive(parms.getAdditive()), replicateCoarseSolve_(false),
+	replicatedCoarseSolver_(false), coarsesolverconverged(true),
 	coarseSmoother_(), verbosity_(parms.debugLevel())
     {
       assert(matrices_->isBuilt());
       
       // build the necessary smoother hierarchies
-      matrices_->coarsenSmoother(smoothers_, smootherArgs_);
+      statistics_ = matrices_->statistics();
+      setupLevelParameters(parms);
+      matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
     }
 
     template<class M, class X, class S, class PI, class A>
@@ -321,8 +472,10 @@ namespace Dune
 			const PI& pinfo)
       : smootherArgs_(smootherArgs),
 	smoothers_(), solver_(), scalarProduct_(0), gamma_(gamma),
-	preSteps_(preSmoothingSteps), postSteps_(postSmoothingSteps), buildHierarchy_(true),
-	additive(additive_), coarsesolverconverged(true),
+	preSteps_(preSmoothingSteps), postSteps_(postSmoothingSteps), fCycle_(false),
+	levelSmootherArgs_(1, smootherArgs), buildHierarchy_(true),
+	additive(additive_), replicateCoarseSolve_(false),
+	replicatedCoarseSolver_(false), coarsesolverconverged(true),
 	coarseSmoother_(), verbosity_(criterion.debugLevel())
     {
       dune_static_assert(static_cast<int>(M::category)==static_cast<int>(S::category),
@@ -336,7 +489,8 @@ namespace Dune
       matrices_->template build<NegateSet<typename PI::OwnerSet> >(criterion);
       
       // build the necessary smoother hierarchies
-      matrices_->coarsenSmoother(smoothers_, smootherArgs_);
+      statistics_ = matrices_->statistics();
+      matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
 
       if(verbosity_>0 && matrices_->parallelInformation().finest()->communicator().rank()==0)
 	std::cout<<"Building Hierarchy of "<<matrices_->maxlevels()<<" levels took "<<watch.elapsed()<<" seconds."<<std::endl;
@@ -351,8 +505,9 @@ namespace Dune
       : smootherArgs_(smootherArgs),
 	smoothers_(), solver_(), scalarProduct_(0), 
         gamma_(criterion.getGamma()), preSteps_(criterion.getNoPreSmoothSteps()), 
-        postSteps_(criterion.getNoPostSmoothSteps()), buildHierarchy_(true),
-	additive(criterion.getAdditive()), coarsesolverconverged(true),
+        postSteps_(criterion.getNoPostSmoothSteps()), fCycle_(criterion.getFCycle()), buildHierarchy_(true),
+	additive(criterion.getAdditive()), replicateCoarseSolve_(criterion.getReplicatedCoarseSolve()),
+	replicatedCoarseSolver_(false), coarsesolverconverged(true),
 	coarseSmoother_(), verbosity_(criterion.debugLevel())
     {
       dune_static_assert(static_cast<int>(M::category)==static_cast<int>(S::category),
@@ -366,12 +521,84 @@ namespace Dune
       matrices_->template build<NegateSet<typename PI::OwnerSet> >(criterion);
       
       // build the necessary smoother hierarchies
-      matrices_->coarsenSmoother(smoothers_, smootherArgs_);
+      statistics_ = matrices_->statistics();
+      setupLevelParameters(criterion);
+      matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
 
       if(verbosity_>0 && matrices_->parallelInformation().finest()->communicator().rank()==0)
 	std::cout<<"Building Hierarchy of "<<matrices_->maxlevels()<<" levels took "<<watch.elapsed()<<" seconds."<<std::endl;
     }
     
+    template<class M, class X, class S, class PI, class A>
+    AMG<M,X,S,PI,A>::AMG(const Operator& matrix,
+                         std::istream& hierarchy,
+                         const SmootherArgs& smootherArgs,
+                         const Parameters& parms,
+			const PI& pinfo)
+      : smootherArgs_(smootherArgs),
+	smoothers_(), solver_(), scalarProduct_(0), 
+        gamma_(parms.getGamma()), preSteps_(parms.getNoPreSmoothSteps()), 
+        postSteps_(parms.getNoPostSmoothSteps()), fCycle_(parms.getFCycle()), buildHierarchy_(true),
+	additive(parms.getAdditive()), replicateCoarseSolve_(parms.getReplicatedCoarseSolve()),
+	replicatedCoarseSolver_(false), coarsesolverconverged(true),
+	coarseSmoother_(), verbosity_(parms.debugLevel())
+    {
+      dune_static_assert(static_cast<int>(M::category)==static_cast<int>(S::category),
+			 "Matrix and Solver must match in terms of category!");
+      Timer watch;
+      matrices_ = new OperatorHierarchy(const_cast<Operator&>(matrix), pinfo);
+            
+      matrices_->load(hierarchy);
+      
+      // build the necessary smoother hierarchies
+      statistics_ = matrices_->statistics();
+      setupLevelParameters(parms);
+      matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
+
+      if(verbosity_>0 && matrices_->parallelInformation().finest()->communicator().rank()==0)
+	std::cout<<"Loading Hierarchy of "<<matrices_->maxlevels()<<" levels took "<<watch.elapsed()<<" seconds."<<std::endl;
+    }
+    
+    template<class M, class X, class S, class PI, class A>
+    template<class C>
+    void AMG<M,X,S,PI,A>::rebuildHierarchy(const C& criterion)
+    {
+      if(!buildHierarchy_)
+        DUNE_THROW(ISTLError, "Only a hierarchy built by the AMG can be rebuilt!");
+      Timer watch;
+      // The fine level is owned by the user and survives the hierarchy
+      const Operator& matrix = *matrices_->matrices().finest();
+      const PI& pinfo = *matrices_->parallelInformation().finest();
+      smoothers_.clear();
+      delete matrices_;
+      matrices_ = new OperatorHierarchy(const_cast<Operator&>(matrix), pinfo);
+
+      matrices_->template build<NegateSet<typename PI::OwnerSet> >(criterion);
+
+      statistics_ = matrices_->statistics();
+      setupLevelParameters(criterion);
+      matrices_->coarsenSmoother(smoothers_, levelSmootherArgs_, &statistics_);
+
+      if(verbosity_>0 && matrices_->parallelInformation().finest()->communicator().rank()==0)
+	std::cout<<"Rebuilding Hierarchy of "<<matrices_->maxlevels()<<" levels took "<<watch.elapsed()<<" seconds."<<std::endl;
+    }
+
+    template<class M, class X, class S, class PI, class A>
+    void AMG<M,X,S,PI,A>::setupLevelParameters(const Parameters& parms)
+    {
+      levelPreSteps_.clear();
+      levelPostSteps_.clear();
+      levelSmootherArgs_.clear();
+      for(std::size_t l=0; l<matrices_->levels(); ++l){
+        levelPreSteps_.push_back(parms.getNoPreSmoothSteps(l));
+        levelPostSteps_.push_back(parms.getNoPostSmoothSteps(l));
+        SmootherArgs args(smootherArgs_);
+        if(parms.getRelaxationFactor(l)>0)
+          args.relaxationFactor=parms.getRelaxationFactor(l);
+        levelSmootherArgs_.push_back(args);
+      }
+    }
+
     template<class M, class X, class S, class PI, class A>
     AMG<M,X,S,PI,A>::~AMG()
     {
@@ -456,8 +683,10 @@ namespace Dune
       x = *lhs_->finest();
       b = *rhs_->finest();
       
+      statistics_.clearSolveStatistics();
       if(buildHierarchy_ && matrices_->levels()==matrices_->maxlevels()){
 	// We have the carsest level. Create the coarse Solver
+        Timer watch;
 	SmootherArgs sargs(smootherArgs_);
 	sargs.iterations = 1;
 	
@@ -477,6 +706,17 @@ namespace Dune
 	  coarseSmoother_ = ConstructionTraits<Smoother>::construct(cargs);
 	  scalarProduct_ = ScalarProductChooser::construct(*matrices_->parallelInformation().coarsest());
 	}
+	replicatedCoarseSolver_ = false;
+	if(replicateCoarseSolve_ && !matrices_->parallelInformation().coarsest().isRedistributed()
+	   && matrices_->parallelInformation().coarsest()->communicator().size()>1){
+	  solver_ = ReplicatedCoarseSolverCreator<typename M::matrix_type,X,PI>
+	    ::create(matrices_->matrices().coarsest()->getmat(), *matrices_->parallelInformation().coarsest());
+	  replicatedCoarseSolver_ = solver_!=0;
+	}
+	if(replicatedCoarseSolver_){
+	  if(verbosity_>0 && matrices_->parallelInformation().coarsest()->communicator().rank()==0)
+	    std::cout<<"Solving the coarse system on every process"<<std::endl;
+	}else
 #if HAVE_SUPERLU
       // Use superlu if we are purely sequential or with only one processor on the coarsest level.
 	if(is_same<ParallelInformation,SequentialInformation>::value // sequential mode 
@@ -512,6 +752,7 @@ namespace Dune
 					      *scalarProduct_, 
 					      *coarseSmoother_, 1E-2, 1000, 0);
 	  }
+        statistics_.coarseSolverSetupTime = watch.elapsed();
       }
     }
     template<class M, class X, class S, class PI, class A>
@@ -529,6 +770,7 @@ namespace Dune
     template<class M, class X, class S, class PI, class A>
     void AMG<M,X,S,PI,A>::apply(Domain& v, const Range& d)
     {
+      ++statistics_.cycles;
       if(additive){
 	*(rhs_->finest())=d;
 	additiveMgc();
@@ -545,7 +787,7 @@ namespace Dune
 		  
 	mgc();
 	
-	if(postSteps_==0||matrices_->maxlevels()==1)
+	if(postSteps(0)==0||matrices_->maxlevels()==1)
 	  pinfo->copyOwnerToAll(*update, *update);
 	
 	v=*update;
@@ -562,9 +804,12 @@ namespace Dune
       redist = 
         matrices_->redistributeInformation().begin();
       aggregates = matrices_->aggregatesMaps().begin();
+      prolongation = matrices_->prolongations().begin();
+      transfer = matrices_->transferOperators().begin();
       lhs = lhs_->finest();
       update = update_->finest();
       rhs = rhs_->finest();
+      level = 0;
     }
     
     template<class M, class X, class S, class PI, class A>
@@ -573,6 +818,7 @@ namespace Dune
     {
       
       bool processNextLevel=true;
+      Timer watch;
       
       if(redist->isSetup()){
         redist->redistribute(static_cast<const Range&>(*rhs), rhs.getRedistributed());
@@ -588,9 +834,9 @@ namespace Dune
         //restrict defect to coarse level right hand side.
         typename Hierarchy<Range,A>::Iterator fineRhs = rhs++;
 	  ++pinfo;
-	  Transfer<typename OperatorHierarchy::AggregatesMap::AggregateDescriptor,Range,ParallelInformation>
-	    ::restrict(*(*aggregates), *rhs, static_cast<const Range&>(*fineRhs), *pinfo);
+	  restrictDefect(*(*aggregates), *prolongation, *transfer, *rhs, static_cast<const Range&>(*fineRhs), *pinfo);
       }
+      statistics_.levels[level].transferTime += watch.elapsed();
       
       if(processNextLevel){
         // prepare coarse system
@@ -604,6 +850,8 @@ namespace Dune
           // next level is not the globally coarsest one
           ++smoother;
           ++aggregates;
+          ++prolongation;
+          ++transfer;
         }
         // prepare the update on the next level
         *update=0;
@@ -620,6 +868,8 @@ namespace Dune
           // previous level is not the globally coarsest one
 	    --smoother;
 	    --aggregates;
+	    --prolongation;
+	    --transfer;
         }
         --redist;
         --level;
@@ -630,6 +880,7 @@ namespace Dune
         --lhs;  
         --pinfo;
       }
+      Timer watch;
       if(redist->isSetup()){
         // Need to redistribute during prolongate
         lhs.getRedistributed()=0;
@@ -638,11 +889,10 @@ namespace Dune
                        *pinfo, *redist);
       }else{
         *lhs=0;
-        Transfer<typename OperatorHierarchy::AggregatesMap::AggregateDescriptor,Range,ParallelInformation>
-          ::prolongate(*(*aggregates), *update, *lhs, 
-                       matrices_->getProlongationDampingFactor(), *pinfo);
+        prolongateCorrection(*(*aggregates), *prolongation, *transfer, *update, *lhs,
+                             matrices_->getProlongationDampingFactor(), *pinfo);
       }
-      
+      statistics_.levels[level].transferTime += watch.elapsed();
       
       if(processNextLevel){
         --update;
@@ -657,8 +907,8 @@ namespace Dune
     void AMG<M,X,S,PI,A>
     ::presmooth()
     {
-      
-      for(std::size_t i=0; i < preSteps_; ++i){
+      Timer watch;
+      for(std::size_t i=0; i < preSteps(level); ++i){
 	    *lhs=0;
 	    SmootherApplier<S>::preSmooth(*smoother, *lhs, *rhs);
 	    // Accumulate update
@@ -668,14 +918,15 @@ namespace Dune
 	    matrix->applyscaleadd(-1,static_cast<const Domain&>(*lhs), *rhs);
 	    pinfo->project(*rhs);
           }
+      statistics_.levels[level].smoothingTime += watch.elapsed();
     }
     
      template<class M, class X, class S, class PI, class A>
     void AMG<M,X,S,PI,A>
      ::postsmooth()
     { 
-      
-	for(std::size_t i=0; i < postSteps_; ++i){
+      Timer watch;
+	for(std::size_t i=0; i < postSteps(level); ++i){
 	  // update defect
 	  matrix->applyscaleadd(-1,static_cast<const Domain&>(*lhs), *rhs);
 	  *lhs=0;
@@ -684,6 +935,7 @@ namespace Dune
 	  // Accumulate update
 	  *update += *lhs;
         }
+      statistics_.levels[level].smoothingTime += watch.elapsed();
     }
     
     
@@ -694,9 +946,10 @@ namespace Dune
     }
     
     template<class M, class X, class S, class PI, class A>
-    void AMG<M,X,S,PI,A>::mgc(){
+    void AMG<M,X,S,PI,A>::mgc(CycleMode mode){
       if(matrix == matrices_->matrices().coarsest() && levels()==maxlevels()){
 	// Solve directly
+        Timer watch;
 	InverseOperatorResult res;
 	res.converged=true; // If we do not compute this flag will not get updated
 	if(redist->isSetup()){
@@ -709,12 +962,15 @@ namespace Dune
 	  redist->redistributeBackward(*update, update.getRedistributed());
 	  pinfo->copyOwnerToAll(*update, *update);
 	}else{
-	  pinfo->copyOwnerToAll(*rhs, *rhs);
+	  // the replicated solver only needs the owner values
+	  if(!replicatedCoarseSolver_)
+	    pinfo->copyOwnerToAll(*rhs, *rhs);
 	  solver_->apply(*update, *rhs, res);
 	}
 
 	if (!res.converged)
 	  coarsesolverconverged = false;
+        statistics_.coarseSolveTime += watch.elapsed();
       }else{
 	// presmoothing
         presmooth();
@@ -724,8 +980,22 @@ namespace Dune
         
         if(processNextLevel){
           // next level
-	  for(std::size_t i=0; i<gamma_; i++)
-	    mgc();
+          std::size_t visits = mode==fCycle ? 2 : (mode==gammaCycle ? gamma_ : 1);
+          if(matrix == matrices_->matrices().coarsest() && levels()==maxlevels())
+            // visiting it again would only repeat the solve
+            visits = 1;
+	  for(std::size_t i=0; i<visits; i++){
+            if(i>0){
+              // the defect does not contain the last correction yet
+              matrix->applyscaleadd(-1,static_cast<const Domain&>(*lhs), *rhs);
+              pinfo->project(*rhs);
+            }
+            // the F-cycle on the coarser level is followed by a V-cycle
+	    if(mode==fCycle)
+	      mgc(i==0 ? fCycle : vCycle);
+	    else
+	      mgc(mode);
+          }
         }
         
         moveToFineLevel(processNextLevel);
@@ -752,46 +1022,139 @@ namespace Dune
       typename Hierarchy<Range,A>::Iterator rhs=rhs_->finest();      
       typename Hierarchy<Domain,A>::Iterator lhs = lhs_->finest();
       typename OperatorHierarchy::AggregatesMapList::const_iterator aggregates=matrices_->aggregatesMaps().begin();
+      typename OperatorHierarchy::ProlongationList::const_iterator prolongation=matrices_->prolongations().begin();
+      typename OperatorHierarchy::TransferOperatorList::const_iterator transfer=matrices_->transferOperators().begin();
+      std::size_t l=0;
       
-      for(typename Hierarchy<Range,A>::Iterator fineRhs=rhs++; fineRhs != rhs_->coarsest(); fineRhs=rhs++, ++aggregates){
+      for(typename Hierarchy<Range,A>::Iterator fineRhs=rhs++; fineRhs != rhs_->coarsest();
+          fineRhs=rhs++, ++aggregates, ++prolongation, ++transfer, ++l){
+        Timer watch;
 	++pinfo;
-	Transfer<typename OperatorHierarchy::AggregatesMap::AggregateDescriptor,Range,ParallelInformation>
-	  ::restrict(*(*aggregates), *rhs, static_cast<const Range&>(*fineRhs), *pinfo);
+	restrictDefect(*(*aggregates), *prolongation, *transfer, *rhs, static_cast<const Range&>(*fineRhs), *pinfo);
+        statistics_.levels[l].transferTime += watch.elapsed();
       }
       
-      // pinfo is invalid, set to coarsest level
-      //pinfo = matrices_->parallelInformation().coarsest
       // calculate correction for all levels
-      lhs = lhs_->finest();
+      std::vector<Domain*> lhss;
+      std::vector<const Range*> rhss;
+      std::vector<Smoother*> smoothers;
       typename Hierarchy<Smoother,A>::Iterator smoother = smoothers_.finest();
-      
-      for(rhs=rhs_->finest(); rhs != rhs_->coarsest(); ++lhs, ++rhs, ++smoother){
-	// presmoothing
-	*lhs=0;
-	smoother->apply(*lhs, *rhs);
+      for(lhs = lhs_->finest(), rhs = rhs_->finest(); rhs != rhs_->coarsest(); ++lhs, ++rhs, ++smoother){
+        lhss.push_back(&(*lhs));
+        rhss.push_back(&(*rhs));
+        smoothers.push_back(&(*smoother));
       }
-      
-      // Coarse level solve
+
 #ifndef DUNE_AMG_NO_COARSEGRIDCORRECTION 
-      InverseOperatorResult res;
-      pinfo->copyOwnerToAll(*rhs, *rhs);
-      solver_->apply(*lhs, *rhs, res);
-      
-      if(!res.converged)
-	DUNE_THROW(MathError, "Coarse solver did not converge");
+      if(!replicatedCoarseSolver_)
+        pinfo->copyOwnerToAll(*rhs, *rhs);
+#endif
+      bool converged = true;
+#ifdef _OPENMP
+      DeferredException error;
+#endif
+      const int corrections = lhss.size()+1;
+      // The corrections of the levels are independent. In the sequential case
+      // they are computed concurrently. The coarse solve is scheduled first
+      // such that it overlaps with the smoothing of the fine levels.
+      // Parallel smoothers communicate and are applied one after another.
+#ifdef _OPENMP
+      const bool concurrent = static_cast<int>(M::category)==static_cast<int>(SolverCategory::sequential);
+#pragma omp parallel for schedule(dynamic,1) if(concurrent)
+#endif
+      for(int i=0; i<corrections; ++i){
+#ifdef _OPENMP
+        // Timer measures the CPU time of all threads. Exceptions must not
+        // leave the parallel region.
+        const double start = omp_get_wtime();
+        try{
+#else
+        Timer watch;
+#endif
+          if(i==0){
+            // Coarse level solve
+#ifndef DUNE_AMG_NO_COARSEGRIDCORRECTION 
+            InverseOperatorResult res;
+            // start from zero like the other levels such that the correction
+            // does not depend on the previous cycle
+            *lhs=0;
+            solver_->apply(*lhs, *rhs, res);
+            converged = res.converged;
+#else
+            *lhs=0;
+#endif
+          }else{
+            *lhss[i-1]=0;
+            smoothers[i-1]->apply(*lhss[i-1], *rhss[i-1]);
+          }
+#ifdef _OPENMP
+        }catch(...){
+          error.store();
+        }
+        const double elapsed = omp_get_wtime()-start;
 #else
-      *lhs=0;
+        const double elapsed = watch.elapsed();
 #endif
+        if(i==0)
+          statistics_.coarseSolveTime += elapsed;
+        else
+          statistics_.levels[i-1].smoothingTime += elapsed;
+      }
+#ifdef _OPENMP
+      error.rethrow();
+#endif
+
+      if(!converged)
+	DUNE_THROW(MathError, "Coarse solver did not converge");
+
       // Prologate and add up corrections from all levels
       --pinfo;
       --aggregates;
+      --prolongation;
+      --transfer;
       
-      for(typename Hierarchy<Domain,A>::Iterator coarseLhs = lhs--; coarseLhs != lhs_->finest(); coarseLhs = lhs--, --aggregates, --pinfo){
-	Transfer<typename OperatorHierarchy::AggregatesMap::AggregateDescriptor,Range,ParallelInformation>
-	  ::prolongate(*(*aggregates), *coarseLhs, *lhs, 1, *pinfo);
+      for(typename Hierarchy<Domain,A>::Iterator coarseLhs = lhs--; coarseLhs != lhs_->finest();
+          coarseLhs = lhs--, --aggregates, --prolongation, --transfer, --pinfo){
+        Timer watch;
+        --l;
+	prolongateCorrection(*(*aggregates), *prolongation, *transfer, *coarseLhs, *lhs, 1, *pinfo);
+        statistics_.levels[l].transferTime += watch.elapsed();
       }
     }
 
+    template<class M, class X, class S, class PI, class A>
+    void AMG<M,X,S,PI,A>::restrictDefect(const typename OperatorHierarchy::AggregatesMap& aggregates,
+                                         const typename M::matrix_type* prolongation,
+                                         const typename OperatorHierarchy::TransferOperator* transfer,
+                                         Range& coarse, const Range& fine, ParallelInformation& info)
+    {
+      if(transfer){
+        transfer->restrict(coarse, fine);
+        info.project(coarse);
+      }else if(prolongation){
+        prolongation->mtv(fine, coarse);
+        info.project(coarse);
+      }else
+        Transfer<typename OperatorHierarchy::AggregatesMap::AggregateDescriptor,Range,ParallelInformation>
+          ::restrict(aggregates, coarse, fine, info);
+    }
+
+    template<class M, class X, class S, class PI, class A>
+    void AMG<M,X,S,PI,A>::prolongateCorrection(const typename OperatorHierarchy::AggregatesMap& aggregates,
+                                               const typename M::matrix_type* prolongation,
+                                               const typename OperatorHierarchy::TransferOperator* transfer,
+                                               Domain& coarse, Domain& fine,
+                                               typename M::field_type damp, ParallelInformation& info)
+    {
+      if(transfer)
+        transfer->prolongate(coarse, fine, prolongation ? 1 : damp);
+      else if(prolongation)
+        prolongation->umv(coarse, fine);
+      else
+        Transfer<typename OperatorHierarchy::AggregatesMap::AggregateDescriptor,Range,ParallelInformation>
+          ::prolongate(aggregates, coarse, fine, damp, info);
+    }
+
     
     /** \copydoc Preconditioner::post */
     template<class M, class X, class S, class PI, class A>
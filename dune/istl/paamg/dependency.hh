@@ -25,6 +25,58 @@ namespace Dune
      * @brief Provides classes for initializing the link attributes of a matrix graph.
      */
 
+    /**
+     * @brief Reference to a single flag of the edge or vertex properties.
+     *
+     * The flags are packed into one byte, as the properties are stored
+     * for every edge and vertex of the fine matrix graph.
+     */
+    class FlagReference
+    {
+    public:
+      /**
+       * @brief Constructor.
+       * @param flags The packed flags.
+       * @param bit The index of the flag.
+       */
+      FlagReference(unsigned char& flags, std::size_t bit)
+        : flags_(&flags), mask_(static_cast<unsigned char>(1<<bit))
+      {}
+
+      /** @brief Set or reset the flag. */
+      FlagReference& operator=(bool value)
+      {
+        if(value)
+          *flags_ |= mask_;
+        else
+          *flags_ &= static_cast<unsigned char>(~mask_);
+        return *this;
+      }
+
+      /** @brief Assign the value of another flag. */
+      FlagReference& operator=(const FlagReference& other)
+      {
+        return *this = static_cast<bool>(other);
+      }
+
+      /** @brief Get the value of the flag. */
+      operator bool() const
+      {
+        return (*flags_ & mask_) != 0;
+      }
+
+      /** @brief Toggle the flag. */
+      FlagReference& flip()
+      {
+        *flags_ ^= mask_;
+        return *this;
+      }
+
+    private:
+      unsigned char* flags_;
+      unsigned char mask_;
+    };
+
     /**
      * @brief Class representing the properties of an ede in the matrix graph.
      *
@@ -41,13 +93,14 @@ namespace Dune
 
     private:
       
-      std::bitset<SIZE> flags_;
+      /** @brief The attribute flags, one bit each. */
+      unsigned char flags_;
     public:
       /** @brief Constructor. */
       EdgeProperties();
       
       /** @brief Access the bits directly */
-      std::bitset<SIZE>::reference operator[](std::size_t v);
+      FlagReference operator[](std::size_t v);
       
       /** @brief Acess the bits directly */
       bool operator[](std::size_t v)const;
@@ -126,15 +179,15 @@ namespace Dune
       enum{ ISOLATED, VISITED, FRONT, BORDER, SIZE };
     private:
       
-      /** @brief The attribute flags. */    
-      std::bitset<SIZE> flags_;
+      /** @brief The attribute flags, one bit each. */
+      unsigned char flags_;
 
     public:
       /** @brief Constructor. */
       VertexProperties();
 
       /** @brief Access the bits directly */
-      std::bitset<SIZE>::reference operator[](std::size_t v);
+      FlagReference operator[](std::size_t v);
       
       /** @brief Acess the bits directly */
       bool operator[](std::size_t v) const;
@@ -212,7 +265,7 @@ namespace Dune
 
     template<typename G, std::size_t i>
     class PropertyGraphVertexPropertyMap
-      : public RAPropertyMapHelper<typename std::bitset<VertexProperties::SIZE>::reference,
+      : public RAPropertyMapHelper<FlagReference,
 			    PropertyGraphVertexPropertyMap<G,i> >
     {
     public:
@@ -220,7 +273,7 @@ namespace Dune
       typedef ReadWritePropertyMapTag Category;
 
       enum{
-      /** @brief the index to access in the bitset. */
+      /** @brief the index of the flag to access. */
       index = i
 	};
       
@@ -229,15 +282,10 @@ namespace Dune
        */
       typedef G Graph;
 
-      /**
-       * @brief The type of the bitset.
-       */
-      typedef std::bitset<VertexProperties::SIZE> BitSet;
-
       /**
        * @brief The reference type.
        */
-      typedef typename BitSet::reference Reference;
+      typedef FlagReference Reference;
 
       /**
        * @brief The value type.
@@ -296,60 +344,56 @@ namespace Dune
   {
     inline std::ostream& operator<<(std::ostream& os, const EdgeProperties& props)
     {
-      return os << props.flags_;
+      return os << std::bitset<EdgeProperties::SIZE>(props.flags_);
     }
     
     inline EdgeProperties::EdgeProperties()
-      : flags_()
+      : flags_(0)
     {}
 
-    inline std::bitset<EdgeProperties::SIZE>::reference 
-    EdgeProperties::operator[](std::size_t v)
+    inline FlagReference EdgeProperties::operator[](std::size_t v)
     {
-      return flags_[v];
+      return FlagReference(flags_, v);
     }
     
     inline bool EdgeProperties::operator[](std::size_t i) const
     {
-      return flags_[i];
+      return (flags_ & (1<<i)) != 0;
     }
     
     inline void EdgeProperties::reset()
     {
-      flags_.reset();
+      flags_ = 0;
     }
     
     inline void EdgeProperties::setInfluences()
     {
       // Set the INFLUENCE bit
-      //flags_ |= (1<<INFLUENCE);
-      flags_.set(INFLUENCE);
+      flags_ |= (1<<INFLUENCE);
     }
 
     inline bool EdgeProperties::influences() const
     {
       // Test the INFLUENCE bit
-      return flags_.test(INFLUENCE);
+      return (flags_ & (1<<INFLUENCE)) != 0;
     }
 
     inline void EdgeProperties::setDepends()
     {
       // Set the first bit.
-      //flags_ |= (1<<DEPEND);
-      flags_.set(DEPEND);
+      flags_ |= (1<<DEPEND);
     }
 
     inline void EdgeProperties::resetDepends()
     {
       // reset the first bit.
-      //flags_ &= ~(1<<DEPEND);
-      flags_.reset(DEPEND);
+      flags_ &= ~(1<<DEPEND);
     }
 
     inline bool EdgeProperties::depends() const
     {
       // Return the first bit.
-      return flags_.test(DEPEND);
+      return (flags_ & (1<<DEPEND)) != 0;
     }
 
     inline void EdgeProperties::resetInfluences()
@@ -362,106 +406,105 @@ namespace Dune
     {
       // Test whether only the first bit is set
       //return isStrong() && !isTwoWay();
-      return ((flags_) & std::bitset<SIZE>((1<<INFLUENCE)|(1<<DEPEND)))==(1<<DEPEND);
+      return (flags_ & ((1<<INFLUENCE)|(1<<DEPEND)))==(1<<DEPEND);
     }
 
     inline bool EdgeProperties::isTwoWay() const
     {
       // Test whether the first and second bit is set 
-      return ((flags_) & std::bitset<SIZE>((1<<INFLUENCE)|(1<<DEPEND)))==((1<<INFLUENCE)|(1<<DEPEND));
+      return (flags_ & ((1<<INFLUENCE)|(1<<DEPEND)))==((1<<INFLUENCE)|(1<<DEPEND));
     }
 
     inline bool EdgeProperties::isStrong() const
     {
       // Test whether the first or second bit is set
-      return ((flags_) & std::bitset<SIZE>((1<<INFLUENCE)|(1<<DEPEND))).to_ulong();
+      return (flags_ & ((1<<INFLUENCE)|(1<<DEPEND))) != 0;
     }
 
 
     inline std::ostream& operator<<(std::ostream& os, const VertexProperties& props)
     {
-      return os << props.flags_;
+      return os << std::bitset<VertexProperties::SIZE>(props.flags_);
     }
 
     inline VertexProperties::VertexProperties()
-      : flags_()
+      : flags_(0)
     {}
     
     
-    inline std::bitset<VertexProperties::SIZE>::reference 
-    VertexProperties::operator[](std::size_t v)
+    inline FlagReference VertexProperties::operator[](std::size_t v)
     {
-      return flags_[v];
+      return FlagReference(flags_, v);
     }
     
     inline bool VertexProperties::operator[](std::size_t v) const
     {
-      return flags_[v];
+      return (flags_ & (1<<v)) != 0;
     }
     
     inline void VertexProperties::setIsolated()
     {
-      flags_.set(ISOLATED);
+      flags_ |= (1<<ISOLATED);
     }
 
     inline bool VertexProperties::isolated() const
     {
-      return flags_.test(ISOLATED);
+      return (flags_ & (1<<ISOLATED)) != 0;
     }
 
     inline void VertexProperties::resetIsolated()
     {
-      flags_.reset(ISOLATED);
+      flags_ &= ~(1<<ISOLATED);
     }
 
     inline void VertexProperties::setVisited()
     {
-      flags_.set(VISITED);
+      flags_ |= (1<<VISITED);
     }
 
     inline bool VertexProperties::visited() const
     {
-      return flags_.test(VISITED);
+      return (flags_ & (1<<VISITED)) != 0;
     }
 
     inline void VertexProperties::resetVisited()
     {
-      flags_.reset(VISITED);
+      flags_ &= ~(1<<VISITED);
     }
 
     inline void VertexProperties::setFront()
     {
-      flags_.set(FRONT);
+      flags_ |= (1<<FRONT);
     }
 
     inline bool VertexProperties::front() const
     {
-      return  flags_.test(FRONT);
+      return  (flags_ & (1<<FRONT)) != 0;
     }
 
     inline void VertexProperties::resetFront()
     {
-      flags_.reset(FRONT);
+      flags_ &= ~(1<<FRONT);
     }
     
     inline void VertexProperties::setExcludedBorder()
     {
-      flags_.set(BORDER);
+      flags_ |= (1<<BORDER);
     }
 
     inline bool VertexProperties::excludedBorder() const
     {
-      return  flags_.test(BORDER);
+      return  (flags_ & (1<<BORDER)) != 0;
     }
 
     inline void VertexProperties::resetExcludedBorder()
     {
-      flags_.reset(BORDER);
+      flags_ &= ~(1<<BORDER);
     }
     
     inline void VertexProperties::reset()
     {
-      flags_.reset();
+      flags_ = 0;
     }
     
      /** @} */
@@ -8,9 +8,12 @@
 #include"pinfo.hh"
 #include<dune/common/poolallocator.hh>
 #include<dune/common/enumset.hh>
+#include<dune/istl/istlexception.hh>
+#include<cstddef>
 #include<set>
 #include<limits>
 #include<algorithm>
+#include<vector>
 
 namespace Dune
 {
@@ -108,8 +111,83 @@ namespace Dune
       template<class M, class V, class I, class O>
       void calculate(const M& fine, const AggregatesMap<V>& aggregates, M& coarse,
 		     const I& pinfo, const O& copy);
+
+      /**
+       * @brief Get the diagonal values of the copy rows of the coarse matrix
+       * from their owner processes.
+       * @param coarse The coarse Matrix.
+       * @param pinfo Parallel information about the coarse level.
+       */
+      template<class M, class I>
+      static void copyOwnerDiagonals(M& coarse, const I& pinfo);
       
     };
+
+    /**
+     * @brief Cached mapping of the fine matrix entries onto the entries of
+     * the coarse matrix.
+     *
+     * For aggregation based coarsening each fine entry \f$a_{ij}\f$ with
+     * i and j not isolated is added to the coarse entry of the aggregates
+     * of i and j. This map records these positions once, grouped by the
+     * coarse rows. Recalculating the coarse matrix after the values (but
+     * not the pattern) of the fine matrix changed then needs neither the
+     * matrix graph nor the aggregates and the coarse rows can be
+     * processed in parallel.
+     *
+     * The entries are summed up in the same order as
+     * BaseGalerkinProduct::calculate does, i.e. the results are identical.
+     */
+    template<class M>
+    class GalerkinEntryMap
+    {
+    public:
+      /** @brief The type of the matrices. */
+      typedef M Matrix;
+      /** @brief The type of the matrix blocks. */
+      typedef typename M::block_type Block;
+      /** @brief The type of the indices. */
+      typedef typename M::size_type size_type;
+
+      /**
+       * @brief Record the positions of the fine entries in the coarse matrix.
+       * @param fine The matrix on the fine level.
+       * @param aggregates The mapping of the fine level unknowns onto aggregates.
+       * @param coarse The coarse matrix with its sparsity pattern set up.
+       */
+      template<class V>
+      void setup(const M& fine, const AggregatesMap<V>& aggregates, const M& coarse);
+
+      /**
+       * @brief Calculate the entries of the coarse matrix.
+       *
+       * The patterns of both matrices have to be the same as during setup.
+       * @param fine The matrix on the fine level.
+       * @param coarse The coarse matrix.
+       * @param pinfo Parallel information about the coarse level.
+       */
+      template<class I>
+      void calculate(const M& fine, M& coarse, const I& pinfo) const;
+
+      /** @brief The number of bytes allocated for the map. */
+      std::size_t memory() const
+      {
+        return (start_.capacity()+fineRow_.capacity())*sizeof(size_type)
+          +(fineOffset_.capacity()+coarseOffset_.capacity())*sizeof(unsigned int);
+      }
+
+    private:
+      /** @brief The start of the contributions to each coarse row. */
+      std::vector<size_type> start_;
+      /** @brief The fine row of each contribution. */
+      std::vector<size_type> fineRow_;
+      /** @brief The position of each contribution in its fine row. */
+      std::vector<unsigned int> fineOffset_;
+      /** @brief The position of the target of each contribution in its coarse row. */
+      std::vector<unsigned int> coarseOffset_;
+      /** @brief The number of nonzeros of the fine matrix during setup. */
+      size_type fineNonzeroes_;
+    };
     
     template<class T>
     class GalerkinProduct
@@ -500,12 +578,24 @@ namespace Dune
     {	  
       typedef typename G::VertexIterator VertexIterator;
       
+      // The rows are created in the order of the aggregate numbers,
+      // which need not be the order of their first vertices.
+      std::vector<Vertex> seeds;
       VertexIterator vend=graph.end();
-      for(VertexIterator vertex = graph.begin(); vertex != vend; ++vertex){
+      for(VertexIterator vertex = graph.begin(); vertex != vend; ++vertex)
 	if(!get(visitedMap, *vertex)){
-	  constructNonOverlapConnectivity(row, graph, visitedMap, aggregates, *vertex);
-	  ++row;
+	  const Vertex aggregate=aggregates[*vertex];
+	  if(aggregate>=seeds.size())
+	    seeds.resize(aggregate+1, AggregatesMap<Vertex>::UNAGGREGATED);
+	  if(seeds[aggregate]==AggregatesMap<Vertex>::UNAGGREGATED)
+	    seeds[aggregate]=*vertex;
 	}
+
+      typedef typename std::vector<Vertex>::const_iterator SeedIterator;
+      for(SeedIterator seed=seeds.begin(); seed != seeds.end(); ++seed){
+	assert(*seed!=AggregatesMap<Vertex>::UNAGGREGATED);
+	constructNonOverlapConnectivity(row, graph, visitedMap, aggregates, *seed);
+	++row;
       }
       
     }
@@ -659,7 +749,21 @@ namespace Dune
 	    } 
 	}
 
+      copyOwnerDiagonals(coarse, pinfo);
+      
+      // don't set dirichlet boundaries for copy lines to make novlp case work,
+      // the preconditioner yields slightly different results now.
+
+      // Set the dirichlet border      
+      //DirichletBoundarySetter<P>::template set<M>(coarse, pinfo, copy);
+    
+    }
+
+    template<class M, class P>
+    void BaseGalerkinProduct::copyOwnerDiagonals(M& coarse, const P& pinfo)
+    {
       // get the right diagonal matrix values on copy lines from owner processes  
+      typedef typename M::ConstIterator RowIterator;
       typedef typename M::block_type BlockType;
       std::vector<BlockType> rowsize(coarse.N(),BlockType(0));
       for (RowIterator row = coarse.begin(); row != coarse.end(); ++row)
@@ -667,13 +771,76 @@ namespace Dune
       pinfo.copyOwnerToAll(rowsize,rowsize);
       for (RowIterator row = coarse.begin(); row != coarse.end(); ++row)
         coarse[row.index()][row.index()] = rowsize[row.index()];
-      
-      // don't set dirichlet boundaries for copy lines to make novlp case work,
-      // the preconditioner yields slightly different results now.
+    }
 
-      // Set the dirichlet border      
-      //DirichletBoundarySetter<P>::template set<M>(coarse, pinfo, copy);
-    
+    template<class M>
+    template<class V>
+    void GalerkinEntryMap<M>::setup(const M& fine, const AggregatesMap<V>& aggregates,
+                                    const M& coarse)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+
+      // count the contributions to each coarse row
+      start_.assign(coarse.N()+1, 0);
+      for(RowIterator row = fine.begin(); row != fine.end(); ++row)
+        if(aggregates[row.index()] != AggregatesMap<V>::ISOLATED){
+          assert(aggregates[row.index()]!=AggregatesMap<V>::UNAGGREGATED);
+          for(ColIterator col = row->begin(); col != row->end(); ++col)
+            if(aggregates[col.index()] != AggregatesMap<V>::ISOLATED)
+              ++start_[aggregates[row.index()]+1];
+        }
+      for(size_type k=0; k<coarse.N(); ++k)
+        start_[k+1]+=start_[k];
+
+      fineRow_.resize(start_.back());
+      fineOffset_.resize(start_.back());
+      coarseOffset_.resize(start_.back());
+      fineNonzeroes_=fine.nonzeroes();
+
+      // fill them in the order of the fine matrix
+      std::vector<size_type> position(start_.begin(), start_.end()-1);
+      for(RowIterator row = fine.begin(); row != fine.end(); ++row)
+        if(aggregates[row.index()] != AggregatesMap<V>::ISOLATED){
+          const typename M::row_type& crow = coarse[aggregates[row.index()]];
+          for(ColIterator col = row->begin(); col != row->end(); ++col)
+            if(aggregates[col.index()] != AggregatesMap<V>::ISOLATED){
+              ColIterator target = crow.find(aggregates[col.index()]);
+              if(target==crow.end())
+                DUNE_THROW(ISTLError, "Coarse matrix has no entry ("<<aggregates[row.index()]
+                           <<","<<aggregates[col.index()]<<")!");
+              size_type& p = position[aggregates[row.index()]];
+              fineRow_[p]=row.index();
+              fineOffset_[p]=col.offset();
+              coarseOffset_[p]=target.offset();
+              ++p;
+            }
+        }
+    }
+
+    template<class M>
+    template<class I>
+    void GalerkinEntryMap<M>::calculate(const M& fine, M& coarse, const I& pinfo) const
+    {
+      if(start_.size()!=coarse.N()+1 || fineNonzeroes_!=fine.nonzeroes())
+        DUNE_THROW(ISTLError, "The pattern of the matrices changed, call setup first!");
+
+      const std::ptrdiff_t n=coarse.N();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for(std::ptrdiff_t k=0; k<n; ++k){
+        typename M::row_type& crow = coarse[k];
+        for(typename M::ColIterator col = crow.begin(); col != crow.end(); ++col)
+          *col = 0;
+        if(start_[k]==start_[k+1])
+          continue;
+        Block* centries = &(*crow.begin());
+        for(size_type e=start_[k]; e<start_[k+1]; ++e)
+          centries[coarseOffset_[e]] += (&(*fine[fineRow_[e]].begin()))[fineOffset_[e]];
+      }
+
+      BaseGalerkinProduct::copyOwnerDiagonals(coarse, pinfo);
     }
 
     template<class T>
@@ -7,6 +7,7 @@
 #include<dune/istl/operators.hh>
 #include<dune/istl/bcrsmatrix.hh>
 #include<dune/common/tuples.hh>
+#include<cstddef>
 
 namespace Dune
 {
@@ -46,6 +47,17 @@ namespace Dune
       {
 	delete get<1>(graphs);
       }
+
+      /**
+       * @brief Estimate the number of bytes allocated for the graphs.
+       */
+      static std::size_t memory(const GraphTuple& graphs)
+      {
+	const MatrixGraph& mg=*get<0>(graphs);
+	return (mg.maxVertex()+1)*(sizeof(typename MatrixGraph::EdgeDescriptor)
+				   +sizeof(VertexProperties))
+	  +mg.noEdges()*sizeof(EdgeProperties);
+      }
       
     };
 
@@ -88,6 +100,18 @@ namespace Dune
 	delete get<2>(graphs);
 	delete get<1>(graphs);
       }
+
+      /**
+       * @brief Estimate the number of bytes allocated for the graphs.
+       */
+      static std::size_t memory(const GraphTuple& graphs)
+      {
+	const MatrixGraph& mg=*get<0>(graphs);
+	const SubGraph& sg=*get<2>(graphs);
+	return (mg.maxVertex()+1)*(sizeof(typename MatrixGraph::EdgeDescriptor)
+				   +2*sizeof(std::ptrdiff_t)+sizeof(VertexProperties))
+	  +sg.noEdges()*(sizeof(typename SubGraph::VertexDescriptor)+sizeof(EdgeProperties));
+      }
     };
 
     template<class M>
@@ -129,6 +153,18 @@ namespace Dune
 	delete get<2>(graphs);
 	delete get<1>(graphs);
       }
+
+      /**
+       * @brief Estimate the number of bytes allocated for the graphs.
+       */
+      static std::size_t memory(const GraphTuple& graphs)
+      {
+	const MatrixGraph& mg=*get<0>(graphs);
+	const SubGraph& sg=*get<2>(graphs);
+	return (mg.maxVertex()+1)*(sizeof(typename MatrixGraph::EdgeDescriptor)
+				   +2*sizeof(std::ptrdiff_t)+sizeof(VertexProperties))
+	  +sg.noEdges()*(sizeof(typename SubGraph::VertexDescriptor)+sizeof(EdgeProperties));
+      }
     };
     
   }//namespace Amg
@@ -8,11 +8,15 @@
 #include<memory>
 #include<limits>
 #include<algorithm>
+#include<vector>
 #include"aggregates.hh"
 #include"graph.hh"
 #include"galerkin.hh"
+#include"smoothedaggregation.hh"
 #include"renumberer.hh"
 #include"graphcreator.hh"
+#include"hierarchyio.hh"
+#include"statistics.hh"
 #include<dune/common/stdstreams.hh>
 #include<dune/common/timer.hh>
 #include<dune/common/tuples.hh>
@@ -277,6 +281,13 @@ namespace Dune
        */
       std::size_t levels() const;
       
+      /**
+       * @brief Remove all levels.
+       *
+       * The elements not passed to the constructor are destroyed.
+       */
+      void clear();
+
       /** @brief Destructor. */
       ~Hierarchy();
       
@@ -339,6 +350,59 @@ namespace Dune
       /** @brief The type of the list of redistribute information. */
       typedef std::list<RedistributeInfoType,RILAllocator> RedistributeInfoList;
 
+      /** @brief Allocator for matrix pointers. */
+      typedef typename Allocator::template rebind<Matrix*>::other PAllocator;
+
+      /**
+       * @brief The type of the list of prolongation matrices.
+       *
+       * There is one entry per aggregates map, which is null if the
+       * prolongation is piecewise constant on the aggregates.
+       */
+      typedef std::list<Matrix*,PAllocator> ProlongationList;
+
+      /** @brief The type of the explicit transfer operators. */
+      typedef SparseTransferOperator<typename Matrix::block_type> TransferOperator;
+
+      /** @brief Allocator for transfer operator pointers. */
+      typedef typename Allocator::template rebind<TransferOperator*>::other TAllocator;
+
+      /**
+       * @brief The type of the list of explicit transfer operators.
+       *
+       * There is one entry per aggregates map, which is null if no
+       * explicit operators were requested.
+       */
+      typedef std::list<TransferOperator*,TAllocator> TransferOperatorList;
+
+      /** @brief The type of the cached entry maps of the Galerkin products. */
+      typedef GalerkinEntryMap<Matrix> EntryMap;
+
+      /** @brief Allocator for entry map pointers. */
+      typedef typename Allocator::template rebind<EntryMap*>::other EAllocator;
+
+      /**
+       * @brief The type of the list of cached entry maps.
+       *
+       * There is one entry per aggregates map, which is null for
+       * smoothed aggregation levels.
+       */
+      typedef std::list<EntryMap*,EAllocator> EntryMapList;
+
+      /** @brief The type of the cached smoothed aggregation Galerkin products. */
+      typedef GalerkinTripleProduct<Matrix> TripleProduct;
+
+      /** @brief Allocator for triple product pointers. */
+      typedef typename Allocator::template rebind<TripleProduct*>::other GAllocator;
+
+      /**
+       * @brief The type of the list of cached triple products.
+       *
+       * There is one entry per aggregates map, which is only non null for
+       * smoothed aggregation levels.
+       */
+      typedef std::list<TripleProduct*,GAllocator> TripleProductList;
+
       /**
        * @brief Constructor
        * @param fineMatrix The matrix to coarsen.
@@ -363,11 +427,36 @@ namespace Dune
        *
        * If the data of the fine matrix changes but not its sparsity pattern
        * this will recalculate all coarser levels without starting the expensive
-       * aggregation process all over again.
+       * aggregation process all over again. The positions of the fine entries
+       * in the coarse matrices recorded during build are used, such that
+       * each level only needs a (threaded) pass over the coarse rows.
        */
       template<class F>
       void recalculateGalerkin(const F& copyFlags);
 
+      /**
+       * @brief Save the built hierarchy to a binary stream.
+       *
+       * The aggregates maps, prolongations, coarse matrices and the
+       * parallel information of the coarse levels are written, such that
+       * load can restore the hierarchy without aggregation and Galerkin
+       * products. In parallel each process saves its own part.
+       * Hierarchies with redistributed levels are not supported.
+       * @param os The stream to write to, should be opened in binary mode.
+       */
+      void save(std::ostream& os) const;
+
+      /**
+       * @brief Restore a hierarchy saved by save instead of building it.
+       *
+       * The fine level matrix and parallel information passed to the
+       * constructor have to be the ones the hierarchy was built for.
+       * In parallel all processes have to load their part collectively,
+       * as the remote indices of the coarse levels are rebuilt.
+       * @param is The stream to read from, should be opened in binary mode.
+       */
+      void load(std::istream& is);
+
       /**
        * @brief Coarsen the vector hierarchy according to the matrix hierarchy.
        * @param hierarchy The vector hierarchy to coarsen.
@@ -379,10 +468,26 @@ namespace Dune
        * @brief Coarsen the smoother hierarchy according to the matrix hierarchy.
        * @param smoothers The smoother hierarchy to coarsen.
        * @param args The arguments for the construction of the coarse level smoothers.
+       * @param statistics If not null the setup times of the smoothers are stored
+       * in its level statistics.
        */
       template<class S, class TA>
       void coarsenSmoother(Hierarchy<S,TA>& smoothers, 
-			   const typename SmootherTraits<S>::Arguments& args) const;
+			   const typename SmootherTraits<S>::Arguments& args,
+                           AMGStatistics* statistics=0) const;
+
+      /**
+       * @brief Coarsen the smoother hierarchy with different arguments per level.
+       * @param smoothers The smoother hierarchy to coarsen.
+       * @param args The arguments for the construction of the smoothers
+       * of each level. The last ones are used for all levels beyond.
+       * @param statistics If not null the setup times of the smoothers are stored
+       * in its level statistics.
+       */
+      template<class S, class TA>
+      void coarsenSmoother(Hierarchy<S,TA>& smoothers,
+                           const std::vector<typename SmootherTraits<S>::Arguments>& args,
+                           AMGStatistics* statistics=0) const;
       
       /**
        * @brief Get the number of levels in the hierarchy.
@@ -428,6 +533,33 @@ namespace Dune
        * data to fewer processes.
        */
       const RedistributeInfoList& redistributeInformation() const;
+
+      /**
+       * @brief Get the hierarchy of the explicit prolongation matrices.
+       *
+       * The entries are only non null if smoothed aggregation was
+       * used, see CoarseningParameters::setSmoothedAggregation.
+       * @return The list of prolongation matrices, one for each aggregates map.
+       */
+      const ProlongationList& prolongations() const;
+
+      /**
+       * @brief Get the hierarchy of the explicit transfer operators.
+       *
+       * The entries are only non null if requested by
+       * CoarseningParameters::setExplicitTransferOperators.
+       * @return The list of transfer operators, one for each aggregates map.
+       */
+      const TransferOperatorList& transferOperators() const;
+
+      /**
+       * @brief Get the statistics of the setup.
+       *
+       * The sizes of the levels, the times for the aggregation and the
+       * Galerkin products of the last build (or recalculation) and the
+       * total setup time are filled in.
+       */
+      const AMGStatistics& statistics() const;
       
 
       typename MatrixOperator::field_type getProlongationDampingFactor() const
@@ -450,10 +582,24 @@ namespace Dune
     private:
       typedef typename ConstructionTraits<MatrixOperator>::Arguments MatrixArgs;
       typedef typename ConstructionTraits<ParallelInformation>::Arguments CommunicationArgs;
+      /** @brief Identifies streams written by save. */
+      static const char hierarchyMagic_[8];
+      /** @brief The version of the format written by save. */
+      static const int hierarchyVersion_;
       /** @brief The list of aggregates maps. */
       AggregatesMapList aggregatesMaps_;
       /** @brief The list of redistributes. */
       RedistributeInfoList redistributes_;
+      /** @brief The list of smoothed prolongations. */
+      ProlongationList prolongations_;
+      /** @brief The list of explicit transfer operators. */
+      TransferOperatorList transferOperators_;
+      /** @brief The list of cached entry maps of the Galerkin products. */
+      EntryMapList entryMaps_;
+      /** @brief The list of cached smoothed aggregation Galerkin products. */
+      TripleProductList tripleProducts_;
+      /** @brief The statistics of the setup. */
+      AMGStatistics statistics_;
       /** @brief The hierarchy of parallel matrices. */
       ParallelMatrixHierarchy matrices_;
       /** @brief The hierarchy of the parallel information. */
@@ -466,6 +612,15 @@ namespace Dune
       int maxlevels_;
       
       typename MatrixOperator::field_type prolongDamp_;
+
+      /** @brief The damping factor for smoothing the prolongations. */
+      double smoothingFactor_;
+
+      /** @brief Whether the Galerkin products are recalculated without caches. */
+      bool leanSetup_;
+
+      /** @brief Store the sizes and the memory of the levels in the statistics. */
+      void updateLevelSizes();
       
       /**
        * @brief functor to print matrix statistics.
@@ -634,11 +789,31 @@ namespace Dune
     return true;
   }
 
+    /**
+     * @brief Redistribute the entries of a matrix whose redistributed
+     * sparsity pattern is already set up.
+     */
+    template<class M, class C>
+    void redistributeMatrixAmg(M& mat, M& matRedist, C& info, C& infoRedist,
+                               RedistributeInformation<C>& redistInfo)
+    {
+      info.buildGlobalLookup(info.indexSet().size());
+      redistributeMatrixEntries(mat, matRedist, info, infoRedist, redistInfo);
+      info.freeGlobalLookup();
+    }
+
+    template<class M>
+    void redistributeMatrixAmg(M& mat, M& matRedist, SequentialInformation& info,
+                               SequentialInformation& infoRedist,
+                               RedistributeInformation<SequentialInformation>& redistInfo)
+    {}
+
     template<class M, class IS, class A>
     MatrixHierarchy<M,IS,A>::MatrixHierarchy(const MatrixOperator& fineOperator,
 					     const ParallelInformation& pinfo)
       : matrices_(const_cast<MatrixOperator&>(fineOperator)),
-	parallelInformation_(const_cast<ParallelInformation&>(pinfo))
+	parallelInformation_(const_cast<ParallelInformation&>(pinfo)), built_(false),
+        leanSetup_(false)
     {
       dune_static_assert((static_cast<int>(MatrixOperator::category) == 
 			  static_cast<int>(SolverCategory::sequential) ||
@@ -656,7 +831,13 @@ namespace Dune
     template<typename O, typename T>
     void MatrixHierarchy<M,IS,A>::build(const T& criterion)
     {
+      Timer buildWatch;
+      statistics_ = AMGStatistics();
       prolongDamp_ = criterion.getProlongationDampingFactor();
+      smoothingFactor_ = criterion.getProlongationSmoothingFactor();
+      leanSetup_ = criterion.leanSetup();
+      if(criterion.smoothedAggregation() && parallelInformation_.finest()->communicator().size()>1)
+        DUNE_THROW(NotImplemented, "Smoothed aggregation is only implemented for sequential hierarchies!");
       typedef O OverlapFlags;
       typedef typename ParallelMatrixHierarchy::Iterator MatIterator;
       typedef typename ParallelInformationHierarchy::Iterator PInfoIterator;
@@ -672,6 +853,9 @@ namespace Dune
       BIGINT finenonzeros=countNonZeros(mlevel->getmat());
       finenonzeros = infoLevel->communicator().sum(finenonzeros);
       BIGINT allnonzeros = finenonzeros;
+      // estimated bytes of the levels built so far and the peak during the build
+      std::size_t hierarchyMemory = matrixMemory(mlevel->getmat());
+      std::size_t peakMemory = hierarchyMemory;
 
       
       int level = 0;
@@ -694,12 +878,7 @@ namespace Dune
 	MatrixOperator* matrix=&(*mlevel);
 	ParallelInformation* info =&(*infoLevel);
 
-	if((
-#if HAVE_PARMETIS
-	      criterion.accumulate()==successiveAccu
-#else
-	      false
-#endif
+	if((criterion.accumulate()==successiveAccu
 	     || (criterion.accumulate()==atOnceAccu
 		 && dunknowns < 30*infoLevel->communicator().size()))
 	   && infoLevel->communicator().size()>1 && 
@@ -752,13 +931,21 @@ namespace Dune
 
 	typedef typename PropertiesGraph::VertexDescriptor Vertex;
 	
+	Timer aggregationWatch;
 	std::vector<bool> excluded(matrix->getmat().N(), false);
 
 	GraphTuple graphs = GraphCreator::create(*matrix, excluded, *info, OverlapFlags());
 	
 	AggregatesMap* aggregatesMap=new AggregatesMap(get<1>(graphs)->maxVertex()+1);
+	std::size_t graphMemory = GraphCreator::memory(graphs)+excluded.capacity()/8;
+	std::size_t levelMemory = aggregatesMap->noVertices()*sizeof(Vertex);
+	peakMemory = std::max(peakMemory, hierarchyMemory+graphMemory+levelMemory);
 
 	aggregatesMaps_.push_back(aggregatesMap);
+	prolongations_.push_back(0);
+	transferOperators_.push_back(0);
+	entryMaps_.push_back(0);
+	tripleProducts_.push_back(0);
 
 	Timer watch;
 	watch.reset();
@@ -838,6 +1025,10 @@ namespace Dune
             aggregatesMap->free();
 	    delete aggregatesMap;
 	    aggregatesMaps_.pop_back();
+	    prolongations_.pop_back();
+	    transferOperators_.pop_back();
+	    entryMaps_.pop_back();
+	    tripleProducts_.pop_back();
 
             if(criterion.accumulate() && mlevel.isRedistributed() && info->communicator().size()>1){
               // coarse level matrix was already redistributed, but to more than 1 process
@@ -870,6 +1061,10 @@ namespace Dune
 		    visitedMap,
 		    *aggregatesMap,
 		    *infoLevel);
+
+	if(criterion.renumberCoarseLevels() && is_same<ParallelInformation,SequentialInformation>::value)
+	  // In the parallel case the aggregate numbers are the local indices of the coarse index set
+	  renumberAggregatesLocally(*(get<1>(graphs)), *aggregatesMap, aggregates);
 	
 	GraphCreator::free(graphs);
 	
@@ -891,6 +1086,9 @@ namespace Dune
 	    std::cout<<"Communicating global aggregate numbers took "<<watch.elapsed()<<" seconds."<<std::endl;
 	}
 
+	statistics_.levels.resize(level+1);
+	statistics_.levels[level].aggregationTime = aggregationWatch.elapsed();
+	statistics_.levels[level].setupMemory = graphMemory;
 	watch.reset();
 	std::vector<bool>& visited=excluded;
 	
@@ -904,17 +1102,59 @@ namespace Dune
 
 	typename MatrixOperator::matrix_type* coarseMatrix;
 
-	coarseMatrix = productBuilder.build(matrix->getmat(), *(get<0>(graphs)), visitedMap2, 
-					    *info, 
-					    *aggregatesMap,
-					    aggregates,
-					    OverlapFlags());
+	if(criterion.smoothedAggregation()){
+	  Matrix* prolongation = new Matrix();
+	  buildSmoothedProlongation(matrix->getmat(), *aggregatesMap, aggregates,
+				    smoothingFactor_, *prolongation);
+	  prolongations_.back() = prolongation;
+
+	  info->freeGlobalLookup();
+	  delete get<0>(graphs);
+
+	  coarseMatrix = new Matrix();
+	  TripleProduct* tripleProduct = new TripleProduct();
+	  tripleProduct->setup(*prolongation, matrix->getmat(), *coarseMatrix);
+	  levelMemory += matrixMemory(*prolongation)+tripleProduct->memory();
+	  if(leanSetup_)
+	    delete tripleProduct;
+	  else
+	    tripleProducts_.back() = tripleProduct;
+	}else{
+	  coarseMatrix = productBuilder.build(matrix->getmat(), *(get<0>(graphs)), visitedMap2, 
+					      *info, 
+					      *aggregatesMap,
+					      aggregates,
+					      OverlapFlags());
 	
-	info->freeGlobalLookup();
+	  info->freeGlobalLookup();
 	
-	delete get<0>(graphs);
-	productBuilder.calculate(matrix->getmat(), *aggregatesMap, *coarseMatrix, *infoLevel, OverlapFlags());
+	  delete get<0>(graphs);
+	  if(leanSetup_)
+	    productBuilder.calculate(matrix->getmat(), *aggregatesMap, *coarseMatrix, *infoLevel,
+				     OverlapFlags());
+	  else{
+	    EntryMap* entryMap = new EntryMap();
+	    entryMap->setup(matrix->getmat(), *aggregatesMap, *coarseMatrix);
+	    entryMap->calculate(matrix->getmat(), *coarseMatrix, *infoLevel);
+	    entryMaps_.back() = entryMap;
+	    levelMemory += entryMap->memory();
+	  }
+	}
+
+	if(criterion.explicitTransferOperators()){
+	  TransferOperator* transfer = new TransferOperator();
+	  if(prolongations_.back())
+	    transfer->setup(*prolongations_.back());
+	  else
+	    transfer->setup(*aggregatesMap, coarseMatrix->N());
+	  transferOperators_.back() = transfer;
+	  levelMemory += transfer->memory();
+	}
 	
+	statistics_.levels[level].galerkinTime = watch.elapsed();
+	levelMemory += matrixMemory(*coarseMatrix);
+	peakMemory = std::max(peakMemory, hierarchyMemory+levelMemory);
+	hierarchyMemory += levelMemory;
 	if(criterion.debugLevel()>2){
 	  if(rank==0)
 	    std::cout<<"Calculation of Galerkin product took "<<watch.elapsed()<<" seconds."<<std::endl;
@@ -934,6 +1174,10 @@ namespace Dune
       built_=true;
       AggregatesMap* aggregatesMap=new AggregatesMap(0);
       aggregatesMaps_.push_back(aggregatesMap);
+      prolongations_.push_back(0);
+      transferOperators_.push_back(0);
+      entryMaps_.push_back(0);
+      tripleProducts_.push_back(0);
 
       if(criterion.debugLevel()>0){
 	if(level==criterion.maxLevel()){
@@ -949,13 +1193,6 @@ namespace Dune
 
       if(criterion.accumulate() && !redistributes_.back().isSetup() && 
 	 infoLevel->communicator().size()>1){ 
-#if HAVE_MPI && !HAVE_PARMETIS
-	if(criterion.accumulate()==successiveAccu &&
-	   infoLevel->communicator().rank()==0)
-	  std::cerr<<"Successive accumulation of data on coarse levels only works with ParMETIS installed."
-		   <<"  Fell back to accumulation to one domain on coarsest level"<<std::endl;
-#endif
-	  
 	// accumulate to fewer processors
 	Matrix* redistMat= new Matrix();
 	ParallelInformation* redistComm=0;
@@ -980,6 +1217,9 @@ namespace Dune
 	int levels = matrices_.levels();
 	maxlevels_ = parallelInformation_.finest()->communicator().max(levels);
 	assert(matrices_.levels()==redistributes_.size());
+	updateLevelSizes();
+	statistics_.peakSetupMemory = std::max(peakMemory, statistics_.memory());
+	statistics_.setupTime = buildWatch.elapsed();
 	if(hasCoarsest() && rank==0 && criterion.debugLevel()>1)
 	  std::cout<<"operator complexity: "<<allnonzeros.todouble()/finenonzeros.todouble()<<std::endl;
 
@@ -1080,6 +1320,59 @@ namespace Dune
       return redistributes_;
     }
     
+    template<class M, class IS, class A>
+    const typename MatrixHierarchy<M,IS,A>::ProlongationList& 
+    MatrixHierarchy<M,IS,A>::prolongations() const 
+    {
+      return prolongations_;
+    }
+    
+    template<class M, class IS, class A>
+    const typename MatrixHierarchy<M,IS,A>::TransferOperatorList& 
+    MatrixHierarchy<M,IS,A>::transferOperators() const 
+    {
+      return transferOperators_;
+    }
+    
+    template<class M, class IS, class A>
+    const AMGStatistics& MatrixHierarchy<M,IS,A>::statistics() const
+    {
+      return statistics_;
+    }
+
+    template<class M, class IS, class A>
+    void MatrixHierarchy<M,IS,A>::updateLevelSizes()
+    {
+      typedef typename ParallelMatrixHierarchy::Iterator Iterator;
+      statistics_.levels.resize(matrices_.levels());
+      typename AggregatesMapList::const_iterator amap = aggregatesMaps_.begin();
+      typename ProlongationList::const_iterator prolongation = prolongations_.begin();
+      typename TransferOperatorList::const_iterator transfer = transferOperators_.begin();
+      typename EntryMapList::const_iterator entryMap = entryMaps_.begin();
+      typename TripleProductList::const_iterator tripleProduct = tripleProducts_.begin();
+      std::size_t l=0;
+      for(Iterator level=matrices_.finest(); ; ++level, ++l){
+        AMGLevelStatistics& stats = statistics_.levels[l];
+        stats.rows = level->getmat().N();
+        stats.nonzeros = countNonZeros(level->getmat());
+        stats.memory = matrixMemory(level->getmat());
+        if(amap!=aggregatesMaps_.end()){
+          stats.memory += (*amap)->noVertices()*sizeof(typename AggregatesMap::AggregateDescriptor);
+          if(*prolongation)
+            stats.memory += matrixMemory(**prolongation);
+          if(*transfer)
+            stats.memory += (*transfer)->memory();
+          if(*entryMap)
+            stats.memory += (*entryMap)->memory();
+          if(*tripleProduct)
+            stats.memory += (*tripleProduct)->memory();
+          ++amap, ++prolongation, ++transfer, ++entryMap, ++tripleProduct;
+        }
+        if(level==matrices_.coarsest())
+          break;
+      }
+    }
+
     template<class M, class IS, class A>
     MatrixHierarchy<M,IS,A>::~MatrixHierarchy()
     {
@@ -1097,6 +1390,18 @@ namespace Dune
 	  delete &(level.getRedistributed().getmat());
       }
       delete *amap;
+      typedef typename ProlongationList::iterator ProlongationIterator;
+      for(ProlongationIterator p=prolongations_.begin(); p != prolongations_.end(); ++p)
+        delete *p;
+      typedef typename TransferOperatorList::iterator TransferIterator;
+      for(TransferIterator t=transferOperators_.begin(); t != transferOperators_.end(); ++t)
+        delete *t;
+      typedef typename EntryMapList::iterator EntryMapIterator;
+      for(EntryMapIterator e=entryMaps_.begin(); e != entryMaps_.end(); ++e)
+        delete *e;
+      typedef typename TripleProductList::iterator TripleProductIterator;
+      for(TripleProductIterator t=tripleProducts_.begin(); t != tripleProducts_.end(); ++t)
+        delete *t;
     }
 
     template<class M, class IS, class A>
@@ -1129,29 +1434,48 @@ namespace Dune
     template<class M, class IS, class A>
     template<class S, class TA>
     void MatrixHierarchy<M,IS,A>::coarsenSmoother(Hierarchy<S,TA>& smoothers, 
-						    const typename SmootherTraits<S>::Arguments& sargs) const
+						    const typename SmootherTraits<S>::Arguments& sargs,
+                                                  AMGStatistics* statistics) const
+    {
+      coarsenSmoother(smoothers, std::vector<typename SmootherTraits<S>::Arguments>(1, sargs),
+                      statistics);
+    }
+
+    template<class M, class IS, class A>
+    template<class S, class TA>
+    void MatrixHierarchy<M,IS,A>::coarsenSmoother(Hierarchy<S,TA>& smoothers,
+                                                  const std::vector<typename SmootherTraits<S>::Arguments>& sargs,
+                                                  AMGStatistics* statistics) const
     {
       assert(smoothers.levels()==0);
+      assert(!sargs.empty());
       typedef typename ParallelMatrixHierarchy::ConstIterator MatrixIterator;
       typedef typename ParallelInformationHierarchy::ConstIterator PinfoIterator;
       typedef typename AggregatesMapList::const_iterator AggregatesIterator;
       
       typename ConstructionTraits<S>::Arguments cargs;
-      cargs.setArgs(sargs);
       PinfoIterator pinfo = parallelInformation_.finest();
       AggregatesIterator aggregates = aggregatesMaps_.begin();
       int level=0;
       for(MatrixIterator matrix = matrices_.finest(), coarsest = matrices_.coarsest(); 
 	  matrix != coarsest; ++matrix, ++pinfo, ++aggregates, ++level){
+        Timer watch;
+        cargs.setArgs(sargs[std::min<std::size_t>(level, sargs.size()-1)]);
 	cargs.setMatrix(matrix->getmat(), **aggregates);
 	cargs.setComm(*pinfo);
 	smoothers.addCoarser(cargs);
+        if(statistics && level<static_cast<int>(statistics->levels.size()))
+          statistics->levels[level].smootherSetupTime = watch.elapsed();
       }
       if(maxlevels()>levels()){
 	// This is not the globally coarsest level and therefore smoothing is needed
+        Timer watch;
+        cargs.setArgs(sargs[std::min<std::size_t>(level, sargs.size()-1)]);
 	cargs.setMatrix(matrices_.coarsest()->getmat(), **aggregates);
 	cargs.setComm(*pinfo);
 	smoothers.addCoarser(cargs);
+        if(statistics && level<static_cast<int>(statistics->levels.size()))
+          statistics->levels[level].smootherSetupTime = watch.elapsed();
 	++level;
       }
     }
@@ -1165,32 +1489,194 @@ namespace Dune
       typedef typename ParallelInformationHierarchy::Iterator InfoIterator;
       
       AggregatesMapIterator amap = aggregatesMaps_.begin();
-      BaseGalerkinProduct productBuilder;
+      typename ProlongationList::iterator prolongation = prolongations_.begin();
+      typename TransferOperatorList::iterator transfer = transferOperators_.begin();
+      typename EntryMapList::iterator entryMap = entryMaps_.begin();
+      typename TripleProductList::iterator tripleProduct = tripleProducts_.begin();
       InfoIterator info = parallelInformation_.finest();
       typename RedistributeInfoList::iterator riIter = redistributes_.begin();
       Iterator level = matrices_.finest(), coarsest=matrices_.coarsest();
-      if(level.isRedistributed()){
-        info->buildGlobalLookup(info->indexSet().size());
-        redistributeMatrixEntries(const_cast<Matrix&>(level->getmat()), 
-                                  const_cast<Matrix&>(level.getRedistributed().getmat()),
-                                  *info,info.getRedistributed(), *riIter);
-        info->freeGlobalLookup();
-      }
+      if(level.isRedistributed())
+        redistributeMatrixAmg(const_cast<Matrix&>(level->getmat()), 
+                              const_cast<Matrix&>(level.getRedistributed().getmat()),
+                              *info, info.getRedistributed(), *riIter);
       
-      for(; level!=coarsest; ++amap){
+      for(std::size_t l=0; level!=coarsest; ++amap, ++prolongation, ++transfer, ++entryMap, ++tripleProduct, ++l){
+        Timer watch;
 	const Matrix& fine = (level.isRedistributed()?level.getRedistributed():*level).getmat();
 	++level;
 	++info;
         ++riIter;
-	productBuilder.calculate(fine, *(*amap), const_cast<Matrix&>(level->getmat()), *info, copyFlags);
-	if(level.isRedistributed()){
-        info->buildGlobalLookup(info->indexSet().size());
-          redistributeMatrixEntries(const_cast<Matrix&>(level->getmat()), 
-                                    const_cast<Matrix&>(level.getRedistributed().getmat()), *info,
-                                    info.getRedistributed(), *riIter);
-          info->freeGlobalLookup();
+	if(*prolongation){
+	  // smoothed aggregation, recompute prolongation and coarse matrix
+	  calculateSmoothedProlongation(fine, *(*amap), smoothingFactor_, **prolongation);
+	  if(*tripleProduct)
+	    (*tripleProduct)->calculate(**prolongation, fine, const_cast<Matrix&>(level->getmat()));
+	  else if(leanSetup_){
+	    TripleProduct product;
+	    product.setup(**prolongation, fine, const_cast<Matrix&>(level->getmat()));
+	  }else{
+	    *tripleProduct = new TripleProduct();
+	    (*tripleProduct)->setup(**prolongation, fine, const_cast<Matrix&>(level->getmat()));
+	  }
+	  if(*transfer)
+	    (*transfer)->setup(**prolongation);
+	}else if(!*entryMap && leanSetup_){
+	  BaseGalerkinProduct productBuilder;
+	  productBuilder.calculate(fine, *(*amap), const_cast<Matrix&>(level->getmat()), *info, copyFlags);
+	}else{
+	  if(!*entryMap){
+	    *entryMap = new EntryMap();
+	    (*entryMap)->setup(fine, *(*amap), level->getmat());
+	  }
+	  (*entryMap)->calculate(fine, const_cast<Matrix&>(level->getmat()), *info);
+	}
+        if(l<statistics_.levels.size())
+          statistics_.levels[l].galerkinTime = watch.elapsed();
+	if(level.isRedistributed())
+          redistributeMatrixAmg(const_cast<Matrix&>(level->getmat()), 
+                                const_cast<Matrix&>(level.getRedistributed().getmat()),
+                                *info, info.getRedistributed(), *riIter);
+      }
+    }
+
+    template<class M, class IS, class A>
+    const char MatrixHierarchy<M,IS,A>::hierarchyMagic_[8] = {'D','U','N','E','A','M','G','H'};
+
+    template<class M, class IS, class A>
+    const int MatrixHierarchy<M,IS,A>::hierarchyVersion_ = 1;
+
+    template<class M, class IS, class A>
+    void MatrixHierarchy<M,IS,A>::save(std::ostream& os) const
+    {
+      typedef typename Matrix::block_type Block;
+      typedef typename Matrix::field_type field_type;
+      typedef typename ParallelMatrixHierarchy::ConstIterator MatIterator;
+      typedef typename ParallelInformationHierarchy::ConstIterator PInfoIterator;
+
+      if(!built_)
+        DUNE_THROW(ISTLError, "The hierarchy has to be built before it can be saved!");
+      typedef typename RedistributeInfoList::const_iterator RedistributeIterator;
+      for(RedistributeIterator ri=redistributes_.begin(); ri != redistributes_.end(); ++ri)
+        if(ri->isSetup())
+          DUNE_THROW(NotImplemented, "Saving hierarchies with redistributed levels is not supported!");
+
+      writeBinary(os, hierarchyMagic_, 8);
+      writeBinary(os, hierarchyVersion_);
+      writeBinary(os, static_cast<int>(sizeof(field_type)));
+      writeBinary(os, static_cast<int>(Block::rows));
+      writeBinary(os, static_cast<int>(Block::cols));
+      writeBinary(os, matrices_.levels());
+      writeBinary(os, prolongDamp_);
+      writeBinary(os, smoothingFactor_);
+      writeBinary(os, matrices_.finest()->getmat().N());
+
+      typename AggregatesMapList::const_iterator amap = aggregatesMaps_.begin();
+      typename ProlongationList::const_iterator prolongation = prolongations_.begin();
+      typename TransferOperatorList::const_iterator transfer = transferOperators_.begin();
+      PInfoIterator info = parallelInformation_.finest();
+      for(MatIterator level = matrices_.finest(), coarsest = matrices_.coarsest();
+          level != coarsest; ++amap, ++prolongation, ++transfer){
+        ++level;
+        ++info;
+        writeAggregatesMap(os, **amap);
+        writeBinary(os, static_cast<char>(*prolongation!=0));
+        if(*prolongation)
+          writeMatrix(os, **prolongation);
+        writeBinary(os, static_cast<char>(*transfer!=0));
+        writeMatrix(os, level->getmat());
+        ParallelInformationIO<ParallelInformation>::write(os, *info);
+      }
+    }
+
+    template<class M, class IS, class A>
+    void MatrixHierarchy<M,IS,A>::load(std::istream& is)
+    {
+      typedef typename Matrix::block_type Block;
+      typedef typename Matrix::field_type field_type;
+      typedef typename ParallelInformationHierarchy::Iterator PInfoIterator;
+
+      if(built_ || matrices_.levels()>1)
+        DUNE_THROW(ISTLError, "Can only load into a hierarchy that was not built yet!");
+      Timer loadWatch;
+      statistics_ = AMGStatistics();
+
+      char magic[8];
+      int version, fieldSize, rows, cols;
+      std::size_t levels, fineSize;
+      readBinary(is, magic, 8);
+      if(!std::equal(magic, magic+8, hierarchyMagic_))
+        DUNE_THROW(ISTLError, "The stream does not contain an AMG hierarchy!");
+      readBinary(is, version);
+      readBinary(is, fieldSize);
+      readBinary(is, rows);
+      readBinary(is, cols);
+      if(version!=hierarchyVersion_ || fieldSize!=static_cast<int>(sizeof(field_type))
+         || rows!=static_cast<int>(Block::rows) || cols!=static_cast<int>(Block::cols))
+        DUNE_THROW(ISTLError, "The stored hierarchy does not match the matrix type!");
+      readBinary(is, levels);
+      readBinary(is, prolongDamp_);
+      readBinary(is, smoothingFactor_);
+      readBinary(is, fineSize);
+      if(fineSize!=matrices_.finest()->getmat().N())
+        DUNE_THROW(ISTLError, "The stored hierarchy was built for a fine matrix with "
+                   <<fineSize<<" rows, not "<<matrices_.finest()->getmat().N()<<"!");
+
+      PInfoIterator infoLevel = parallelInformation_.finest();
+      redistributes_.push_back(RedistributeInfoType());
+
+      for(std::size_t level=1; level < levels; ++level){
+        AggregatesMap* aggregatesMap = new AggregatesMap();
+        readAggregatesMap(is, *aggregatesMap);
+        char flag;
+        readBinary(is, flag);
+        Matrix* prolongation = 0;
+        if(flag){
+          prolongation = new Matrix();
+          readMatrix(is, *prolongation);
         }
+        readBinary(is, flag);
+        Matrix* coarseMatrix = new Matrix();
+        readMatrix(is, *coarseMatrix);
+
+        TransferOperator* transfer = 0;
+        if(flag){
+          transfer = new TransferOperator();
+          if(prolongation)
+            transfer->setup(*prolongation);
+          else
+            transfer->setup(*aggregatesMap, coarseMatrix->N());
+        }
+
+        aggregatesMaps_.push_back(aggregatesMap);
+        prolongations_.push_back(prolongation);
+        transferOperators_.push_back(transfer);
+        // the caches for recalculateGalerkin are set up on demand
+        entryMaps_.push_back(0);
+        tripleProducts_.push_back(0);
+
+        CommunicationArgs commargs(infoLevel->communicator(),infoLevel->getSolverCategory());
+        parallelInformation_.addCoarser(commargs);
+        ++infoLevel;
+        ParallelInformationIO<ParallelInformation>::read(is, *infoLevel);
+
+        MatrixArgs args(*coarseMatrix, *infoLevel);
+        matrices_.addCoarser(args);
+        redistributes_.push_back(RedistributeInfoType());
       }
+
+      built_=true;
+      aggregatesMaps_.push_back(new AggregatesMap(0));
+      prolongations_.push_back(0);
+      transferOperators_.push_back(0);
+      entryMaps_.push_back(0);
+      tripleProducts_.push_back(0);
+
+      int mylevels = matrices_.levels();
+      maxlevels_ = parallelInformation_.finest()->communicator().max(mylevels);
+      updateLevelSizes();
+      statistics_.peakSetupMemory = statistics_.memory();
+      statistics_.setupTime = loadWatch.elapsed();
     }
 
     template<class M, class IS, class A>
@@ -1238,6 +1724,12 @@ namespace Dune
 
     template<class T, class A>
     Hierarchy<T,A>::~Hierarchy()
+    {
+      clear();
+    }
+
+    template<class T, class A>
+    void Hierarchy<T,A>::clear()
     {
       while(coarsest_){
 	Element* current = coarsest_;
@@ -1250,6 +1742,8 @@ namespace Dune
 	allocator_.deallocate(current, 1);
 	//coarsest_->coarser_ = 0;
       }
+      finest_ = nonAllocated_ = 0;
+      levels_ = 0;
     }
 
     template<class T, class A>
@@ -0,0 +1,306 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_HIERARCHYIO_HH
+#define DUNE_AMG_HIERARCHYIO_HH
+
+#include"aggregates.hh"
+#include"pinfo.hh"
+#include<dune/istl/istlexception.hh>
+#include<cstddef>
+#include<istream>
+#include<numeric>
+#include<ostream>
+#include<vector>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief Binary input and output of the data of a matrix hierarchy.
+     *
+     * The data is stored in the native binary representation. The files
+     * are therefore only meant to be read again on the same platform and
+     * with the same number of processes, e.g. when restarting from a
+     * checkpoint.
+     */
+
+    /**
+     * @brief Write a value in binary representation.
+     * @param os The stream to write to.
+     * @param t The value to write.
+     */
+    template<class T>
+    void writeBinary(std::ostream& os, const T& t)
+    {
+      os.write(reinterpret_cast<const char*>(&t), sizeof(T));
+      if(!os)
+        DUNE_THROW(ISTLError, "Writing to the stream failed!");
+    }
+
+    /**
+     * @brief Read a value written by writeBinary.
+     * @param is The stream to read from.
+     * @param t The value to read.
+     */
+    template<class T>
+    void readBinary(std::istream& is, T& t)
+    {
+      is.read(reinterpret_cast<char*>(&t), sizeof(T));
+      if(!is)
+        DUNE_THROW(ISTLError, "Reading from the stream failed!");
+    }
+
+    /**
+     * @brief Write an array of values in binary representation.
+     * @param os The stream to write to.
+     * @param t Pointer to the first value.
+     * @param n The number of values.
+     */
+    template<class T>
+    void writeBinary(std::ostream& os, const T* t, std::size_t n)
+    {
+      if(n>0)
+        os.write(reinterpret_cast<const char*>(t), n*sizeof(T));
+      if(!os)
+        DUNE_THROW(ISTLError, "Writing to the stream failed!");
+    }
+
+    /**
+     * @brief Read an array of values written by writeBinary.
+     * @param is The stream to read from.
+     * @param t Pointer to the first value to read.
+     * @param n The number of values.
+     */
+    template<class T>
+    void readBinary(std::istream& is, T* t, std::size_t n)
+    {
+      if(n>0)
+        is.read(reinterpret_cast<char*>(t), n*sizeof(T));
+      if(!is)
+        DUNE_THROW(ISTLError, "Reading from the stream failed!");
+    }
+
+    /**
+     * @brief Write the entries of a vector in binary representation.
+     *
+     * The size is not written.
+     * @param os The stream to write to.
+     * @param v The vector, may be empty.
+     */
+    template<class T, class A>
+    void writeBinary(std::ostream& os, const std::vector<T,A>& v)
+    {
+      if(!v.empty())
+        writeBinary(os, &v[0], v.size());
+    }
+
+    /**
+     * @brief Read the entries of a vector written by writeBinary.
+     * @param is The stream to read from.
+     * @param v The vector to read, has to have the right size already.
+     */
+    template<class T, class A>
+    void readBinary(std::istream& is, std::vector<T,A>& v)
+    {
+      if(!v.empty())
+        readBinary(is, &v[0], v.size());
+    }
+
+    /**
+     * @brief Write a sparse matrix in binary representation.
+     *
+     * The sizes, the sparsity pattern and the entries are written.
+     * @param os The stream to write to.
+     * @param matrix The matrix to write.
+     */
+    template<class M>
+    void writeMatrix(std::ostream& os, const M& matrix)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+      typedef typename M::block_type Block;
+      typedef typename M::field_type field_type;
+      typedef typename M::size_type size_type;
+
+      // nonzeroes() is only valid if the matrix was set up with it
+      std::vector<size_type> rowSizes;
+      std::vector<size_type> columns;
+      std::vector<field_type> values;
+      rowSizes.reserve(matrix.N());
+
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row){
+        rowSizes.push_back(row->size());
+        for(ColIterator col=row->begin(); col!=row->end(); ++col){
+          columns.push_back(col.index());
+          for(int i=0; i<Block::rows; ++i)
+            for(int j=0; j<Block::cols; ++j)
+              values.push_back((*col)[i][j]);
+        }
+      }
+      writeBinary(os, matrix.N());
+      writeBinary(os, matrix.M());
+      writeBinary(os, columns.size());
+      writeBinary(os, rowSizes);
+      writeBinary(os, columns);
+      writeBinary(os, values);
+    }
+
+    /**
+     * @brief Read a sparse matrix written by writeMatrix.
+     * @param is The stream to read from.
+     * @param matrix The matrix to set up. Any previous content is lost.
+     */
+    template<class M>
+    void readMatrix(std::istream& is, M& matrix)
+    {
+      typedef typename M::RowIterator RowIterator;
+      typedef typename M::ColIterator ColIterator;
+      typedef typename M::block_type Block;
+      typedef typename M::field_type field_type;
+      typedef typename M::size_type size_type;
+
+      size_type n, m, nnz;
+      readBinary(is, n);
+      readBinary(is, m);
+      readBinary(is, nnz);
+
+      std::vector<size_type> rowSizes(n);
+      readBinary(is, rowSizes);
+      if(std::accumulate(rowSizes.begin(), rowSizes.end(), size_type(0))!=nnz)
+        DUNE_THROW(ISTLError, "The row sizes do not add up to the "<<nnz<<" nonzeroes!");
+
+      std::vector<size_type> columns(nnz);
+      std::vector<field_type> values(nnz*Block::rows*Block::cols);
+      readBinary(is, columns);
+      readBinary(is, values);
+
+      matrix.setSize(n, m, nnz);
+      matrix.setBuildMode(M::row_wise);
+      size_type i=0, k=0;
+      for(typename M::CreateIterator ci=matrix.createbegin(); ci!=matrix.createend(); ++ci, ++i)
+        for(size_type j=0; j<rowSizes[i]; ++j, ++k){
+          if(columns[k]>=m)
+            DUNE_THROW(ISTLError, "Column index "<<columns[k]<<" is out of range!");
+          ci.insert(columns[k]);
+        }
+
+      typename std::vector<field_type>::const_iterator value=values.begin();
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row)
+        for(ColIterator col=row->begin(); col!=row->end(); ++col)
+          for(int i=0; i<Block::rows; ++i)
+            for(int j=0; j<Block::cols; ++j, ++value)
+              (*col)[i][j]=*value;
+    }
+
+    /**
+     * @brief Write the mapping of the vertices onto the aggregates.
+     * @param os The stream to write to.
+     * @param aggregates The aggregates map to write.
+     */
+    template<class V>
+    void writeAggregatesMap(std::ostream& os, const AggregatesMap<V>& aggregates)
+    {
+      std::size_t n=aggregates.noVertices();
+      writeBinary(os, n);
+      if(n>0)
+        writeBinary(os, &aggregates[0], n);
+    }
+
+    /**
+     * @brief Read an aggregates map written by writeAggregatesMap.
+     * @param is The stream to read from.
+     * @param aggregates The aggregates map to set up, has to be empty.
+     */
+    template<class V>
+    void readAggregatesMap(std::istream& is, AggregatesMap<V>& aggregates)
+    {
+      std::size_t n;
+      readBinary(is, n);
+      aggregates.allocate(n);
+      if(n>0)
+        readBinary(is, &aggregates[0], n);
+    }
+
+    /**
+     * @brief Binary input and output of the parallel information of a level.
+     *
+     * The index set is stored. After reading it the remote indices are
+     * rebuilt, which needs communication with the neighbouring processes.
+     * @tparam T The type of the parallel information, e.g.
+     * OwnerOverlapCopyCommunication.
+     */
+    template<class T>
+    struct ParallelInformationIO
+    {
+      /**
+       * @brief Write the index set.
+       * @param os The stream to write to.
+       * @param info The parallel information to write.
+       */
+      static void write(std::ostream& os, const T& info)
+      {
+        typedef typename T::ParallelIndexSet::const_iterator Iterator;
+        writeBinary(os, info.indexSet().size());
+        for(Iterator index=info.indexSet().begin(); index!=info.indexSet().end(); ++index){
+          writeBinary(os, index->global());
+          std::size_t local=index->local().local();
+          writeBinary(os, local);
+          int attribute=index->local().attribute();
+          writeBinary(os, attribute);
+          char isPublic=index->local().isPublic();
+          writeBinary(os, isPublic);
+        }
+      }
+
+      /**
+       * @brief Read the index set and rebuild the remote indices.
+       * @param is The stream to read from.
+       * @param info The parallel information with an empty index set.
+       */
+      static void read(std::istream& is, T& info)
+      {
+        typedef typename T::ParallelIndexSet IndexSet;
+        typedef typename IndexSet::GlobalIndex GlobalIndex;
+        typedef typename IndexSet::LocalIndex LocalIndex;
+        typedef typename LocalIndex::Attribute Attribute;
+
+        std::size_t size;
+        readBinary(is, size);
+        info.indexSet().beginResize();
+        for(std::size_t i=0; i<size; ++i){
+          GlobalIndex global;
+          std::size_t local;
+          int attribute;
+          char isPublic;
+          readBinary(is, global);
+          readBinary(is, local);
+          readBinary(is, attribute);
+          readBinary(is, isPublic);
+          info.indexSet().add(global, LocalIndex(local, static_cast<Attribute>(attribute),
+                                                 isPublic!=0));
+        }
+        info.indexSet().endResize();
+        info.remoteIndices().template rebuild<false>();
+      }
+    };
+
+    template<>
+    struct ParallelInformationIO<SequentialInformation>
+    {
+      static void write(std::ostream&, const SequentialInformation&)
+      {}
+
+      static void read(std::istream&, SequentialInformation&)
+      {}
+    };
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
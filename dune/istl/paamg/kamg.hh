@@ -70,16 +70,24 @@ namespace Dune
           amg_.moveToCoarseLevel();
 
         if(processFineLevel){
-          typename AMG::Range b=*amg_.rhs;
-          typename AMG::Domain x=*amg_.update;
-          InverseOperatorResult res;
-          coarseSolver_->apply(x, b, res);
-          *amg_.update=x;
+          if(amg_.matrix == amg_.matrices_->matrices().coarsest() && amg_.levels()==amg_.maxlevels())
+            // The AMG knows how to solve on the globally coarsest level,
+            // even if it was agglomerated onto fewer processes.
+            amg_.mgc();
+          else{
+            typename AMG::Range b=*amg_.rhs;
+            typename AMG::Domain x=*amg_.update;
+            InverseOperatorResult res;
+            coarseSolver_->apply(x, b, res);
+            *amg_.update=x;
+          }
         }
         
         amg_.moveToFineLevel(processFineLevel);
         
         amg_.postsmooth();
+        if(amg_.postSteps(amg_.level)==0)
+          amg_.pinfo->copyOwnerToAll(*amg_.update, *amg_.update);
         v=*amg_.update;
       }
 
@@ -108,6 +116,11 @@ namespace Dune
     /**
      * @brief an algebraic multigrid method using a Krylov-cycle.
      *
+     * In the parallel case the Krylov method of each level uses the
+     * scalar product of the parallel information of that level. Thus
+     * on levels that were agglomerated onto fewer processes only those
+     * take part in the reductions.
+     *
      * @tparam M The type of the linear operator.
      * @tparam X The type of the range and domain.
      * @tparam PI The parallel information object. Use SequentialInformation (default)
@@ -300,11 +313,9 @@ namespace Dune
     {
       amg.initIteratorsWithFineLevel();
       if(ksolvers.size()==0)
-        {
-          Range tb=b;
-          InverseOperatorResult res;
-          amg.solver_->apply(x,tb,res);
-        }else
+        // only one level
+        amg.apply(x,b);
+      else
         ksolvers.back()->apply(x,b);
     }
 
@@ -0,0 +1,366 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_L1SMOOTHER_HH
+#define DUNE_AMG_L1SMOOTHER_HH
+
+#include<cmath>
+#include<cstddef>
+#include<vector>
+#ifdef _OPENMP
+#include<omp.h>
+#endif
+#include<dune/common/typetraits.hh>
+#include<dune/istl/preconditioners.hh>
+#include<dune/istl/solvercategory.hh>
+#include<dune/istl/paamg/pinfo.hh>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief Smoothers with l1 scaled diagonals.
+     *
+     * The rows of the matrix are split into blocks that are relaxed
+     * independently of each other: one block per process (and per
+     * thread) for the hybrid Gauss-Seidel, one block per row for
+     * Jacobi. The couplings to other blocks are not treated
+     * implicitly. Adding their absolute row sums to the diagonal
+     * keeps the smoothers convergent for any number of blocks, hence
+     * the convergence of the AMG does not degrade with the number of
+     * processes and threads. See Baker, Falgout, Kolev and Yang,
+     * "Multigrid smoothers for ultraparallel computing", SISC 33 (2011).
+     */
+
+    /**
+     * @brief Compute the inverses of the l1 scaled diagonal blocks.
+     *
+     * For each scalar row the sum of the absolute values of the
+     * entries in the columns of other blocks is added to the diagonal.
+     * @param A The matrix.
+     * @param block The block of each row. Columns j with
+     * block[j]!=block[i] are outside the block of row i.
+     * @param diag Will store the inverted scaled diagonal blocks.
+     */
+    template<class M, class B>
+    void computeL1Diagonal(const M& A, const std::vector<std::ptrdiff_t>& block,
+                           std::vector<B>& diag)
+    {
+      typedef typename M::ConstColIterator ColIterator;
+      const std::ptrdiff_t n=A.N();
+      diag.resize(n);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for(std::ptrdiff_t i=0; i<n; ++i){
+        B& d=diag[i];
+        d=0;
+        const ColIterator end=A[i].end();
+        for(ColIterator col=A[i].begin(); col!=end; ++col)
+          if(static_cast<std::ptrdiff_t>(col.index())==i)
+            d+=*col;
+          else if(block[col.index()]!=block[i])
+            for(int k=0; k<B::rows; ++k)
+              for(int m=0; m<B::cols; ++m)
+                d[k][k]+=std::abs((*col)[k][m]);
+        d.invert();
+      }
+    }
+
+    /**
+     * @brief Mark the rows owned by this process.
+     *
+     * Uses the projection of the communication, which clears the
+     * entries that are not owned.
+     * @param c The communication object, e.g. OwnerOverlapCopyCommunication.
+     * @param n The number of rows.
+     * @param owner Will store whether a row is owned.
+     */
+    template<class X, class C>
+    void markOwnerRows(const C& c, std::size_t n, std::vector<bool>& owner)
+    {
+      X mask(n);
+      mask=1;
+      c.project(mask);
+      owner.resize(n);
+      for(std::size_t i=0; i<n; ++i)
+        owner[i]= mask[i][0]!=0;
+    }
+
+    /**
+     * @brief Jacobi smoother with l1 scaled diagonal.
+     *
+     * The diagonal of each row is increased by the absolute sum of its
+     * off-diagonal entries. Therefore no damping is needed for
+     * convergence in the symmetric positive definite case, independently
+     * of the distribution of the matrix. The rows are relaxed
+     * concurrently if OpenMP is enabled.
+     *
+     * @tparam M The matrix type to operate on.
+     * @tparam X Type of the update.
+     * @tparam Y Type of the defect.
+     * @tparam C The communication object, SequentialInformation for
+     * the sequential smoother.
+     */
+    template<class M, class X, class Y, class C=SequentialInformation>
+    class L1Jacobi : public Preconditioner<X,Y>
+    {
+    public:
+      //! \brief The matrix type the preconditioner is for.
+      typedef M matrix_type;
+      //! \brief The domain type of the preconditioner.
+      typedef X domain_type;
+      //! \brief The range type of the preconditioner.
+      typedef Y range_type;
+      //! \brief The field type of the preconditioner.
+      typedef typename X::field_type field_type;
+      //! \brief The type of the communication object.
+      typedef C communication_type;
+
+      // define the category
+      enum {
+        //! \brief The category the preconditioner is part of.
+        category=is_same<C,SequentialInformation>::value ?
+        static_cast<int>(SolverCategory::sequential) : static_cast<int>(SolverCategory::overlapping)
+      };
+
+      /**
+       * @brief Constructor.
+       * @param A The matrix to operate on.
+       * @param n The number of iterations to perform.
+       * @param w The relaxation factor.
+       * @param c The communication object for syncing overlap and copy
+       * data points.
+       */
+      L1Jacobi(const M& A, int n, field_type w, const C& c)
+        : A_(A), n_(n), w_(w), communication_(c)
+      {
+        std::vector<std::ptrdiff_t> block(A.N());
+        for(std::size_t i=0; i<A.N(); ++i)
+          block[i]=i;
+        computeL1Diagonal(A, block, diag_);
+      }
+
+      /**
+       * @brief Prepare the preconditioner.
+       *
+       * \copydoc Preconditioner::pre(X&,Y&)
+       */
+      virtual void pre(X& x, Y& b)
+      {
+        communication_.copyOwnerToAll(x,x);
+      }
+
+      /**
+       * @brief Apply the preconditioner.
+       *
+       * \copydoc Preconditioner::apply(X&,const Y&)
+       */
+      virtual void apply(X& v, const Y& d)
+      {
+        typedef typename M::ConstColIterator ColIterator;
+        const std::ptrdiff_t n=A_.N();
+        for(int step=0; step<n_; ++step){
+          const X old(v);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+          for(std::ptrdiff_t i=0; i<n; ++i){
+            typename Y::block_type r=d[i];
+            const ColIterator end=A_[i].end();
+            for(ColIterator col=A_[i].begin(); col!=end; ++col)
+              col->mmv(old[col.index()], r);
+            typename X::block_type c;
+            diag_[i].mv(r, c);
+            v[i].axpy(w_, c);
+          }
+          communication_.copyOwnerToAll(v,v);
+        }
+      }
+
+      /**
+       * @brief Clean up.
+       *
+       * \copydoc Preconditioner::post(X&)
+       */
+      virtual void post(X& x)
+      {}
+
+    private:
+      //! \brief The matrix we operate on.
+      const M& A_;
+      //! \brief The number of steps to do in apply.
+      int n_;
+      //! \brief The relaxation factor to use.
+      field_type w_;
+      //! \brief The communication object.
+      const C& communication_;
+      //! \brief The inverted l1 scaled diagonal blocks.
+      std::vector<typename M::block_type> diag_;
+    };
+
+    /**
+     * @brief Hybrid Gauss-Seidel smoother with l1 scaled diagonal.
+     *
+     * The owned rows of each process are split into one contiguous
+     * block per OpenMP thread. Within a block a Gauss-Seidel sweep is
+     * performed, the couplings to other blocks and to rows not owned are
+     * treated like in Jacobi, using the values from the start of the
+     * sweep. The absolute sums of these couplings are added to the
+     * diagonal.
+     *
+     * @tparam M The matrix type to operate on.
+     * @tparam X Type of the update.
+     * @tparam Y Type of the defect.
+     * @tparam C The communication object, SequentialInformation for
+     * the sequential smoother.
+     */
+    template<class M, class X, class Y, class C=SequentialInformation>
+    class L1GaussSeidel : public Preconditioner<X,Y>
+    {
+    public:
+      //! \brief The matrix type the preconditioner is for.
+      typedef M matrix_type;
+      //! \brief The domain type of the preconditioner.
+      typedef X domain_type;
+      //! \brief The range type of the preconditioner.
+      typedef Y range_type;
+      //! \brief The field type of the preconditioner.
+      typedef typename X::field_type field_type;
+      //! \brief The type of the communication object.
+      typedef C communication_type;
+
+      // define the category
+      enum {
+        //! \brief The category the preconditioner is part of.
+        category=is_same<C,SequentialInformation>::value ?
+        static_cast<int>(SolverCategory::sequential) : static_cast<int>(SolverCategory::overlapping)
+      };
+
+      /**
+       * @brief Constructor.
+       * @param A The matrix to operate on.
+       * @param n The number of iterations to perform.
+       * @param w The relaxation factor.
+       * @param c The communication object for syncing overlap and copy
+       * data points.
+       */
+      L1GaussSeidel(const M& A, int n, field_type w, const C& c)
+        : A_(A), n_(n), w_(w), communication_(c)
+      {
+        std::vector<bool> owner;
+        markOwnerRows<X>(c, A.N(), owner);
+
+        int threads=1;
+#ifdef _OPENMP
+        threads=omp_get_max_threads();
+#endif
+        const std::ptrdiff_t rows=A.N();
+        start_.resize(threads+1);
+        for(int t=0; t<=threads; ++t)
+          start_[t]=rows*t/threads;
+
+        // rows that are not owned form blocks of their own
+        block_.resize(rows);
+        for(int t=0; t<threads; ++t)
+          for(std::ptrdiff_t i=start_[t]; i<start_[t+1]; ++i)
+            block_[i]= owner[i] ? t : -1-i;
+        computeL1Diagonal(A, block_, diag_);
+      }
+
+      /**
+       * @brief Prepare the preconditioner.
+       *
+       * \copydoc Preconditioner::pre(X&,Y&)
+       */
+      virtual void pre(X& x, Y& b)
+      {
+        communication_.copyOwnerToAll(x,x);
+      }
+
+      /**
+       * @brief Apply the preconditioner.
+       *
+       * \copydoc Preconditioner::apply(X&,const Y&)
+       */
+      virtual void apply(X& v, const Y& d)
+      {
+        this->template apply<true>(v,d);
+      }
+
+      /**
+       * @brief Apply the preconditioner in a special direction.
+       *
+       * If forward is true the sweeps within the blocks start at the
+       * lowest index, else at the highest.
+       */
+      template<bool forward>
+      void apply(X& v, const Y& d)
+      {
+        const int blocks=start_.size()-1;
+        for(int step=0; step<n_; ++step){
+          const X old(v);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static,1)
+#endif
+          for(int t=0; t<blocks; ++t)
+            if(forward)
+              for(std::ptrdiff_t i=start_[t]; i<start_[t+1]; ++i)
+                relax(i, v, old, d);
+            else
+              for(std::ptrdiff_t i=start_[t+1]-1; i>=start_[t]; --i)
+                relax(i, v, old, d);
+          communication_.copyOwnerToAll(v,v);
+        }
+      }
+
+      /**
+       * @brief Clean up.
+       *
+       * \copydoc Preconditioner::post(X&)
+       */
+      virtual void post(X& x)
+      {}
+
+    private:
+      /** @brief Relax row i using the old values outside of its block. */
+      void relax(std::ptrdiff_t i, X& v, const X& old, const Y& d) const
+      {
+        typedef typename M::ConstColIterator ColIterator;
+        typename Y::block_type r=d[i];
+        const ColIterator end=A_[i].end();
+        for(ColIterator col=A_[i].begin(); col!=end; ++col)
+          if(block_[col.index()]==block_[i])
+            col->mmv(v[col.index()], r);
+          else
+            col->mmv(old[col.index()], r);
+        typename X::block_type c;
+        diag_[i].mv(r, c);
+        v[i].axpy(w_, c);
+      }
+
+      //! \brief The matrix we operate on.
+      const M& A_;
+      //! \brief The number of steps to do in apply.
+      int n_;
+      //! \brief The relaxation factor to use.
+      field_type w_;
+      //! \brief The communication object.
+      const C& communication_;
+      //! \brief The first row of each thread block and the end.
+      std::vector<std::ptrdiff_t> start_;
+      //! \brief The block of each row.
+      std::vector<std::ptrdiff_t> block_;
+      //! \brief The inverted l1 scaled diagonal blocks.
+      std::vector<typename M::block_type> diag_;
+    };
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
@@ -0,0 +1,342 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_MIXEDPRECISION_HH
+#define DUNE_AMG_MIXEDPRECISION_HH
+
+#include"amg.hh"
+#include<dune/istl/istlexception.hh>
+#include<dune/istl/operators.hh>
+#include<cstddef>
+#include<vector>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief An AMG that keeps the coarse levels in a lower precision.
+     *
+     * The coarse levels only compute a correction. Storing their matrices
+     * and smoothers in single precision halves their memory and bandwidth
+     * requirements, while the fine level with the defect computation stays
+     * in the precision of the original system.
+     */
+
+    /**
+     * @brief Copy a sparse matrix into one with a different field type.
+     *
+     * The sparsity pattern is copied and the entries are converted.
+     * @param from The matrix to copy.
+     * @param to The matrix to set up. Any previous content is lost.
+     */
+    template<class M1, class M2>
+    void convertMatrix(const M1& from, M2& to)
+    {
+      typedef typename M1::ConstRowIterator RowIterator;
+      typedef typename M1::ConstColIterator ColIterator;
+      typedef typename M1::block_type Block;
+      typedef typename M2::field_type field_type;
+
+      dune_static_assert(static_cast<int>(Block::rows)==static_cast<int>(M2::block_type::rows)
+                         && static_cast<int>(Block::cols)==static_cast<int>(M2::block_type::cols),
+                         "The block sizes of the matrices have to match!");
+
+      // nonzeroes() is only valid if the matrix was set up with it
+      typename M2::size_type nnz=0;
+      for(RowIterator row=from.begin(); row!=from.end(); ++row)
+        nnz+=row->size();
+
+      to.setSize(from.N(), from.M(), nnz);
+      to.setBuildMode(M2::row_wise);
+      RowIterator row=from.begin();
+      for(typename M2::CreateIterator ci=to.createbegin(); ci!=to.createend(); ++ci, ++row)
+        for(ColIterator col=row->begin(); col!=row->end(); ++col)
+          ci.insert(col.index());
+
+      row=from.begin();
+      for(typename M2::RowIterator trow=to.begin(); trow!=to.end(); ++trow, ++row){
+        typename M2::ColIterator tcol=trow->begin();
+        for(ColIterator col=row->begin(); col!=row->end(); ++col, ++tcol)
+          for(int i=0; i<Block::rows; ++i)
+            for(int j=0; j<Block::cols; ++j)
+              (*tcol)[i][j]=static_cast<field_type>((*col)[i][j]);
+      }
+    }
+
+    /**
+     * @brief Sequential AMG with the coarse levels in a different (lower)
+     * precision.
+     *
+     * The finest level is aggregated in the precision of the system.
+     * Its Galerkin product is converted to the coarse field type and the
+     * remaining hierarchy is built as an AMG of that type. Each cycle
+     * smoothes on the fine level, converts the restricted defect, applies
+     * one cycle of the coarse AMG and converts the prolongated correction
+     * back.
+     *
+     * Smoothed aggregation and explicit transfer operators are only
+     * used on the coarse levels, the first coarsening always uses plain
+     * aggregation.
+     *
+     * @tparam M The type of the fine level operator.
+     * @tparam X The type of the fine level vectors.
+     * @tparam S The type of the fine level smoother.
+     * @tparam CS The type of the smoother on the coarse levels, e.g.
+     * SeqSSOR<BCRSMatrix<FieldMatrix<float,n,n> >, BlockVector<FieldVector<float,n> >,
+     * BlockVector<FieldVector<float,n> > >. Its matrix and vector types
+     * determine those of the coarse levels.
+     */
+    template<class M, class X, class S, class CS>
+    class MixedPrecisionAMG : public Preconditioner<X,X>
+    {
+    public:
+      /** @brief The type of the fine level operator. */
+      typedef M Operator;
+      /** @brief The domain type. */
+      typedef X Domain;
+      /** @brief The range type. */
+      typedef X Range;
+      /** @brief The type of the fine level smoother. */
+      typedef S Smoother;
+      /** @brief The argument type for the construction of the fine level smoother. */
+      typedef typename SmootherTraits<Smoother>::Arguments SmootherArgs;
+      /** @brief The type of the coarse level smoothers. */
+      typedef CS CoarseSmoother;
+      /** @brief The argument type for the construction of the coarse level smoothers. */
+      typedef typename SmootherTraits<CoarseSmoother>::Arguments CoarseSmootherArgs;
+      /** @brief The type of the coarse level matrices. */
+      typedef typename CoarseSmoother::matrix_type CoarseMatrix;
+      /** @brief The type of the coarse level vectors. */
+      typedef typename CoarseSmoother::domain_type CoarseVector;
+      /** @brief The type of the coarse level operators. */
+      typedef MatrixAdapter<CoarseMatrix,CoarseVector,CoarseVector> CoarseOperator;
+      /** @brief The type of the AMG on the coarse levels. */
+      typedef AMG<CoarseOperator,CoarseVector,CoarseSmoother> CoarseAMG;
+
+      enum {
+        /** @brief The solver category. */
+        category = SolverCategory::sequential
+      };
+
+      /**
+       * @brief Build the mixed precision hierarchy.
+       *
+       * @param fineOperator The operator on the fine level.
+       * @param criterion The criterion for the aggregation of the fine
+       * level. Its numbers of pre and post smoothing steps and the
+       * prolongation damping factor are used on the fine level.
+       * @param smootherArgs The arguments for constructing the fine level
+       * smoother.
+       * @param coarseCriterion The criterion for the coarse AMG. It has to
+       * be set up for the coarse matrix type.
+       * @param coarseSmootherArgs The arguments for constructing the
+       * coarse level smoothers.
+       */
+      template<class C, class CC>
+      MixedPrecisionAMG(const Operator& fineOperator, const C& criterion,
+                        const SmootherArgs& smootherArgs, const CC& coarseCriterion,
+                        const CoarseSmootherArgs& coarseSmootherArgs);
+
+      ~MixedPrecisionAMG();
+
+      /** \copydoc Preconditioner::pre */
+      void pre(Domain& x, Range& b);
+
+      /** \copydoc Preconditioner::apply */
+      void apply(Domain& v, const Range& d);
+
+      /** \copydoc Preconditioner::post */
+      void post(Domain& x);
+
+      /**
+       * @brief Get the AMG used on the coarse levels.
+       *
+       * Its statistics describe the coarse levels, the finest of them
+       * is the first coarse level of the whole hierarchy.
+       */
+      const CoarseAMG& coarseAMG() const
+      {
+        return *coarseAmg_;
+      }
+
+    private:
+      typedef typename MatrixGraph<typename M::matrix_type>::VertexDescriptor Vertex;
+      typedef Dune::Amg::AggregatesMap<Vertex> AggregatesMap;
+      typedef typename CoarseMatrix::field_type coarse_field_type;
+
+      /** @brief Restrict the fine defect to the coarse one. */
+      void restrictDefect();
+      /** @brief Prolongate the coarse correction and store it in update_. */
+      void prolongateCorrection();
+
+      /** @brief The fine level operator. */
+      const Operator& operator_;
+      /** @brief The arguments of the fine level smoother. */
+      SmootherArgs smootherArgs_;
+      /** @brief The fine level smoother. */
+      Smoother* smoother_;
+      /** @brief The aggregate of each fine level unknown. */
+      std::vector<Vertex> aggregates_;
+      /** @brief The matrix of the first coarse level. */
+      CoarseMatrix coarseMatrix_;
+      /** @brief The operator of the first coarse level. */
+      CoarseOperator* coarseOperator_;
+      /** @brief The AMG on the coarse levels. */
+      CoarseAMG* coarseAmg_;
+      /** @brief The damping factor of the prolongation. */
+      double prolongDamp_;
+      /** @brief The number of pre and post smoothing steps on the fine level. */
+      std::size_t preSteps_, postSteps_;
+      /** @brief The fine level defect and update. */
+      Range* defect_;
+      Domain* update_;
+      /** @brief The coarse level defect and correction. */
+      CoarseVector* coarseDefect_;
+      CoarseVector* coarseUpdate_;
+    };
+
+    template<class M, class X, class S, class CS>
+    template<class C, class CC>
+    MixedPrecisionAMG<M,X,S,CS>::MixedPrecisionAMG(const Operator& fineOperator,
+                                                   const C& criterion,
+                                                   const SmootherArgs& smootherArgs,
+                                                   const CC& coarseCriterion,
+                                                   const CoarseSmootherArgs& coarseSmootherArgs)
+      : operator_(fineOperator), smootherArgs_(smootherArgs), smoother_(0),
+        coarseOperator_(0), coarseAmg_(0),
+        prolongDamp_(criterion.getProlongationDampingFactor()),
+        preSteps_(criterion.getNoPreSmoothSteps()), postSteps_(criterion.getNoPostSmoothSteps()),
+        defect_(0), update_(0), coarseDefect_(0), coarseUpdate_(0)
+    {
+      dune_static_assert(static_cast<int>(M::category)==static_cast<int>(SolverCategory::sequential),
+                         "MixedPrecisionAMG is only implemented for sequential operators!");
+      typedef MatrixHierarchy<M,SequentialInformation> FineHierarchy;
+
+      // Aggregate the fine level only. The double precision coarse matrix
+      // is released again as soon as it is converted.
+      C fineCriterion(criterion);
+      fineCriterion.setMaxLevel(1);
+      fineCriterion.setSmoothedAggregation(false);
+      fineCriterion.setExplicitTransferOperators(false);
+      FineHierarchy hierarchy(const_cast<Operator&>(fineOperator));
+      hierarchy.template build<NegateSet<SequentialInformation::OwnerSet> >(fineCriterion);
+      if(hierarchy.levels()<2)
+        DUNE_THROW(ISTLError, "The fine level could not be coarsened. Use AMG for this system!");
+
+      const AggregatesMap& aggregates=*hierarchy.aggregatesMaps().front();
+      aggregates_.assign(&aggregates[0], &aggregates[0]+fineOperator.getmat().N());
+
+      typename ConstructionTraits<Smoother>::Arguments cargs;
+      cargs.setArgs(smootherArgs_);
+      cargs.setMatrix(fineOperator.getmat(), aggregates);
+      SequentialInformation info;
+      cargs.setComm(info);
+      smoother_ = ConstructionTraits<Smoother>::construct(cargs);
+
+      convertMatrix(hierarchy.matrices().coarsest()->getmat(), coarseMatrix_);
+      coarseOperator_ = new CoarseOperator(coarseMatrix_);
+      coarseAmg_ = new CoarseAMG(*coarseOperator_, coarseCriterion, coarseSmootherArgs);
+    }
+
+    template<class M, class X, class S, class CS>
+    MixedPrecisionAMG<M,X,S,CS>::~MixedPrecisionAMG()
+    {
+      delete coarseAmg_;
+      delete coarseOperator_;
+      if(smoother_)
+        ConstructionTraits<Smoother>::deconstruct(smoother_);
+    }
+
+    template<class M, class X, class S, class CS>
+    void MixedPrecisionAMG<M,X,S,CS>::pre(Domain& x, Range& b)
+    {
+      smoother_->pre(x,b);
+      defect_ = new Range(b);
+      update_ = new Domain(x);
+      coarseDefect_ = new CoarseVector(coarseMatrix_.N());
+      coarseUpdate_ = new CoarseVector(coarseMatrix_.N());
+      *coarseDefect_=0;
+      *coarseUpdate_=0;
+      coarseAmg_->pre(*coarseUpdate_, *coarseDefect_);
+    }
+
+    template<class M, class X, class S, class CS>
+    void MixedPrecisionAMG<M,X,S,CS>::apply(Domain& v, const Range& d)
+    {
+      *defect_=d;
+      v=0;
+
+      for(std::size_t i=0; i < preSteps_; ++i){
+        *update_=0;
+        SmootherApplier<S>::preSmooth(*smoother_, *update_, *defect_);
+        v += *update_;
+        operator_.applyscaleadd(-1, static_cast<const Domain&>(*update_), *defect_);
+      }
+
+      restrictDefect();
+      *coarseUpdate_=0;
+      coarseAmg_->apply(*coarseUpdate_, *coarseDefect_);
+      prolongateCorrection();
+      v += *update_;
+
+      for(std::size_t i=0; i < postSteps_; ++i){
+        operator_.applyscaleadd(-1, static_cast<const Domain&>(*update_), *defect_);
+        *update_=0;
+        SmootherApplier<S>::postSmooth(*smoother_, *update_, *defect_);
+        v += *update_;
+      }
+    }
+
+    template<class M, class X, class S, class CS>
+    void MixedPrecisionAMG<M,X,S,CS>::restrictDefect()
+    {
+      typedef typename Range::block_type Block;
+      *coarseDefect_=0;
+      for(std::size_t i=0; i<aggregates_.size(); ++i){
+        const Vertex& aggregate=aggregates_[i];
+        if(aggregate==AggregatesMap::ISOLATED)
+          continue;
+        const Block& block=(*defect_)[i];
+        for(int k=0; k<Block::dimension; ++k)
+          (*coarseDefect_)[aggregate][k]+=static_cast<coarse_field_type>(block[k]);
+      }
+    }
+
+    template<class M, class X, class S, class CS>
+    void MixedPrecisionAMG<M,X,S,CS>::prolongateCorrection()
+    {
+      typedef typename Domain::block_type Block;
+      typedef typename Domain::field_type field_type;
+      *update_=0;
+      for(std::size_t i=0; i<aggregates_.size(); ++i){
+        const Vertex& aggregate=aggregates_[i];
+        if(aggregate==AggregatesMap::ISOLATED)
+          continue;
+        Block& block=(*update_)[i];
+        for(int k=0; k<Block::dimension; ++k)
+          block[k]=prolongDamp_*static_cast<field_type>((*coarseUpdate_)[aggregate][k]);
+      }
+    }
+
+    template<class M, class X, class S, class CS>
+    void MixedPrecisionAMG<M,X,S,CS>::post(Domain& x)
+    {
+      coarseAmg_->post(*coarseUpdate_);
+      smoother_->post(x);
+      delete defect_;
+      delete update_;
+      delete coarseDefect_;
+      delete coarseUpdate_;
+      defect_=update_=0;
+      coarseDefect_=coarseUpdate_=0;
+    }
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
@@ -0,0 +1,841 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_NULLSPACE_HH
+#define DUNE_AMG_NULLSPACE_HH
+
+#include"aggregates.hh"
+#include"dependency.hh"
+#include"graph.hh"
+#include"smoother.hh"
+#include<dune/common/fmatrix.hh>
+#include<dune/common/fvector.hh>
+#include<dune/common/propertymap.hh>
+#include<dune/common/static_assert.hh>
+#include<dune/istl/bcrsmatrix.hh>
+#include<dune/istl/bvector.hh>
+#include<dune/istl/istlexception.hh>
+#include<dune/istl/operators.hh>
+#include<dune/istl/scalarproducts.hh>
+#include<dune/istl/solvers.hh>
+#include<dune/istl/superlu.hh>
+#include<algorithm>
+#include<cmath>
+#include<cstddef>
+#include<limits>
+#include<vector>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief An AMG whose prolongations preserve a given near nullspace.
+     *
+     * With plain aggregation the prolongation of an aggregate is the
+     * identity, i.e. it reproduces only constant vectors. For systems like
+     * linear elasticity the near nullspace also contains the rotations.
+     * Here the tentative prolongation of each aggregate is the Q factor of
+     * a QR decomposition of the near nullspace vectors restricted to the
+     * aggregate. The R factors form the near nullspace of the next level,
+     * whose unknowns have one component per near nullspace vector.
+     */
+
+    /**
+     * @brief The rigid body modes of linear elasticity.
+     *
+     * For dim=2 these are the two translations and the rotation, for
+     * dim=3 the three translations and the three rotations.
+     * @tparam dim The dimension of the space.
+     */
+    template<int dim>
+    struct RigidBodyModes
+    {
+      dune_static_assert(dim==2 || dim==3, "Rigid body modes are only available for dim=2 and dim=3!");
+
+      enum {
+        /** @brief The number of rigid body modes. */
+        size = dim*(dim+1)/2
+      };
+
+      /**
+       * @brief Compute the rigid body modes at the nodes.
+       *
+       * @param coordinates The coordinates of the nodes.
+       * @param modes The modes at the nodes. Entry [i][j] of block k is
+       * component i of mode j at node k.
+       */
+      template<class T, class F>
+      static void compute(const std::vector<FieldVector<T,dim> >& coordinates,
+                          std::vector<FieldMatrix<F,dim,size> >& modes)
+      {
+        // the rotations are taken about the centroid
+        FieldVector<T,dim> center(0);
+        for(std::size_t k=0; k<coordinates.size(); ++k)
+          center+=coordinates[k];
+        if(!coordinates.empty())
+          center/=coordinates.size();
+
+        modes.resize(coordinates.size());
+        for(std::size_t k=0; k<coordinates.size(); ++k){
+          FieldVector<T,dim> x=coordinates[k];
+          x-=center;
+          FieldMatrix<F,dim,size>& mode=modes[k];
+          mode=0;
+          for(int i=0; i<dim; ++i)
+            mode[i][i]=1;
+          setRotations(x, mode);
+        }
+      }
+
+    private:
+      template<class T, class F>
+      static void setRotations(const FieldVector<T,2>& x, FieldMatrix<F,2,3>& mode)
+      {
+        mode[0][2]=-x[1];
+        mode[1][2]=x[0];
+      }
+
+      template<class T, class F>
+      static void setRotations(const FieldVector<T,3>& x, FieldMatrix<F,3,6>& mode)
+      {
+        mode[1][3]=-x[2];
+        mode[2][3]=x[1];
+        mode[0][4]=x[2];
+        mode[2][4]=-x[0];
+        mode[0][5]=-x[1];
+        mode[1][5]=x[0];
+      }
+    };
+
+    /**
+     * @brief Build the tentative prolongation preserving a near nullspace.
+     *
+     * The near nullspace vectors restricted to each aggregate are
+     * orthonormalized by modified Gram-Schmidt. The orthonormal vectors
+     * form the prolongation, the coefficients the near nullspace of the
+     * coarse level. Vectors that are linearly dependent on the aggregate
+     * give a zero column.
+     *
+     * @param aggregates The aggregate of each fine unknown, numbered
+     * consecutively.
+     * @param noAggregates The number of aggregates.
+     * @param nullspace The near nullspace on the fine level. Entry [i][j]
+     * of block k is component i of vector j at unknown k.
+     * @param prolongation The matrix to store the prolongation in. It has
+     * one block per row, none for isolated unknowns.
+     * @param coarseNullspace The near nullspace on the coarse level.
+     */
+    template<class V, class B, class P, class CB>
+    void buildTentativeProlongation(const AggregatesMap<V>& aggregates, std::size_t noAggregates,
+                                    const std::vector<B>& nullspace, P& prolongation,
+                                    std::vector<CB>& coarseNullspace)
+    {
+      typedef typename P::size_type size_type;
+      typedef typename P::block_type Block;
+      typedef typename Block::field_type field_type;
+      const int rows=Block::rows, cols=Block::cols;
+
+      dune_static_assert(static_cast<int>(B::rows)==rows && static_cast<int>(B::cols)==cols
+                         && static_cast<int>(CB::rows)==cols && static_cast<int>(CB::cols)==cols,
+                         "The block sizes of the near nullspace and the prolongation do not match!");
+
+      const size_type n=nullspace.size();
+      size_type nnz=0;
+      for(size_type i=0; i<n; ++i)
+        if(aggregates[i]<AggregatesMap<V>::ISOLATED)
+          ++nnz;
+
+      prolongation.setSize(n, noAggregates, nnz);
+      prolongation.setBuildMode(P::row_wise);
+      size_type i=0;
+      for(typename P::CreateIterator ci=prolongation.createbegin(); ci!=prolongation.createend(); ++ci, ++i)
+        if(aggregates[i]<AggregatesMap<V>::ISOLATED)
+          ci.insert(aggregates[i]);
+
+      // the blocks of the prolongation sorted by aggregate
+      std::vector<size_type> start(noAggregates+1, 0);
+      for(i=0; i<n; ++i)
+        if(aggregates[i]<AggregatesMap<V>::ISOLATED)
+          ++start[aggregates[i]+1];
+      for(size_type a=0; a<noAggregates; ++a)
+        start[a+1]+=start[a];
+      std::vector<Block*> blocks(nnz);
+      for(i=0; i<n; ++i)
+        if(aggregates[i]<AggregatesMap<V>::ISOLATED){
+          Block& block=prolongation[i][aggregates[i]];
+          for(int r=0; r<rows; ++r)
+            for(int c=0; c<cols; ++c)
+              block[r][c]=nullspace[i][r][c];
+          blocks[start[aggregates[i]]++]=&block;
+        }
+      for(size_type a=noAggregates; a>0; --a)
+        start[a]=start[a-1];
+      start[0]=0;
+
+      coarseNullspace.resize(noAggregates);
+      for(size_type a=0; a<noAggregates; ++a){
+        CB& r=coarseNullspace[a];
+        r=0;
+        for(int c=0; c<cols; ++c){
+          field_type norm=0;
+          for(size_type b=start[a]; b<start[a+1]; ++b)
+            for(int k=0; k<rows; ++k)
+              norm+=(*blocks[b])[k][c]*(*blocks[b])[k][c];
+          const field_type original=std::sqrt(norm);
+
+          for(int d=0; d<c; ++d){
+            field_type product=0;
+            for(size_type b=start[a]; b<start[a+1]; ++b)
+              for(int k=0; k<rows; ++k)
+                product+=(*blocks[b])[k][d]*(*blocks[b])[k][c];
+            r[d][c]=product;
+            for(size_type b=start[a]; b<start[a+1]; ++b)
+              for(int k=0; k<rows; ++k)
+                (*blocks[b])[k][c]-=product*(*blocks[b])[k][d];
+          }
+
+          norm=0;
+          for(size_type b=start[a]; b<start[a+1]; ++b)
+            for(int k=0; k<rows; ++k)
+              norm+=(*blocks[b])[k][c]*(*blocks[b])[k][c];
+          norm=std::sqrt(norm);
+          if(norm<=1e-10*original)
+            norm=0;
+          r[c][c]=norm;
+          for(size_type b=start[a]; b<start[a+1]; ++b)
+            for(int k=0; k<rows; ++k)
+              (*blocks[b])[k][c]=norm>0 ? (*blocks[b])[k][c]/norm : 0;
+        }
+      }
+    }
+
+    /**
+     * @brief Smooth a tentative prolongation by one damped Jacobi step
+     * \f$P=(I-\omega D^{-1}A)P_{tent}\f$.
+     *
+     * @param matrix The fine level matrix.
+     * @param tentative The tentative prolongation with at most one block
+     * per row.
+     * @param omega The damping factor of the Jacobi step.
+     * @param prolongation The matrix to store the smoothed prolongation in.
+     */
+    template<class M, class P>
+    void smoothProlongation(const M& matrix, const P& tentative, double omega, P& prolongation)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+      typedef typename P::ConstColIterator PColIterator;
+      typedef typename M::block_type Block;
+      typedef typename P::block_type PBlock;
+      typedef typename P::size_type size_type;
+
+      std::vector<size_type> rowStart(matrix.N()+1, 0);
+      std::vector<size_type> columns;
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row){
+        size_type first=columns.size();
+        for(ColIterator col=row->begin(); col!=row->end(); ++col){
+          PColIterator p=tentative[col.index()].begin();
+          if(p!=tentative[col.index()].end())
+            columns.push_back(p.index());
+        }
+        std::sort(columns.begin()+first, columns.end());
+        columns.erase(std::unique(columns.begin()+first, columns.end()), columns.end());
+        rowStart[row.index()+1]=columns.size();
+      }
+
+      prolongation.setSize(tentative.N(), tentative.M(), columns.size());
+      prolongation.setBuildMode(P::row_wise);
+      size_type i=0;
+      for(typename P::CreateIterator ci=prolongation.createbegin(); ci!=prolongation.createend(); ++ci, ++i)
+        for(size_type j=rowStart[i]; j<rowStart[i+1]; ++j)
+          ci.insert(columns[j]);
+
+      prolongation=0;
+      PBlock entry;
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row){
+        ColIterator diagonal=row->find(row.index());
+        if(diagonal==row->end())
+          DUNE_THROW(ISTLError, "Matrix row "<<row.index()<<" has no diagonal entry!");
+        Block scaling=*diagonal;
+        scaling.invert();
+        scaling*=-omega;
+
+        typename P::row_type& prow=prolongation[row.index()];
+        for(ColIterator col=row->begin(); col!=row->end(); ++col){
+          PColIterator p=tentative[col.index()].begin();
+          if(p==tentative[col.index()].end())
+            continue;
+          Block product=*col;
+          product.leftmultiply(scaling);
+          entry=0;
+          for(int r=0; r<PBlock::rows; ++r)
+            for(int c=0; c<PBlock::cols; ++c)
+              for(int k=0; k<PBlock::rows; ++k)
+                entry[r][c]+=product[r][k]*(*p)[k][c];
+          prow[p.index()]+=entry;
+        }
+        PColIterator p=tentative[row.index()].begin();
+        if(p!=tentative[row.index()].end())
+          prow[p.index()]+=*p;
+      }
+    }
+
+    /**
+     * @brief Set up a sparse matrix from its rows in compressed form.
+     *
+     * @param rows The number of rows.
+     * @param cols The number of columns.
+     * @param rowStart The start of each row in columns and values.
+     * @param columns The sorted column indices of the rows.
+     * @param values The entries belonging to the column indices.
+     * @param matrix The matrix to set up.
+     */
+    template<class M>
+    void setupMatrixFromRows(typename M::size_type rows, typename M::size_type cols,
+                             const std::vector<typename M::size_type>& rowStart,
+                             const std::vector<typename M::size_type>& columns,
+                             const std::vector<typename M::block_type>& values, M& matrix)
+    {
+      typedef typename M::size_type size_type;
+      matrix.setSize(rows, cols, columns.size());
+      matrix.setBuildMode(M::row_wise);
+      size_type k=0;
+      for(typename M::CreateIterator ci=matrix.createbegin(); ci!=matrix.createend(); ++ci, ++k)
+        for(size_type j=rowStart[k]; j<rowStart[k+1]; ++j)
+          ci.insert(columns[j]);
+
+      typename std::vector<typename M::block_type>::const_iterator value=values.begin();
+      for(typename M::RowIterator row=matrix.begin(); row!=matrix.end(); ++row)
+        for(typename M::ColIterator col=row->begin(); col!=row->end(); ++col, ++value)
+          *col=*value;
+    }
+
+    /**
+     * @brief Compute the Galerkin product \f$C=P^TAP\f$ for a prolongation
+     * changing the block size.
+     *
+     * The product AP is computed first, then C row by row from the
+     * columns of P. Diagonal entries of C that are zero because of a zero
+     * column of P are set to one, as the corresponding unknowns are
+     * decoupled.
+     *
+     * @param prolongation The prolongation P.
+     * @param matrix The fine level matrix A.
+     * @param coarse The matrix to store C in.
+     */
+    template<class P, class M, class CM>
+    void nullspaceGalerkinProduct(const P& prolongation, const M& matrix, CM& coarse)
+    {
+      typedef typename P::ConstRowIterator PRowIterator;
+      typedef typename P::ConstColIterator PColIterator;
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+      typedef typename P::block_type PBlock;
+      typedef typename CM::block_type CBlock;
+      typedef typename P::size_type size_type;
+      const int rows=PBlock::rows, cols=PBlock::cols;
+
+      const size_type n=prolongation.M();
+      const size_type unmarked=std::numeric_limits<size_type>::max();
+      std::vector<size_type> marker(n, unmarked);
+      std::vector<size_type> rowStart(1, 0);
+      std::vector<size_type> columns;
+
+      // AP
+      P product;
+      {
+        std::vector<PBlock> sum(n), values;
+        rowStart.reserve(matrix.N()+1);
+        for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row){
+          const size_type first=columns.size();
+          for(ColIterator a=row->begin(); a!=row->end(); ++a){
+            const typename P::row_type& prow=prolongation[a.index()];
+            for(PColIterator p=prow.begin(); p!=prow.end(); ++p){
+              if(marker[p.index()]!=row.index()){
+                marker[p.index()]=row.index();
+                columns.push_back(p.index());
+                sum[p.index()]=0;
+              }
+              PBlock& target=sum[p.index()];
+              for(int r=0; r<rows; ++r)
+                for(int s=0; s<cols; ++s)
+                  for(int t=0; t<rows; ++t)
+                    target[r][s]+=(*a)[r][t]*(*p)[t][s];
+            }
+          }
+          std::sort(columns.begin()+first, columns.end());
+          for(size_type j=first; j<columns.size(); ++j)
+            values.push_back(sum[columns[j]]);
+          rowStart.push_back(columns.size());
+        }
+        setupMatrixFromRows(matrix.N(), n, rowStart, columns, values, product);
+      }
+
+      // the transpose of P as index structure
+      std::vector<size_type> start(n+1, 0);
+      for(PRowIterator row=prolongation.begin(); row!=prolongation.end(); ++row)
+        for(PColIterator col=row->begin(); col!=row->end(); ++col)
+          ++start[col.index()+1];
+      for(size_type k=0; k<n; ++k)
+        start[k+1]+=start[k];
+      std::vector<size_type> fine(start[n]);
+      std::vector<const PBlock*> entries(start[n]);
+      {
+        std::vector<size_type> position(start.begin(), start.end()-1);
+        for(PRowIterator row=prolongation.begin(); row!=prolongation.end(); ++row)
+          for(PColIterator col=row->begin(); col!=row->end(); ++col){
+            size_type& p=position[col.index()];
+            fine[p]=row.index();
+            entries[p]=&(*col);
+            ++p;
+          }
+      }
+
+      // P^T(AP)
+      std::vector<CBlock> sum(n), values;
+      marker.assign(n, unmarked);
+      rowStart.assign(1, 0);
+      columns.clear();
+      for(size_type k=0; k<n; ++k){
+        const size_type first=columns.size();
+        for(size_type e=start[k]; e<start[k+1]; ++e){
+          const PBlock& pik=*entries[e];
+          const typename P::row_type& aprow=product[fine[e]];
+          for(PColIterator ap=aprow.begin(); ap!=aprow.end(); ++ap){
+            if(marker[ap.index()]!=k){
+              marker[ap.index()]=k;
+              columns.push_back(ap.index());
+              sum[ap.index()]=0;
+            }
+            CBlock& target=sum[ap.index()];
+            for(int r=0; r<cols; ++r)
+              for(int s=0; s<cols; ++s)
+                for(int t=0; t<rows; ++t)
+                  target[r][s]+=pik[t][r]*(*ap)[t][s];
+          }
+        }
+        std::sort(columns.begin()+first, columns.end());
+        for(size_type j=first; j<columns.size(); ++j){
+          values.push_back(sum[columns[j]]);
+          if(columns[j]==k)
+            for(int r=0; r<cols; ++r)
+              if(values.back()[r][r]==0)
+                values.back()[r][r]=1;
+        }
+        rowStart.push_back(columns.size());
+      }
+      setupMatrixFromRows(n, n, rowStart, columns, values, coarse);
+    }
+
+    /**
+     * @brief Sequential AMG with prolongations preserving a near nullspace.
+     *
+     * The levels are built by aggregation as in AMG. The prolongation of
+     * each level is built from the near nullspace by
+     * buildTentativeProlongation and smoothed by smoothProlongation if the
+     * criterion asks for smoothed aggregation. The coarse level matrices
+     * are the Galerkin products.
+     *
+     * The unknowns of all coarse levels have one component per near
+     * nullspace vector, e.g. six for three dimensional elasticity. Each
+     * cycle is a V-cycle, the coarsest level is solved by SuperLU if
+     * available and approximately by BiCGSTAB otherwise.
+     *
+     * @tparam M The type of the fine level operator.
+     * @tparam X The type of the fine level vectors.
+     * @tparam S The type of the fine level smoother.
+     * @tparam CS The type of the smoother on the coarse levels, e.g.
+     * SeqSSOR<BCRSMatrix<FieldMatrix<double,6,6> >, BlockVector<FieldVector<double,6> >,
+     * BlockVector<FieldVector<double,6> > >. Its matrix and vector types
+     * determine those of the coarse levels and therefore the number of
+     * near nullspace vectors.
+     */
+    template<class M, class X, class S, class CS>
+    class NullspaceAMG : public Preconditioner<X,X>
+    {
+    public:
+      /** @brief The type of the fine level operator. */
+      typedef M Operator;
+      /** @brief The type of the fine level matrix. */
+      typedef typename M::matrix_type Matrix;
+      /** @brief The domain type. */
+      typedef X Domain;
+      /** @brief The range type. */
+      typedef X Range;
+      /** @brief The type of the fine level smoother. */
+      typedef S Smoother;
+      /** @brief The argument type for the construction of the fine level smoother. */
+      typedef typename SmootherTraits<Smoother>::Arguments SmootherArgs;
+      /** @brief The type of the coarse level smoothers. */
+      typedef CS CoarseSmoother;
+      /** @brief The argument type for the construction of the coarse level smoothers. */
+      typedef typename SmootherTraits<CoarseSmoother>::Arguments CoarseSmootherArgs;
+      /** @brief The type of the coarse level matrices. */
+      typedef typename CoarseSmoother::matrix_type CoarseMatrix;
+      /** @brief The type of the coarse level vectors. */
+      typedef typename CoarseSmoother::domain_type CoarseVector;
+      /** @brief The type of the coarse level operators. */
+      typedef MatrixAdapter<CoarseMatrix,CoarseVector,CoarseVector> CoarseOperator;
+
+      enum {
+        /** @brief The number of components of the fine level unknowns. */
+        blocksize = Matrix::block_type::rows,
+        /** @brief The number of near nullspace vectors. */
+        nullspaceSize = CoarseMatrix::block_type::rows,
+        /** @brief The solver category. */
+        category = SolverCategory::sequential
+      };
+
+      /**
+       * @brief The type of the near nullspace at one fine unknown.
+       *
+       * Entry [i][j] is component i of near nullspace vector j.
+       */
+      typedef FieldMatrix<typename Matrix::field_type,blocksize,nullspaceSize> NullspaceBlock;
+      /** @brief The type of the near nullspace at one coarse unknown. */
+      typedef typename CoarseMatrix::block_type CoarseNullspaceBlock;
+      /** @brief The type of the prolongation from the first coarse level. */
+      typedef BCRSMatrix<NullspaceBlock> Prolongation;
+      /** @brief The type of the prolongations between coarse levels. */
+      typedef BCRSMatrix<CoarseNullspaceBlock> CoarseProlongation;
+
+      /**
+       * @brief Build the hierarchy.
+       *
+       * @param fineOperator The operator on the fine level.
+       * @param nullspace The near nullspace at each fine unknown, e.g.
+       * computed by RigidBodyModes::compute.
+       * @param criterion The criterion for the aggregation of the fine
+       * level. Its numbers of pre and post smoothing steps and the
+       * prolongation damping factor are used on all levels. As in AMG
+       * smoothed prolongations are not damped. Its
+       * parameters for coarsening and smoothed aggregation are used for
+       * the whole hierarchy.
+       * @param smootherArgs The arguments for constructing the fine level
+       * smoother.
+       * @param coarseCriterion The criterion for the aggregation of the
+       * coarse levels. It has to be set up for the coarse matrix type.
+       * @param coarseSmootherArgs The arguments for constructing the
+       * coarse level smoothers.
+       */
+      template<class C, class CC>
+      NullspaceAMG(const Operator& fineOperator, const std::vector<NullspaceBlock>& nullspace,
+                   const C& criterion, const SmootherArgs& smootherArgs,
+                   const CC& coarseCriterion, const CoarseSmootherArgs& coarseSmootherArgs);
+
+      ~NullspaceAMG();
+
+      /** \copydoc Preconditioner::pre */
+      void pre(Domain& x, Range& b);
+
+      /** \copydoc Preconditioner::apply */
+      void apply(Domain& v, const Range& d);
+
+      /** \copydoc Preconditioner::post */
+      void post(Domain& x);
+
+      /** @brief Get the number of levels including the finest one. */
+      std::size_t levels() const
+      {
+        return coarseMatrices_.size()+1;
+      }
+
+    private:
+      typedef typename MatrixGraph<Matrix>::VertexDescriptor Vertex;
+      typedef typename MatrixGraph<CoarseMatrix>::VertexDescriptor CoarseVertex;
+
+      /**
+       * @brief Aggregate a matrix and number the aggregates consecutively.
+       * @return The number of aggregates.
+       */
+      template<class MT, class V, class C>
+      static std::size_t aggregate(const MT& matrix, const C& criterion, bool finestLevel,
+                                   AggregatesMap<V>& aggregates);
+
+      /** @brief Apply one V-cycle on the coarse level. */
+      void mgc(std::size_t level);
+
+      /** @brief The fine level operator. */
+      const Operator& operator_;
+      /** @brief The fine level smoother. */
+      Smoother* smoother_;
+      /** @brief The aggregates of the fine level. */
+      AggregatesMap<Vertex>* aggregates_;
+      /** @brief The prolongation to the fine level. */
+      Prolongation prolongation_;
+      /** @brief The matrices of the coarse levels. */
+      std::vector<CoarseMatrix*> coarseMatrices_;
+      /** @brief The operators of the coarse levels. */
+      std::vector<CoarseOperator*> coarseOperators_;
+      /** @brief The aggregates of the coarse levels but the coarsest. */
+      std::vector<AggregatesMap<CoarseVertex>*> coarseAggregates_;
+      /** @brief The prolongations to the coarse levels but the coarsest. */
+      std::vector<CoarseProlongation*> coarseProlongations_;
+      /** @brief The smoothers of the coarse levels. */
+      std::vector<CoarseSmoother*> coarseSmoothers_;
+      /** @brief The scalar product of the coarsest level. */
+      SeqScalarProduct<CoarseVector> coarseScalarProduct_;
+      /** @brief The solver of the coarsest level. */
+      InverseOperator<CoarseVector,CoarseVector>* coarseSolver_;
+      /** @brief The damping factor of the prolongation. */
+      double prolongDamp_;
+      /** @brief Whether the coarse solver converged in the current cycle. */
+      bool coarseSolverConverged_;
+      /** @brief The number of pre and post smoothing steps. */
+      std::size_t preSteps_, postSteps_;
+      /** @brief The fine level defect and update. */
+      Range* defect_;
+      Domain* update_;
+      /** @brief The defects, updates and corrections of the coarse levels. */
+      std::vector<CoarseVector*> coarseDefects_, coarseUpdates_, coarseCorrections_;
+    };
+
+    template<class M, class X, class S, class CS>
+    template<class MT, class V, class C>
+    std::size_t NullspaceAMG<M,X,S,CS>::aggregate(const MT& matrix, const C& criterion,
+                                                  bool finestLevel, AggregatesMap<V>& aggregates)
+    {
+      typedef Dune::Amg::MatrixGraph<const MT> MatrixGraph;
+      typedef Dune::Amg::PropertiesGraph<MatrixGraph,VertexProperties,EdgeProperties,
+        IdentityMap,IdentityMap> PropertiesGraph;
+      MatrixGraph graph(matrix);
+      PropertiesGraph pgraph(graph);
+      aggregates.buildAggregates(matrix, pgraph, criterion, finestLevel);
+
+      // number the aggregates consecutively
+      const V unnumbered=AggregatesMap<V>::UNAGGREGATED;
+      std::vector<V> number(matrix.N(), unnumbered);
+      std::size_t noAggregates=0;
+      for(std::size_t i=0; i<matrix.N(); ++i){
+        V& a=aggregates[i];
+        if(a>=AggregatesMap<V>::ISOLATED)
+          continue;
+        if(number[a]==unnumbered)
+          number[a]=noAggregates++;
+        a=number[a];
+      }
+      return noAggregates;
+    }
+
+    template<class M, class X, class S, class CS>
+    template<class C, class CC>
+    NullspaceAMG<M,X,S,CS>::NullspaceAMG(const Operator& fineOperator,
+                                         const std::vector<NullspaceBlock>& nullspace,
+                                         const C& criterion, const SmootherArgs& smootherArgs,
+                                         const CC& coarseCriterion,
+                                         const CoarseSmootherArgs& coarseSmootherArgs)
+      : operator_(fineOperator), smoother_(0), aggregates_(0), coarseSolver_(0),
+        prolongDamp_(criterion.smoothedAggregation() ? 1 : criterion.getProlongationDampingFactor()),
+        coarseSolverConverged_(true),
+        preSteps_(criterion.getNoPreSmoothSteps()), postSteps_(criterion.getNoPostSmoothSteps()),
+        defect_(0), update_(0)
+    {
+      dune_static_assert(static_cast<int>(M::category)==static_cast<int>(SolverCategory::sequential),
+                         "NullspaceAMG is only implemented for sequential operators!");
+      const Matrix& fine=fineOperator.getmat();
+      if(nullspace.size()!=fine.N())
+        DUNE_THROW(ISTLError, "The near nullspace has "<<nullspace.size()
+                   <<" entries, but the matrix has "<<fine.N()<<" rows!");
+
+      aggregates_ = new AggregatesMap<Vertex>(fine.N());
+      std::size_t noAggregates=aggregate(fine, criterion, true, *aggregates_);
+      if(noAggregates==0 || criterion.maxLevel()<2)
+        DUNE_THROW(ISTLError, "The fine level could not be coarsened. Use AMG for this system!");
+
+      typename ConstructionTraits<Smoother>::Arguments cargs;
+      cargs.setArgs(smootherArgs);
+      cargs.setMatrix(fine, *aggregates_);
+      SequentialInformation info;
+      cargs.setComm(info);
+      smoother_ = ConstructionTraits<Smoother>::construct(cargs);
+
+      std::vector<CoarseNullspaceBlock> coarseNullspace;
+      {
+        Prolongation tentative;
+        buildTentativeProlongation(*aggregates_, noAggregates, nullspace, tentative, coarseNullspace);
+        if(criterion.smoothedAggregation())
+          smoothProlongation(fine, tentative, criterion.getProlongationSmoothingFactor(), prolongation_);
+        else
+          prolongation_=tentative;
+      }
+      coarseMatrices_.push_back(new CoarseMatrix());
+      nullspaceGalerkinProduct(prolongation_, fine, *coarseMatrices_.back());
+
+      while(static_cast<int>(coarseMatrices_.size()+1)<criterion.maxLevel()
+            && static_cast<int>(coarseMatrices_.back()->N())>criterion.coarsenTarget()){
+        const CoarseMatrix& matrix=*coarseMatrices_.back();
+        AggregatesMap<CoarseVertex>* aggregates=new AggregatesMap<CoarseVertex>(matrix.N());
+        noAggregates=aggregate(matrix, coarseCriterion, false, *aggregates);
+        if(noAggregates==0 || matrix.N()<criterion.minCoarsenRate()*noAggregates){
+          delete aggregates;
+          break;
+        }
+        coarseAggregates_.push_back(aggregates);
+
+        std::vector<CoarseNullspaceBlock> nextNullspace;
+        CoarseProlongation tentative;
+        buildTentativeProlongation(*aggregates, noAggregates, coarseNullspace, tentative, nextNullspace);
+        coarseNullspace.swap(nextNullspace);
+        coarseProlongations_.push_back(new CoarseProlongation());
+        if(criterion.smoothedAggregation())
+          smoothProlongation(matrix, tentative, criterion.getProlongationSmoothingFactor(),
+                             *coarseProlongations_.back());
+        else
+          *coarseProlongations_.back()=tentative;
+
+        coarseMatrices_.push_back(new CoarseMatrix());
+        nullspaceGalerkinProduct(*coarseProlongations_.back(), matrix, *coarseMatrices_.back());
+      }
+
+      for(std::size_t l=0; l<coarseMatrices_.size(); ++l){
+        coarseOperators_.push_back(new CoarseOperator(*coarseMatrices_[l]));
+        typename ConstructionTraits<CoarseSmoother>::Arguments ccargs;
+        ccargs.setArgs(coarseSmootherArgs);
+        if(l<coarseAggregates_.size())
+          ccargs.setMatrix(*coarseMatrices_[l], *coarseAggregates_[l]);
+        else
+          ccargs.setMatrix(*coarseMatrices_[l]);
+        ccargs.setComm(info);
+        coarseSmoothers_.push_back(ConstructionTraits<CoarseSmoother>::construct(ccargs));
+      }
+
+#if HAVE_SUPERLU
+      coarseSolver_ = new SuperLU<CoarseMatrix>(*coarseMatrices_.back());
+#else
+      coarseSolver_ = new BiCGSTABSolver<CoarseVector>(*coarseOperators_.back(), coarseScalarProduct_,
+                                                       *coarseSmoothers_.back(), 1E-2, 1000, 0);
+#endif
+    }
+
+    template<class M, class X, class S, class CS>
+    NullspaceAMG<M,X,S,CS>::~NullspaceAMG()
+    {
+      delete coarseSolver_;
+      for(std::size_t l=0; l<coarseMatrices_.size(); ++l){
+        ConstructionTraits<CoarseSmoother>::deconstruct(coarseSmoothers_[l]);
+        delete coarseOperators_[l];
+        delete coarseMatrices_[l];
+      }
+      for(std::size_t l=0; l<coarseAggregates_.size(); ++l){
+        delete coarseAggregates_[l];
+        delete coarseProlongations_[l];
+      }
+      if(smoother_)
+        ConstructionTraits<Smoother>::deconstruct(smoother_);
+      delete aggregates_;
+    }
+
+    template<class M, class X, class S, class CS>
+    void NullspaceAMG<M,X,S,CS>::pre(Domain& x, Range& b)
+    {
+      smoother_->pre(x,b);
+      defect_ = new Range(b);
+      update_ = new Domain(x);
+      for(std::size_t l=0; l<coarseMatrices_.size(); ++l){
+        const std::size_t n=coarseMatrices_[l]->N();
+        coarseDefects_.push_back(new CoarseVector(n));
+        coarseUpdates_.push_back(new CoarseVector(n));
+        coarseCorrections_.push_back(new CoarseVector(n));
+        *coarseDefects_.back()=0;
+        *coarseUpdates_.back()=0;
+        coarseSmoothers_[l]->pre(*coarseUpdates_.back(), *coarseDefects_.back());
+      }
+    }
+
+    template<class M, class X, class S, class CS>
+    void NullspaceAMG<M,X,S,CS>::mgc(std::size_t level)
+    {
+      CoarseVector& v=*coarseCorrections_[level];
+      CoarseVector& d=*coarseDefects_[level];
+      CoarseVector& update=*coarseUpdates_[level];
+      v=0;
+
+      if(level+1==coarseMatrices_.size()){
+        InverseOperatorResult res;
+        coarseSolver_->apply(v, d, res);
+        if(!res.converged)
+          coarseSolverConverged_=false;
+        return;
+      }
+
+      CoarseSmoother& smoother=*coarseSmoothers_[level];
+      const CoarseOperator& op=*coarseOperators_[level];
+      for(std::size_t i=0; i < preSteps_; ++i){
+        update=0;
+        SmootherApplier<CoarseSmoother>::preSmooth(smoother, update, d);
+        v += update;
+        op.applyscaleadd(-1, static_cast<const CoarseVector&>(update), d);
+      }
+
+      const CoarseProlongation& p=*coarseProlongations_[level];
+      p.mtv(d, *coarseDefects_[level+1]);
+      mgc(level+1);
+      update=0;
+      p.usmv(prolongDamp_, *coarseCorrections_[level+1], update);
+      v += update;
+
+      for(std::size_t i=0; i < postSteps_; ++i){
+        op.applyscaleadd(-1, static_cast<const CoarseVector&>(update), d);
+        update=0;
+        SmootherApplier<CoarseSmoother>::postSmooth(smoother, update, d);
+        v += update;
+      }
+    }
+
+    template<class M, class X, class S, class CS>
+    void NullspaceAMG<M,X,S,CS>::apply(Domain& v, const Range& d)
+    {
+      *defect_=d;
+      v=0;
+
+      for(std::size_t i=0; i < preSteps_; ++i){
+        *update_=0;
+        SmootherApplier<S>::preSmooth(*smoother_, *update_, *defect_);
+        v += *update_;
+        operator_.applyscaleadd(-1, static_cast<const Domain&>(*update_), *defect_);
+      }
+
+      prolongation_.mtv(*defect_, *coarseDefects_[0]);
+      coarseSolverConverged_=true;
+      mgc(0);
+      if(!coarseSolverConverged_)
+        DUNE_THROW(MathError, "Coarse solver did not converge");
+      *update_=0;
+      prolongation_.usmv(prolongDamp_, *coarseCorrections_[0], *update_);
+      v += *update_;
+
+      for(std::size_t i=0; i < postSteps_; ++i){
+        operator_.applyscaleadd(-1, static_cast<const Domain&>(*update_), *defect_);
+        *update_=0;
+        SmootherApplier<S>::postSmooth(*smoother_, *update_, *defect_);
+        v += *update_;
+      }
+    }
+
+    template<class M, class X, class S, class CS>
+    void NullspaceAMG<M,X,S,CS>::post(Domain& x)
+    {
+      for(std::size_t l=0; l<coarseMatrices_.size(); ++l){
+        coarseSmoothers_[l]->post(*coarseUpdates_[l]);
+        delete coarseDefects_[l];
+        delete coarseUpdates_[l];
+        delete coarseCorrections_[l];
+      }
+      coarseDefects_.clear();
+      coarseUpdates_.clear();
+      coarseCorrections_.clear();
+      smoother_->post(x);
+      delete defect_;
+      delete update_;
+      defect_=update_=0;
+    }
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
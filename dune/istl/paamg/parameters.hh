@@ -2,6 +2,8 @@
 #define DUNE_AMG_PARAMETERS_HH
 
 #include<cstddef>
+#include<limits>
+#include<vector>
 
 namespace Dune
 {
@@ -72,6 +74,32 @@ namespace Dune
       double alpha_, beta_;
     };
 
+    /**
+     * @brief Identifiers for the different aggregation algorithms.
+     */
+    enum AggregationAlgorithm{
+      /**
+       * @brief Grow the aggregates one after another from a front of seeds.
+       *
+       * This is the default, see Aggregator.
+       */
+      frontAggregation = 0,
+      /**
+       * @brief Build the aggregates around a maximal independent set of
+       * distance two, using all threads available.
+       *
+       * See MISAggregator.
+       */
+      misAggregation = 1,
+      /**
+       * @brief Build the aggregates by matching strongly connected
+       * vertices twice, which gives a very cheap setup.
+       *
+       * See PairwiseAggregator.
+       */
+      pairwiseAggregation = 2
+    };
+
     /**
      * @brief Parameters needed for the aggregation process,
      */
@@ -90,7 +118,7 @@ namespace Dune
        */
       AggregationParameters()
 	: maxDistance_(2), minAggregateSize_(4), maxAggregateSize_(6), 
-	  connectivity_(15), skipiso_(false)
+	  connectivity_(15), skipiso_(false), algorithm_(frontAggregation)
       {}
       
       /**
@@ -214,10 +242,25 @@ namespace Dune
        * @param connectivity The maximum number of connections a aggregate is allowed to have.
        */
       void setMaxConnectivity(std::size_t connectivity){ connectivity_ = connectivity;}
+
+      /**
+       * @brief Get the algorithm used for building the aggregates.
+       * @return The aggregation algorithm.
+       */
+      AggregationAlgorithm aggregationAlgorithm() const{ return algorithm_;}
+
+      /**
+       * @brief Set the algorithm used for building the aggregates.
+       *
+       * The default is frontAggregation.
+       * @param algorithm The aggregation algorithm.
+       */
+      void setAggregationAlgorithm(AggregationAlgorithm algorithm){ algorithm_ = algorithm;}
       
     private:
       std::size_t maxDistance_, minAggregateSize_, maxAggregateSize_, connectivity_;
       bool skipiso_;
+      AggregationAlgorithm algorithm_;
 
     };
 
@@ -339,6 +382,120 @@ namespace Dune
       {
         return dampingFactor_;
       }
+
+      /**
+       * @brief Set whether to use smoothed aggregation.
+       *
+       * If true the prolongation is not piecewise constant on the aggregates
+       * but smoothed with one damped Jacobi step, i.e.
+       * \f$P=(I-\omega D^{-1}A)P_{tent}\f$, and the coarse level matrices are
+       * computed as \f$P^TAP\f$. The prolongation damping factor is not
+       * applied in this case. Only supported for sequential
+       * hierarchies.
+       */
+      void setSmoothedAggregation(bool smoothed)
+      {
+        smoothedAggregation_ = smoothed;
+      }
+
+      /**
+       * @brief Whether smoothed aggregation is used.
+       */
+      bool smoothedAggregation() const
+      {
+        return smoothedAggregation_;
+      }
+
+      /**
+       * @brief Set the damping factor \f$\omega\f$ of the Jacobi step
+       * smoothing the prolongation.
+       *
+       * The default value is 2/3.
+       */
+      void setProlongationSmoothingFactor(double omega)
+      {
+        smoothingFactor_ = omega;
+      }
+
+      /**
+       * @brief Get the damping factor of the Jacobi step smoothing the prolongation.
+       */
+      double getProlongationSmoothingFactor() const
+      {
+        return smoothingFactor_;
+      }
+
+      /**
+       * @brief Set whether to store prolongation and restriction as explicit
+       * sparse operators.
+       *
+       * If true the hierarchy stores a SparseTransferOperator for each level
+       * and the AMG cycle uses its contiguous kernels instead of walking
+       * the aggregates map. This needs additional memory of about one index
+       * per fine unknown for piecewise constant prolongations.
+       */
+      void setExplicitTransferOperators(bool explicitTransfer)
+      {
+        explicitTransfer_ = explicitTransfer;
+      }
+
+      /**
+       * @brief Whether prolongation and restriction are stored as explicit sparse operators.
+       */
+      bool explicitTransferOperators() const
+      {
+        return explicitTransfer_;
+      }
+
+      /**
+       * @brief Set whether to drop the caches of the Galerkin products.
+       *
+       * If true the mappings of the fine onto the coarse matrix entries
+       * (or the transposed prolongations for smoothed aggregation) are not
+       * kept after a level is built. This undoes the memory cost of these
+       * caches, which otherwise stay allocated during the setup and the
+       * solve. Recalculating the Galerkin products then needs more time,
+       * as they are computed from the aggregates again.
+       *
+       * The peak memory of the setup is not lowered below that of a
+       * hierarchy without caches: it is reached while a level is
+       * aggregated, and the matrix and property graphs of each level are
+       * freed after its aggregation in either mode.
+       */
+      void setLeanSetup(bool lean)
+      {
+        leanSetup_ = lean;
+      }
+
+      /**
+       * @brief Whether the caches of the Galerkin products are dropped.
+       */
+      bool leanSetup() const
+      {
+        return leanSetup_;
+      }
+
+      /**
+       * @brief Set whether to renumber the coarse levels for locality.
+       *
+       * If true the aggregates of each level are renumbered by the
+       * reverse Cuthill-McKee ordering of the aggregate graph. This
+       * reduces the bandwidth of the coarse matrices, which improves the
+       * cache reuse of the coarse level matrix-vector products, smoothers
+       * and transfers. Only applied in the sequential case.
+       */
+      void setRenumberCoarseLevels(bool renumber)
+      {
+        renumberCoarseLevels_ = renumber;
+      }
+
+      /**
+       * @brief Whether the coarse levels are renumbered for locality.
+       */
+      bool renumberCoarseLevels() const
+      {
+        return renumberCoarseLevels_;
+      }
       /**
        * @brief Constructor
        * @param maxLevel The maximum number of levels allowed in the matrix hierarchy (default: 100).
@@ -352,7 +509,9 @@ namespace Dune
       CoarseningParameters(int maxLevel=100, int coarsenTarget=1000, double minCoarsenRate=1.2,
                            double prolongDamp=1.6, AccumulationMode accumulate=successiveAccu)
         : maxLevel_(maxLevel), coarsenTarget_(coarsenTarget), minCoarsenRate_(minCoarsenRate),
-          dampingFactor_(prolongDamp), accumulate_( accumulate)
+          dampingFactor_(prolongDamp), accumulate_( accumulate),
+          smoothedAggregation_(false), smoothingFactor_(2.0/3.0),
+          explicitTransfer_(false), leanSetup_(false), renumberCoarseLevels_(false)
       {}
       
     private:
@@ -377,6 +536,26 @@ namespace Dune
        * coarser levels.
        */
       AccumulationMode accumulate_;
+      /**
+       * @brief Whether to smooth the prolongation.
+       */
+      bool smoothedAggregation_;
+      /**
+       * @brief The damping factor of the Jacobi step smoothing the prolongation.
+       */
+      double smoothingFactor_;
+      /**
+       * @brief Whether to store explicit transfer operators.
+       */
+      bool explicitTransfer_;
+      /**
+       * @brief Whether to keep the memory needed by the setup low.
+       */
+      bool leanSetup_;
+      /**
+       * @brief Whether to renumber the coarse levels for locality.
+       */
+      bool renumberCoarseLevels_;
     };
 
     /**
@@ -443,6 +622,84 @@ namespace Dune
         return  postSmoothSteps_;
       }
 
+      /**
+       * @brief Set the number of presmoothing steps to apply on one level.
+       *
+       * Overrides the number set by setNoPreSmoothSteps(std::size_t)
+       * on this level. Coarse levels can often afford more steps
+       * than the fine levels.
+       * @param level The level, 0 is the finest one.
+       * @param steps The number of steps.
+       */
+      void setNoPreSmoothSteps(std::size_t level, std::size_t steps)
+      {
+        if(levelPreSmoothSteps_.size()<=level)
+          levelPreSmoothSteps_.resize(level+1, unsetSteps());
+        levelPreSmoothSteps_[level]=steps;
+      }
+      /**
+       * @brief Get the number of presmoothing steps to apply on one level.
+       * @param level The level, 0 is the finest one.
+       * @return The number of steps.
+       */
+      std::size_t getNoPreSmoothSteps(std::size_t level) const
+      {
+        if(level<levelPreSmoothSteps_.size() && levelPreSmoothSteps_[level]!=unsetSteps())
+          return levelPreSmoothSteps_[level];
+        return preSmoothSteps_;
+      }
+
+      /**
+       * @brief Set the number of postsmoothing steps to apply on one level.
+       *
+       * Overrides the number set by setNoPostSmoothSteps(std::size_t)
+       * on this level.
+       * @param level The level, 0 is the finest one.
+       * @param steps The number of steps.
+       */
+      void setNoPostSmoothSteps(std::size_t level, std::size_t steps)
+      {
+        if(levelPostSmoothSteps_.size()<=level)
+          levelPostSmoothSteps_.resize(level+1, unsetSteps());
+        levelPostSmoothSteps_[level]=steps;
+      }
+      /**
+       * @brief Get the number of postsmoothing steps to apply on one level.
+       * @param level The level, 0 is the finest one.
+       * @return The number of steps.
+       */
+      std::size_t getNoPostSmoothSteps(std::size_t level) const
+      {
+        if(level<levelPostSmoothSteps_.size() && levelPostSmoothSteps_[level]!=unsetSteps())
+          return levelPostSmoothSteps_[level];
+        return postSmoothSteps_;
+      }
+
+      /**
+       * @brief Set the relaxation factor of the smoother on one level.
+       *
+       * Overrides the relaxation factor of the smoother arguments
+       * on this level.
+       * @param level The level, 0 is the finest one.
+       * @param factor The relaxation factor, has to be positive.
+       */
+      void setRelaxationFactor(std::size_t level, double factor)
+      {
+        if(levelRelaxationFactors_.size()<=level)
+          levelRelaxationFactors_.resize(level+1, 0.0);
+        levelRelaxationFactors_[level]=factor;
+      }
+      /**
+       * @brief Get the relaxation factor of the smoother on one level.
+       * @param level The level, 0 is the finest one.
+       * @return The relaxation factor or 0 if the one of the smoother
+       * arguments is used.
+       */
+      double getRelaxationFactor(std::size_t level) const
+      {
+        return level<levelRelaxationFactors_.size() ? levelRelaxationFactors_[level] : 0.0;
+      }
+
       /**
        * @brief Set the value of gamma; 1 for V-cycle, 2 for W-cycle
        */
@@ -457,9 +714,34 @@ namespace Dune
       {
         return gamma_;
       }
+
+      /**
+       * @brief Set whether to use F-cycles.
+       *
+       * On each level the F-cycle visits the coarser level with an
+       * F-cycle followed by a V-cycle. It is cheaper than a W-cycle but
+       * usually converges nearly as fast. If set gamma is ignored.
+       * @param fCycle True if F-cycles should be used.
+       */
+      void setFCycle(bool fCycle)
+      {
+        fCycle_=fCycle;
+      }
+      /**
+       * @brief Get whether to use F-cycles.
+       * @return True if F-cycles are used.
+       */
+      bool getFCycle() const
+      {
+        return fCycle_;
+      }
       
       /**
        * @brief Set whether to use additive multigrid.
+       *
+       * In the sequential case the corrections of the levels are
+       * computed concurrently if the program is compiled with OpenMP,
+       * e.g. with the OPENMP_CXXFLAGS found by configure.
        * @param additive True if multigrid should be additive.
        */
       void setAdditive(bool additive)
@@ -476,6 +758,33 @@ namespace Dune
         return additive_;
       }
 
+      /**
+       * @brief Set whether to solve the coarsest system on every process.
+       *
+       * If true and the coarsest level is distributed (and not
+       * redistributed to fewer processes) its matrix is gathered on all
+       * processes during the setup and the coarse system is solved
+       * redundantly, see ReplicatedCoarseSolver. Each coarse solve then needs
+       * one allgather of the right hand side instead of the communication
+       * of a distributed solver. Combine it with noAccu to keep
+       * all processes on the coarsest level. Ignored if the AMG is
+       * constructed with a user supplied coarse solver.
+       * @param replicated True if the coarse system should be replicated.
+       */
+      void setReplicatedCoarseSolve(bool replicated)
+      {
+        replicatedCoarseSolve_=replicated;
+      }
+
+      /**
+       * @brief Get whether the coarsest system is solved on every process.
+       * @return True if the coarse system is replicated.
+       */
+      bool getReplicatedCoarseSolve() const
+      {
+        return replicatedCoarseSolve_;
+      }
+
       /**
        * @brief Constructor
        * @param maxLevel The maximum number of levels allowed in the matrix hierarchy (default: 100).
@@ -490,14 +799,25 @@ namespace Dune
                  double prolongDamp=1.6, AccumulationMode accumulate=successiveAccu)
         : CoarseningParameters(maxLevel, coarsenTarget, minCoarsenRate, prolongDamp, accumulate)
         , debugLevel_(2), preSmoothSteps_(2), postSmoothSteps_(2), gamma_(1),
-          additive_(false)
+          fCycle_(false), additive_(false), replicatedCoarseSolve_(false)
       {}
     private:
+      /** @brief Marks the levels without their own number of steps. */
+      static std::size_t unsetSteps()
+      {
+        return std::numeric_limits<std::size_t>::max();
+      }
+
       int debugLevel_;
       std::size_t preSmoothSteps_;
       std::size_t postSmoothSteps_;
+      std::vector<std::size_t> levelPreSmoothSteps_;
+      std::vector<std::size_t> levelPostSmoothSteps_;
+      std::vector<double> levelRelaxationFactors_;
       std::size_t gamma_;
+      bool fCycle_;
       bool additive_;
+      bool replicatedCoarseSolve_;
     };
       
   }//namespace AMG
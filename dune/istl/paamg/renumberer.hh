@@ -2,6 +2,10 @@
 #define DUNE_AMG_RENUMBERER_HH
 
 #include "aggregates.hh"
+#include<algorithm>
+#include<cstddef>
+#include<utility>
+#include<vector>
 
 namespace Dune
 {
@@ -74,6 +78,128 @@ namespace Dune
 	put(visitedMap, index.index(), false);
     }
     
+    /**
+     * @brief Compute the reverse Cuthill-McKee ordering of a graph.
+     *
+     * Each connected component is started at a pseudo-peripheral
+     * vertex, found by a breadth first search from a vertex of minimal
+     * degree.
+     * @param start The start of the adjacency list of each vertex and its end.
+     * @param adjacent The adjacent vertices.
+     * @param permutation Will store the new number of each vertex.
+     */
+    template<class T>
+    void reverseCuthillMcKee(const std::vector<std::size_t>& start,
+                             const std::vector<T>& adjacent,
+                             std::vector<T>& permutation)
+    {
+      const std::size_t n=start.size()-1;
+      std::vector<std::pair<std::size_t,T> > byDegree(n);
+      for(std::size_t i=0; i<n; ++i)
+        byDegree[i]=std::make_pair(start[i+1]-start[i], static_cast<T>(i));
+      std::sort(byDegree.begin(), byDegree.end());
+
+      std::vector<char> visited(n, false);
+      std::vector<T> order;
+      order.reserve(n);
+      std::vector<std::pair<std::size_t,T> > neighbours;
+
+      for(std::size_t s=0; s<n; ++s){
+        T root=byDegree[s].second;
+        if(visited[root])
+          continue;
+
+        // find a pseudo-peripheral vertex: the last one reached by a breadth first search
+        std::size_t first=order.size();
+        order.push_back(root);
+        visited[root]=true;
+        for(std::size_t k=first; k<order.size(); ++k)
+          for(std::size_t e=start[order[k]]; e<start[order[k]+1]; ++e)
+            if(!visited[adjacent[e]]){
+              visited[adjacent[e]]=true;
+              order.push_back(adjacent[e]);
+            }
+        root=order.back();
+        for(std::size_t k=first; k<order.size(); ++k)
+          visited[order[k]]=false;
+        order.resize(first);
+
+        // Cuthill-McKee: visit the neighbours by increasing degree
+        order.push_back(root);
+        visited[root]=true;
+        for(std::size_t k=first; k<order.size(); ++k){
+          neighbours.clear();
+          for(std::size_t e=start[order[k]]; e<start[order[k]+1]; ++e)
+            if(!visited[adjacent[e]]){
+              visited[adjacent[e]]=true;
+              neighbours.push_back(std::make_pair(start[adjacent[e]+1]-start[adjacent[e]], adjacent[e]));
+            }
+          std::sort(neighbours.begin(), neighbours.end());
+          for(std::size_t j=0; j<neighbours.size(); ++j)
+            order.push_back(neighbours[j].second);
+        }
+      }
+
+      permutation.resize(n);
+      for(std::size_t k=0; k<n; ++k)
+        permutation[order[k]]=n-1-k;
+    }
+
+    /**
+     * @brief Renumber the aggregates by the reverse Cuthill-McKee ordering
+     * of the aggregate graph.
+     *
+     * Two aggregates are adjacent if any of their vertices are. The
+     * aggregates have to be numbered consecutively.
+     * @param graph The graph the aggregates were built on.
+     * @param aggregates The aggregates map to renumber.
+     * @param noAggregates The number of aggregates.
+     */
+    template<class G>
+    void renumberAggregatesLocally(const G& graph,
+                                   AggregatesMap<typename G::VertexDescriptor>& aggregates,
+                                   std::size_t noAggregates)
+    {
+      typedef typename G::VertexDescriptor Vertex;
+      typedef typename G::ConstVertexIterator VertexIterator;
+      typedef typename G::ConstEdgeIterator EdgeIterator;
+
+      // the edges of the aggregate graph
+      std::vector<std::pair<Vertex,Vertex> > edges;
+      const VertexIterator vend=graph.end();
+      for(VertexIterator vertex=graph.begin(); vertex!=vend; ++vertex){
+        const Vertex a=aggregates[*vertex];
+        if(a>=noAggregates)
+          // isolated or unaggregated
+          continue;
+        const EdgeIterator eend=vertex.end();
+        for(EdgeIterator edge=vertex.begin(); edge!=eend; ++edge){
+          const Vertex b=aggregates[edge.target()];
+          if(b<noAggregates && b!=a)
+            edges.push_back(std::make_pair(a,b));
+        }
+      }
+      std::sort(edges.begin(), edges.end());
+      edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+      std::vector<std::size_t> start(noAggregates+1, 0);
+      std::vector<Vertex> adjacent(edges.size());
+      for(std::size_t e=0; e<edges.size(); ++e){
+        ++start[edges[e].first+1];
+        adjacent[e]=edges[e].second;
+      }
+      for(std::size_t a=0; a<noAggregates; ++a)
+        start[a+1]+=start[a];
+      std::vector<std::pair<Vertex,Vertex> >().swap(edges);
+
+      std::vector<Vertex> permutation;
+      reverseCuthillMcKee(start, adjacent, permutation);
+
+      for(VertexIterator vertex=graph.begin(); vertex!=vend; ++vertex)
+        if(aggregates[*vertex]<noAggregates)
+          aggregates[*vertex]=permutation[aggregates[*vertex]];
+    }
+
   } // namespace AMG
 } // namespace Dune
 #endif
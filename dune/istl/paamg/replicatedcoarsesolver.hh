@@ -0,0 +1,350 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_REPLICATEDCOARSESOLVER_HH
+#define DUNE_AMG_REPLICATEDCOARSESOLVER_HH
+
+#include<dune/istl/istlexception.hh>
+#include<dune/istl/solvers.hh>
+#include<dune/istl/superlu.hh>
+#include<dune/istl/preconditioners.hh>
+#include<dune/istl/operators.hh>
+#include<dune/istl/owneroverlapcopy.hh>
+#include<cstddef>
+#include<map>
+#include<vector>
+#if HAVE_MPI
+#include<dune/common/mpitraits.hh>
+#endif
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief A coarse solver that solves the whole coarse system on every
+     * process.
+     *
+     * The distributed coarsest matrix is gathered once on all processes and
+     * factorized there redundantly. Each solve then only needs one
+     * allgather of the owner part of the right hand side. Every process
+     * computes the complete solution and therefore also consistent values
+     * for its overlap and copy indices, so no communication back is needed.
+     */
+
+#if HAVE_MPI
+    /**
+     * @brief Coarse solver solving the gathered coarse system on every process.
+     *
+     * If SuperLU is available the gathered matrix is factorized with it,
+     * otherwise a sequential BiCGSTAB preconditioned with SSOR reduces the
+     * defect by 1e-2, like the default distributed coarse solver.
+     *
+     * @tparam M The type of the matrix.
+     * @tparam X The type of the vectors.
+     * @tparam C The type of the parallel information, i.e.
+     * OwnerOverlapCopyCommunication.
+     */
+    template<class M, class X, class C>
+    class ReplicatedCoarseSolver : public InverseOperator<X,X>
+    {
+    public:
+      /** @brief The type of the matrix. */
+      typedef M matrix_type;
+      /** @brief The type of the vectors. */
+      typedef X domain_type;
+      /** @brief The type of the vectors. */
+      typedef X range_type;
+      /** @brief The field type of the matrix. */
+      typedef typename M::field_type field_type;
+      /** @brief The type of the matrix blocks. */
+      typedef typename M::block_type Block;
+      /** @brief The type of the indices. */
+      typedef typename M::size_type size_type;
+
+      /**
+       * @brief Gather the matrix and set up the local solver.
+       *
+       * This is a collective operation.
+       * @param matrix The local part of the coarsest matrix. The rows of
+       * the owner indices have to be complete.
+       * @param comm The parallel information of the coarsest level.
+       */
+      ReplicatedCoarseSolver(const M& matrix, const C& comm);
+
+      ~ReplicatedCoarseSolver();
+
+      /** \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&) */
+      virtual void apply(X& x, X& b, InverseOperatorResult& res);
+
+      /** \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&) */
+      virtual void apply(X& x, X& b, double reduction, InverseOperatorResult& res);
+
+    private:
+      enum { blocksize = Block::rows };
+      typedef typename C::ParallelIndexSet::GlobalIndex GlobalIndex;
+
+      /** @brief Gather the owner part of b into globalB_. */
+      void gather(const X& b);
+      /** @brief Copy the solution of the local indices from globalX_. */
+      void scatter(X& x) const;
+      /** @brief Gather vectors of different sizes from all processes. */
+      template<class T>
+      static void allgatherv(std::vector<T>& send, std::vector<T>& receive,
+                             const std::vector<int>& counts, std::vector<int>& displacements,
+                             MPI_Comm comm);
+      /** @brief Gather one count from each process. */
+      static std::vector<int> allgatherCounts(std::size_t count, MPI_Comm comm, int procs);
+
+      /** @brief The parallel information. */
+      const C& comm_;
+      /** @brief The local indices of the owner rows in global order. */
+      std::vector<size_type> owners_;
+      /** @brief The global row of each local index, noGlobal if none. */
+      std::vector<size_type> global_;
+      /** @brief The number of field values each process contributes to a vector. */
+      std::vector<int> counts_;
+      /** @brief The offsets of the field values of each process. */
+      std::vector<int> displacements_;
+      /** @brief Buffers for the local and gathered field values. */
+      std::vector<field_type> sendBuffer_, receiveBuffer_;
+      /** @brief The gathered matrix. */
+      M globalMatrix_;
+      /** @brief The gathered right hand side and the solution. */
+      X globalB_, globalX_;
+      /** @brief The solver of the gathered system. */
+      InverseOperator<X,X>* solver_;
+#if !HAVE_SUPERLU
+      MatrixAdapter<M,X,X>* operator_;
+      SeqSSOR<M,X,X>* preconditioner_;
+#endif
+      static const size_type noGlobal = static_cast<size_type>(-1);
+    };
+
+    template<class M, class X, class C>
+    const typename ReplicatedCoarseSolver<M,X,C>::size_type ReplicatedCoarseSolver<M,X,C>::noGlobal;
+
+    template<class M, class X, class C>
+    template<class T>
+    void ReplicatedCoarseSolver<M,X,C>::allgatherv(std::vector<T>& send, std::vector<T>& receive,
+                                                   const std::vector<int>& counts,
+                                                   std::vector<int>& displacements, MPI_Comm comm)
+    {
+      displacements.resize(counts.size()+1);
+      displacements[0]=0;
+      for(std::size_t p=0; p<counts.size(); ++p)
+        displacements[p+1]=displacements[p]+counts[p];
+      receive.resize(displacements.back());
+      MPI_Allgatherv(send.empty() ? 0 : &send[0], static_cast<int>(send.size()),
+                     MPITraits<T>::getType(), receive.empty() ? 0 : &receive[0],
+                     const_cast<int*>(&counts[0]), &displacements[0],
+                     MPITraits<T>::getType(), comm);
+    }
+
+    template<class M, class X, class C>
+    std::vector<int> ReplicatedCoarseSolver<M,X,C>::allgatherCounts(std::size_t count, MPI_Comm comm,
+                                                                    int procs)
+    {
+      std::vector<int> counts(procs);
+      int local=count;
+      MPI_Allgather(&local, 1, MPI_INT, &counts[0], 1, MPI_INT, comm);
+      return counts;
+    }
+
+    template<class M, class X, class C>
+    ReplicatedCoarseSolver<M,X,C>::ReplicatedCoarseSolver(const M& matrix, const C& comm)
+      : comm_(comm), global_(matrix.N(), noGlobal), solver_(0)
+#if !HAVE_SUPERLU
+      , operator_(0), preconditioner_(0)
+#endif
+    {
+      typedef typename C::ParallelIndexSet::const_iterator IndexIterator;
+      typedef typename M::ConstColIterator ColIterator;
+
+      MPI_Comm communicator=comm.communicator();
+      const int procs=comm.communicator().size();
+
+      // The owner rows in local order, numbered consecutively across the processes
+      std::vector<GlobalIndex> localGlobals(matrix.N());
+      std::vector<bool> hasGlobal(matrix.N(), false), isOwner(matrix.N(), false);
+      for(IndexIterator index=comm.indexSet().begin(); index!=comm.indexSet().end(); ++index){
+        size_type local=index->local().local();
+        localGlobals[local]=index->global();
+        hasGlobal[local]=true;
+        isOwner[local]=index->local().attribute()==OwnerOverlapCopyAttributeSet::owner;
+      }
+      for(size_type i=0; i<matrix.N(); ++i)
+        if(isOwner[i])
+          owners_.push_back(i);
+
+      std::vector<GlobalIndex> ownerGlobals(owners_.size()), allGlobals;
+      for(size_type k=0; k<owners_.size(); ++k)
+        ownerGlobals[k]=localGlobals[owners_[k]];
+      std::vector<int> rowCounts=allgatherCounts(owners_.size(), communicator, procs);
+      allgatherv(ownerGlobals, allGlobals, rowCounts, displacements_, communicator);
+
+      std::map<GlobalIndex,size_type> globalRows;
+      for(size_type k=0; k<allGlobals.size(); ++k)
+        globalRows.insert(std::make_pair(allGlobals[k], k));
+      for(size_type i=0; i<matrix.N(); ++i){
+        if(hasGlobal[i]){
+          typename std::map<GlobalIndex,size_type>::const_iterator row=globalRows.find(localGlobals[i]);
+          if(row!=globalRows.end())
+            global_[i]=row->second;
+        }
+      }
+
+      // Gather the owner rows
+      std::vector<int> rowSizes, allRowSizes, columns, allColumns;
+      std::vector<field_type> values, allValues;
+      for(size_type k=0; k<owners_.size(); ++k){
+        const typename M::row_type& row=matrix[owners_[k]];
+        rowSizes.push_back(row.size());
+        for(ColIterator col=row.begin(); col!=row.end(); ++col){
+          if(global_[col.index()]==noGlobal)
+            DUNE_THROW(ISTLError, "Column "<<col.index()<<" of an owner row has no global index!");
+          columns.push_back(global_[col.index()]);
+          for(int i=0; i<Block::rows; ++i)
+            for(int j=0; j<Block::cols; ++j)
+              values.push_back((*col)[i][j]);
+        }
+      }
+      std::vector<int> displacements;
+      allgatherv(rowSizes, allRowSizes, rowCounts, displacements, communicator);
+      std::vector<int> nnzCounts=allgatherCounts(columns.size(), communicator, procs);
+      allgatherv(columns, allColumns, nnzCounts, displacements, communicator);
+      for(int p=0; p<procs; ++p)
+        nnzCounts[p]*=Block::rows*Block::cols;
+      allgatherv(values, allValues, nnzCounts, displacements, communicator);
+
+      const size_type n=allGlobals.size();
+      globalMatrix_.setSize(n, n, allColumns.size());
+      globalMatrix_.setBuildMode(M::row_wise);
+      size_type k=0;
+      typename std::vector<int>::const_iterator rowSize=allRowSizes.begin();
+      for(typename M::CreateIterator ci=globalMatrix_.createbegin(); ci!=globalMatrix_.createend(); ++ci, ++rowSize)
+        for(int j=0; j<*rowSize; ++j, ++k)
+          ci.insert(allColumns[k]);
+
+      typename std::vector<field_type>::const_iterator value=allValues.begin();
+      k=0;
+      rowSize=allRowSizes.begin();
+      for(size_type row=0; row<n; ++row, ++rowSize)
+        for(int j=0; j<*rowSize; ++j, ++k){
+          Block& block=globalMatrix_[row][allColumns[k]];
+          for(int r=0; r<Block::rows; ++r)
+            for(int c=0; c<Block::cols; ++c, ++value)
+              block[r][c]=*value;
+        }
+
+      // The layout of the gathered vectors
+      counts_=rowCounts;
+      for(int p=0; p<procs; ++p)
+        counts_[p]*=blocksize;
+      sendBuffer_.resize(owners_.size()*blocksize);
+      globalB_.resize(n);
+      globalX_.resize(n);
+
+#if HAVE_SUPERLU
+      solver_ = new SuperLU<M>(globalMatrix_);
+#else
+      operator_ = new MatrixAdapter<M,X,X>(globalMatrix_);
+      preconditioner_ = new SeqSSOR<M,X,X>(globalMatrix_, 1, 1.0);
+      solver_ = new BiCGSTABSolver<X>(*operator_, *preconditioner_, 1E-2, 1000, 0);
+#endif
+    }
+
+    template<class M, class X, class C>
+    ReplicatedCoarseSolver<M,X,C>::~ReplicatedCoarseSolver()
+    {
+      delete solver_;
+#if !HAVE_SUPERLU
+      delete preconditioner_;
+      delete operator_;
+#endif
+    }
+
+    template<class M, class X, class C>
+    void ReplicatedCoarseSolver<M,X,C>::gather(const X& b)
+    {
+      typename std::vector<field_type>::iterator value=sendBuffer_.begin();
+      for(size_type k=0; k<owners_.size(); ++k)
+        for(int i=0; i<blocksize; ++i, ++value)
+          *value=b[owners_[k]][i];
+      allgatherv(sendBuffer_, receiveBuffer_, counts_, displacements_, comm_.communicator());
+
+      typename std::vector<field_type>::const_iterator received=receiveBuffer_.begin();
+      for(size_type row=0; row<globalB_.N(); ++row)
+        for(int i=0; i<blocksize; ++i, ++received)
+          globalB_[row][i]=*received;
+    }
+
+    template<class M, class X, class C>
+    void ReplicatedCoarseSolver<M,X,C>::scatter(X& x) const
+    {
+      for(size_type i=0; i<global_.size(); ++i)
+        if(global_[i]==noGlobal)
+          x[i]=0;
+        else
+          x[i]=globalX_[global_[i]];
+    }
+
+    template<class M, class X, class C>
+    void ReplicatedCoarseSolver<M,X,C>::apply(X& x, X& b, InverseOperatorResult& res)
+    {
+      gather(b);
+      globalX_=0;
+      solver_->apply(globalX_, globalB_, res);
+      scatter(x);
+    }
+
+    template<class M, class X, class C>
+    void ReplicatedCoarseSolver<M,X,C>::apply(X& x, X& b, double reduction,
+                                              InverseOperatorResult& res)
+    {
+      gather(b);
+      globalX_=0;
+      solver_->apply(globalX_, globalB_, reduction, res);
+      scatter(x);
+    }
+#endif
+
+    /**
+     * @brief Creates a ReplicatedCoarseSolver if the parallel information
+     * supports it.
+     *
+     * For sequential information no solver is created.
+     */
+    template<class M, class X, class C>
+    struct ReplicatedCoarseSolverCreator
+    {
+      /**
+       * @brief Create the solver.
+       * @return The solver or 0 if replication is not supported.
+       */
+      static InverseOperator<X,X>* create(const M&, const C&)
+      {
+        return 0;
+      }
+    };
+
+#if HAVE_MPI
+    template<class M, class X, class T1, class T2>
+    struct ReplicatedCoarseSolverCreator<M,X,OwnerOverlapCopyCommunication<T1,T2> >
+    {
+      static InverseOperator<X,X>* create(const M& matrix,
+                                          const OwnerOverlapCopyCommunication<T1,T2>& comm)
+      {
+        return new ReplicatedCoarseSolver<M,X,OwnerOverlapCopyCommunication<T1,T2> >(matrix, comm);
+      }
+    };
+#endif
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
@@ -0,0 +1,160 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_REUSEPOLICY_HH
+#define DUNE_AMG_REUSEPOLICY_HH
+
+#include<cmath>
+#include<cstddef>
+#include<dune/common/exceptions.hh>
+#include<dune/istl/solvers.hh>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief Policy deciding when to reuse the aggregates of an AMG.
+     */
+
+    /**
+     * @brief Reuse the aggregates of an AMG for a sequence of systems
+     * as long as the convergence does not degrade.
+     *
+     * Intended for sequences of matrices with the same sparsity pattern
+     * and slowly changing values, e.g. in time stepping. Before each
+     * solve update is called. It only recalculates the Galerkin products
+     * and the smoothers, unless the last convergence rate passed to
+     * record indicates that the aggregates do not fit the matrix
+     * anymore. Then the hierarchy is rebuilt from scratch.
+     *
+     * The convergence rate of the first solve after a rebuild serves
+     * as the reference. As the number of iterations is proportional to
+     * \f$1/\log\rho\f$ the aggregates are kept as long as
+     * \f$\log\rho_{ref}/\log\rho\f$, i.e. the increase of the number of
+     * iterations, stays below the tolerance.
+     *
+     * @tparam C The type of the coarsening criterion used for rebuilding.
+     */
+    template<class C>
+    class AdaptiveHierarchyReuse
+    {
+    public:
+      /** @brief What update did to the hierarchy. */
+      enum Action {
+        /** @brief The Galerkin products and smoothers were recalculated. */
+        refreshed,
+        /** @brief The hierarchy was rebuilt including the aggregation. */
+        rebuilt
+      };
+
+      /**
+       * @brief Constructor.
+       * @param criterion The criterion to use for rebuilding. It is copied.
+       * @param tolerance The factor by which the number of iterations
+       * may grow before the hierarchy is rebuilt. Has to be larger than one.
+       */
+      explicit AdaptiveHierarchyReuse(const C& criterion, double tolerance=1.5)
+        : criterion_(criterion), tolerance_(tolerance), referenceRate_(0),
+          degraded_(false), refreshes_(0), rebuilds_(0)
+      {
+        if(tolerance<=1)
+          DUNE_THROW(ISTLError, "The tolerance has to be larger than one!");
+      }
+
+      /**
+       * @brief Adapt the hierarchy to the current values of the fine matrix.
+       *
+       * Has to be called after the values of the fine level matrix
+       * changed and before the next solve.
+       * @param amg The AMG to update. Its hierarchy must have been
+       * built by the AMG itself.
+       */
+      template<class AMG>
+      Action update(AMG& amg)
+      {
+        if(degraded_){
+          amg.rebuildHierarchy(criterion_);
+          degraded_=false;
+          referenceRate_=0;
+          ++rebuilds_;
+          return rebuilt;
+        }
+        amg.recalculateHierarchy();
+        ++refreshes_;
+        return refreshed;
+      }
+
+      /**
+       * @brief Record the result of a solve preconditioned by the AMG.
+       *
+       * Decides whether the next update rebuilds the hierarchy.
+       * @param result The result of the solve.
+       */
+      void record(const InverseOperatorResult& result)
+      {
+        record(result.converged ? result.conv_rate : 1.0);
+      }
+
+      /**
+       * @brief Record the convergence rate of a solve.
+       * @param rate The average reduction of the defect per iteration.
+       */
+      void record(double rate)
+      {
+        if(!(rate<1)){
+          // no convergence at all
+          degraded_=true;
+          return;
+        }
+        if(rate<=0)
+          // solved exactly, nothing to compare
+          return;
+        if(referenceRate_<=0){
+          referenceRate_=rate;
+          return;
+        }
+        degraded_ = std::log(referenceRate_) < tolerance_*std::log(rate);
+      }
+
+      /** @brief Get the convergence rate the solves are compared to. */
+      double referenceRate() const
+      {
+        return referenceRate_;
+      }
+
+      /** @brief Get the number of updates that kept the aggregates. */
+      std::size_t refreshes() const
+      {
+        return refreshes_;
+      }
+
+      /** @brief Get the number of updates that rebuilt the hierarchy. */
+      std::size_t rebuilds() const
+      {
+        return rebuilds_;
+      }
+
+    private:
+      /** @brief The criterion for rebuilding. */
+      C criterion_;
+      /** @brief The admissible growth of the number of iterations. */
+      double tolerance_;
+      /** @brief The rate of the first solve after the last build. */
+      double referenceRate_;
+      /** @brief Whether the next update has to rebuild. */
+      bool degraded_;
+      /** @brief The number of refreshes. */
+      std::size_t refreshes_;
+      /** @brief The number of rebuilds. */
+      std::size_t rebuilds_;
+    };
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
@@ -0,0 +1,311 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_SMOOTHEDAGGREGATION_HH
+#define DUNE_AMG_SMOOTHEDAGGREGATION_HH
+
+#include"aggregates.hh"
+#include<dune/istl/istlexception.hh>
+#include<dune/istl/bcrsmatrix.hh>
+#include<algorithm>
+#include<cstddef>
+#include<limits>
+#include<vector>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief Explicit prolongation matrices and Galerkin products for
+     * smoothed aggregation.
+     *
+     * The tentative prolongation \f$P_{tent}\f$ maps the unknowns of an
+     * aggregate to the corresponding coarse unknown, i.e. it has exactly one
+     * identity block per row (none for isolated vertices). Smoothed
+     * aggregation improves it by one damped Jacobi step
+     * \f$P=(I-\omega D^{-1}A)P_{tent}\f$ and uses \f$P^TAP\f$ as coarse
+     * level matrix.
+     *
+     * All functions come in two parts: the setup of the sparsity pattern and
+     * the calculation of the entries. The latter can be repeated if the
+     * entries of the fine matrix change but its pattern does not.
+     */
+
+    /**
+     * @brief Set up the sparsity pattern of the smoothed prolongation.
+     *
+     * Row i of the prolongation has an entry for the aggregate of each
+     * aggregated neighbour of i (including i itself).
+     *
+     * @param matrix The fine level matrix.
+     * @param aggregates The mapping of the fine level unknowns onto the
+     * aggregates, numbered consecutively.
+     * @param noAggregates The number of aggregates, i.e. coarse unknowns.
+     * @param prolongation The matrix to set up.
+     */
+    template<class M, class V>
+    void setupSmoothedProlongation(const M& matrix, const AggregatesMap<V>& aggregates,
+                                   typename M::size_type noAggregates, M& prolongation)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+      typedef typename M::CreateIterator CreateIterator;
+      typedef typename M::size_type size_type;
+
+      std::vector<size_type> start(matrix.N()+1, 0);
+      std::vector<size_type> columns;
+      columns.reserve(matrix.nonzeroes());
+
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row){
+        size_type first=columns.size();
+        for(ColIterator col=row->begin(); col!=row->end(); ++col){
+          const V& aggregate=aggregates[col.index()];
+          if(aggregate<AggregatesMap<V>::ISOLATED)
+            columns.push_back(aggregate);
+        }
+        std::sort(columns.begin()+first, columns.end());
+        columns.erase(std::unique(columns.begin()+first, columns.end()), columns.end());
+        start[row.index()+1]=columns.size();
+      }
+
+      prolongation.setSize(matrix.N(), noAggregates, columns.size());
+      prolongation.setBuildMode(M::row_wise);
+      size_type i=0;
+      for(CreateIterator ci=prolongation.createbegin(); ci!=prolongation.createend(); ++ci, ++i)
+        for(size_type j=start[i]; j<start[i+1]; ++j)
+          ci.insert(columns[j]);
+    }
+
+    /**
+     * @brief Calculate the entries of the smoothed prolongation
+     * \f$P=(I-\omega D^{-1}A)P_{tent}\f$.
+     *
+     * @param matrix The fine level matrix.
+     * @param aggregates The mapping of the fine level unknowns onto the
+     * aggregates.
+     * @param omega The damping factor of the Jacobi step.
+     * @param prolongation The prolongation with the pattern set up by
+     * setupSmoothedProlongation.
+     */
+    template<class M, class V>
+    void calculateSmoothedProlongation(const M& matrix, const AggregatesMap<V>& aggregates,
+                                       double omega, M& prolongation)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+      typedef typename M::block_type Block;
+
+      prolongation=0;
+      typename M::RowIterator prow=prolongation.begin();
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row, ++prow){
+        ColIterator diagonal=row->find(row.index());
+        if(diagonal==row->end())
+          DUNE_THROW(ISTLError, "Matrix row "<<row.index()<<" has no diagonal entry!");
+        Block scaling=*diagonal;
+        scaling.invert();
+        scaling*=-omega;
+
+        for(ColIterator col=row->begin(); col!=row->end(); ++col){
+          const V& aggregate=aggregates[col.index()];
+          if(aggregate>=AggregatesMap<V>::ISOLATED)
+            continue;
+          Block entry=*col;
+          entry.leftmultiply(scaling);
+          (*prow)[aggregate]+=entry;
+        }
+        const V& aggregate=aggregates[row.index()];
+        if(aggregate<AggregatesMap<V>::ISOLATED)
+          for(int i=0; i<Block::rows; ++i)
+            (*prow)[aggregate][i][i]+=1;
+      }
+    }
+
+    /**
+     * @brief Set up the smoothed prolongation \f$P=(I-\omega D^{-1}A)P_{tent}\f$.
+     *
+     * @param matrix The fine level matrix.
+     * @param aggregates The mapping of the fine level unknowns onto the
+     * aggregates, numbered consecutively.
+     * @param noAggregates The number of aggregates, i.e. coarse unknowns.
+     * @param omega The damping factor of the Jacobi step.
+     * @param prolongation The matrix to store the prolongation in.
+     */
+    template<class M, class V>
+    void buildSmoothedProlongation(const M& matrix, const AggregatesMap<V>& aggregates,
+                                   typename M::size_type noAggregates, double omega,
+                                   M& prolongation)
+    {
+      setupSmoothedProlongation(matrix, aggregates, noAggregates, prolongation);
+      calculateSmoothedProlongation(matrix, aggregates, omega, prolongation);
+    }
+
+    /**
+     * @brief Computes the Galerkin product \f$C=P^TAP\f$ row by row.
+     *
+     * Row k of C is accumulated from the rows of A belonging to the nonzeros
+     * in column k of P. The transpose of P is only stored as an index
+     * structure.
+     */
+    template<class M>
+    class GalerkinTripleProduct
+    {
+    public:
+      /** @brief The type of the matrices. */
+      typedef M Matrix;
+      /** @brief The type of the matrix blocks. */
+      typedef typename M::block_type Block;
+      /** @brief The type of the indices. */
+      typedef typename M::size_type size_type;
+
+      /**
+       * @brief Set up the sparsity pattern of \f$C=P^TAP\f$.
+       * @param prolongation The prolongation P.
+       * @param matrix The fine level matrix A.
+       * @param coarse The coarse level matrix to set up.
+       */
+      void setup(const M& prolongation, const M& matrix, M& coarse);
+
+      /**
+       * @brief Calculate the entries of \f$C=P^TAP\f$.
+       *
+       * The patterns of all three matrices have to be the same as
+       * during the last call to setup.
+       */
+      void calculate(const M& prolongation, const M& matrix, M& coarse);
+
+      /** @brief The number of bytes allocated for the transpose of P. */
+      std::size_t memory() const
+      {
+        return (start_.capacity()+fine_.capacity())*sizeof(size_type)
+          +entries_.capacity()*sizeof(const Block*);
+      }
+
+    private:
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+
+      /** @brief Build the index structure of the transpose of P. */
+      void transpose(const M& prolongation);
+
+      /** @brief The start of the rows of the transpose of P. */
+      std::vector<size_type> start_;
+      /** @brief The fine level row of each entry of the transpose of P. */
+      std::vector<size_type> fine_;
+      /** @brief The entries of the transpose of P (not transposed). */
+      std::vector<const Block*> entries_;
+    };
+
+    template<class M>
+    void GalerkinTripleProduct<M>::transpose(const M& prolongation)
+    {
+      start_.assign(prolongation.M()+1, 0);
+      for(RowIterator row=prolongation.begin(); row!=prolongation.end(); ++row)
+        for(ColIterator col=row->begin(); col!=row->end(); ++col)
+          ++start_[col.index()+1];
+      for(size_type k=0; k<prolongation.M(); ++k)
+        start_[k+1]+=start_[k];
+
+      std::vector<size_type> position(start_.begin(), start_.end()-1);
+      fine_.resize(prolongation.nonzeroes());
+      entries_.resize(prolongation.nonzeroes());
+      for(RowIterator row=prolongation.begin(); row!=prolongation.end(); ++row)
+        for(ColIterator col=row->begin(); col!=row->end(); ++col){
+          size_type& p=position[col.index()];
+          fine_[p]=row.index();
+          entries_[p]=&(*col);
+          ++p;
+        }
+    }
+
+    template<class M>
+    void GalerkinTripleProduct<M>::setup(const M& prolongation, const M& matrix, M& coarse)
+    {
+      transpose(prolongation);
+      const size_type n=prolongation.M();
+      const size_type unmarked=std::numeric_limits<size_type>::max();
+
+      std::vector<size_type> marker(n, unmarked);
+      std::vector<size_type> rowStart(n+1, 0);
+      std::vector<size_type> columns;
+
+      for(size_type k=0; k<n; ++k){
+        size_type first=columns.size();
+        for(size_type e=start_[k]; e<start_[k+1]; ++e){
+          const typename M::row_type& arow=matrix[fine_[e]];
+          for(ColIterator a=arow.begin(); a!=arow.end(); ++a){
+            const typename M::row_type& prow=prolongation[a.index()];
+            for(ColIterator p=prow.begin(); p!=prow.end(); ++p)
+              if(marker[p.index()]!=k){
+                marker[p.index()]=k;
+                columns.push_back(p.index());
+              }
+          }
+        }
+        std::sort(columns.begin()+first, columns.end());
+        rowStart[k+1]=columns.size();
+      }
+
+      coarse.setSize(n, n, columns.size());
+      coarse.setBuildMode(M::row_wise);
+      size_type k=0;
+      for(typename M::CreateIterator ci=coarse.createbegin(); ci!=coarse.createend(); ++ci, ++k)
+        for(size_type j=rowStart[k]; j<rowStart[k+1]; ++j)
+          ci.insert(columns[j]);
+
+      calculate(prolongation, matrix, coarse);
+    }
+
+    template<class M>
+    void GalerkinTripleProduct<M>::calculate(const M& prolongation, const M& matrix, M& coarse)
+    {
+      if(start_.size()!=prolongation.M()+1 || fine_.size()!=prolongation.nonzeroes())
+        DUNE_THROW(ISTLError, "The pattern of the prolongation changed, call setup first!");
+      // the pointers into the prolongation might be outdated
+      transpose(prolongation);
+
+      const size_type n=prolongation.M();
+      std::vector<Block> row(n);
+      Block product;
+
+      for(typename M::RowIterator crow=coarse.begin(); crow!=coarse.end(); ++crow){
+        const size_type k=crow.index();
+        typedef typename M::ColIterator CColIterator;
+        for(CColIterator c=crow->begin(); c!=crow->end(); ++c)
+          row[c.index()]=0;
+
+        for(size_type e=start_[k]; e<start_[k+1]; ++e){
+          const Block& pik=*entries_[e];
+          const typename M::row_type& arow=matrix[fine_[e]];
+          for(ColIterator a=arow.begin(); a!=arow.end(); ++a){
+            // product = P_ik^T A_ij
+            product=0;
+            for(int r=0; r<Block::rows; ++r)
+              for(int s=0; s<Block::cols; ++s)
+                for(int t=0; t<Block::rows; ++t)
+                  product[r][s]+=pik[t][r]*(*a)[t][s];
+
+            const typename M::row_type& prow=prolongation[a.index()];
+            for(ColIterator p=prow.begin(); p!=prow.end(); ++p){
+              Block& target=row[p.index()];
+              for(int r=0; r<Block::rows; ++r)
+                for(int s=0; s<Block::cols; ++s)
+                  for(int t=0; t<Block::cols; ++t)
+                    target[r][s]+=product[r][t]*(*p)[t][s];
+            }
+          }
+        }
+
+        for(CColIterator c=crow->begin(); c!=crow->end(); ++c)
+          *c=row[c.index()];
+      }
+    }
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
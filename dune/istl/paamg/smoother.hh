@@ -1,8 +1,13 @@
 #ifndef DUNE_AMGSMOOTHER_HH
 #define DUNE_AMGSMOOTHER_HH
 
+#include<algorithm>
+#include<cstddef>
+#include<utility>
+#include<vector>
 #include<dune/istl/paamg/construction.hh>
 #include<dune/istl/paamg/aggregates.hh>
+#include<dune/istl/paamg/l1smoother.hh>
 #include<dune/istl/preconditioners.hh>
 #include<dune/istl/schwarz.hh>
 #include<dune/istl/novlpschwarz.hh>
@@ -307,6 +312,46 @@ namespace Dune
       }
     };
 
+    /**
+     * @brief Policy for the construction of the L1Jacobi smoother
+     */
+    template<class M, class X, class Y, class C>
+    struct ConstructionTraits<L1Jacobi<M,X,Y,C> >
+    {
+      typedef DefaultParallelConstructionArgs<L1Jacobi<M,X,Y,C>,C> Arguments;
+      
+      static inline L1Jacobi<M,X,Y,C>* construct(Arguments& args)
+      {
+	return new L1Jacobi<M,X,Y,C>(args.getMatrix(), args.getArgs().iterations,
+				     args.getArgs().relaxationFactor,
+				     args.getComm());
+      }      
+      static inline void deconstruct(L1Jacobi<M,X,Y,C>* jac)
+      {
+	delete jac;
+      }
+    };
+
+    /**
+     * @brief Policy for the construction of the L1GaussSeidel smoother
+     */
+    template<class M, class X, class Y, class C>
+    struct ConstructionTraits<L1GaussSeidel<M,X,Y,C> >
+    {
+      typedef DefaultParallelConstructionArgs<L1GaussSeidel<M,X,Y,C>,C> Arguments;
+      
+      static inline L1GaussSeidel<M,X,Y,C>* construct(Arguments& args)
+      {
+	return new L1GaussSeidel<M,X,Y,C>(args.getMatrix(), args.getArgs().iterations,
+					  args.getArgs().relaxationFactor,
+					  args.getComm());
+      }      
+      static inline void deconstruct(L1GaussSeidel<M,X,Y,C>* gs)
+      {
+	delete gs;
+      }
+    };
+
     template<class X, class Y, class C, class T>
     struct ConstructionTraits<BlockPreconditioner<X,Y,C,T> >
     {
@@ -406,6 +451,25 @@ namespace Dune
       }
     };
 
+    template<class M, class X, class Y, class C>
+    struct SmootherApplier<L1GaussSeidel<M,X,Y,C> >
+    {
+      typedef L1GaussSeidel<M,X,Y,C> Smoother;
+      typedef typename Smoother::range_type Range;
+      typedef typename Smoother::domain_type Domain;
+      
+      static void preSmooth(Smoother& smoother, Domain& v, Range& d)
+      {
+	smoother.template apply<true>(v,d);
+      }
+
+       
+      static void postSmooth(Smoother& smoother, Domain& v, Range& d)
+      {
+	smoother.template apply<false>(v,d);
+      }
+    };
+
     template<class M, class X, class Y, class C, int l>
     struct SmootherApplier<BlockPreconditioner<X,Y,C,SeqSOR<M,X,Y,l> > >
     {
@@ -524,27 +588,29 @@ namespace Dune
 	
 	typedef SeqOverlappingSchwarzSmootherArgs<typename M::field_type> SmootherArgs;
 	
+	SubdomainBuilder builder;
+
 	switch(Father::getArgs().overlap){
 	case SmootherArgs::vertex:
 	  {  
-	  VertexAdder visitor(subdomains, amap);
-	  createSubdomains(matrix, graph, amap, visitor,  visitedMap);
+	  VertexAdder visitor(builder, amap);
+	  createSubdomains(matrix, graph, amap, builder, visitor,  visitedMap);
 	  }
 	  break;
 	case SmootherArgs::pairwise:
 	  {
-	    createPairDomains(graph);
+	    createPairDomains(graph, builder);
 	  }
 	  break;
 	case SmootherArgs::aggregate:
 	  {
-	  AggregateAdder<VisitedMapType> visitor(subdomains, amap, graph, visitedMap);
-	  createSubdomains(matrix, graph, amap, visitor, visitedMap);
+	  AggregateAdder<VisitedMapType> visitor(builder, amap, graph, visitedMap);
+	  createSubdomains(matrix, graph, amap, builder, visitor, visitedMap);
 	  }
 	  break;
 	case SmootherArgs::none:
 	  NoneAdder visitor;
-	  createSubdomains(matrix, graph, amap, visitor, visitedMap);
+	  createSubdomains(matrix, graph, amap, builder, visitor, visitedMap);
 	  break;
 	default:
 	  DUNE_THROW(NotImplemented, "This overlapping scheme is not supported!");
@@ -569,30 +635,32 @@ namespace Dune
 	
 	typedef SeqOverlappingSchwarzSmootherArgs<typename M::field_type> SmootherArgs;
 	
+	SubdomainBuilder builder;
+
 	switch(Father::getArgs().overlap){
 	case SmootherArgs::vertex:
 	  {  
-	  VertexAdder visitor(subdomains, amap);
-	  createSubdomains(matrix, graph, amap, visitor,  visitedMap);
+	  VertexAdder visitor(builder, amap);
+	  createSubdomains(matrix, graph, amap, builder, visitor,  visitedMap);
 	  }
 	  break;
 	case SmootherArgs::aggregate:
 	  {
 	    DUNE_THROW(NotImplemented, "Aggregate overlap is not supported yet");
 	    /*
-	  AggregateAdder<VisitedMapType> visitor(subdomains, amap, graph, visitedMap);
-	  createSubdomains(matrix, graph, amap, visitor, visitedMap);
+	  AggregateAdder<VisitedMapType> visitor(builder, amap, graph, visitedMap);
+	  createSubdomains(matrix, graph, amap, builder, visitor, visitedMap);
 	    */
 	  }
 	  break;
 	case SmootherArgs::pairwise:
 	  {
-	    createPairDomains(graph);
+	    createPairDomains(graph, builder);
 	  }
 	  break;
 	case SmootherArgs::none:
 	  NoneAdder visitor;
-	  createSubdomains(matrix, graph, amap, visitor, visitedMap);
+	  createSubdomains(matrix, graph, amap, builder, visitor, visitedMap);
 	  
 	}
       }
@@ -603,16 +671,111 @@ namespace Dune
       }
       
     private:
+      /**
+       * @brief Builds the subdomains from a flat list of
+       * (subdomain, vertex) pairs.
+       *
+       * Inserting each vertex into a std::set while traversing the
+       * graph is expensive. Instead all pairs are appended to one
+       * array, which is sorted into compressed row storage at the end.
+       */
+      class SubdomainBuilder
+      {
+      public:
+	/** @brief Add a vertex to a subdomain. Duplicates are allowed. */
+	void add(std::size_t subdomain, VertexDescriptor vertex)
+	{
+	  entries.push_back(std::make_pair(subdomain, vertex));
+	}
+
+	/**
+	 * @brief Sort the pairs added into compressed row storage.
+	 *
+	 * The vertices of subdomain d are stored sorted and without
+	 * duplicates in vertices[start[d]] to vertices[start[d+1]-1].
+	 * The pairs added are released.
+	 * @param n The number of subdomains.
+	 */
+	void compress(std::size_t n, std::vector<std::size_t>& start,
+		      std::vector<VertexDescriptor>& vertices)
+	{
+	  typedef typename std::vector<std::pair<std::size_t,VertexDescriptor> >::const_iterator Iter;
+
+	  // counting sort by subdomain
+	  start.assign(n+1, 0);
+	  for(Iter e=entries.begin(); e!=entries.end(); ++e)
+	    ++start[e->first+1];
+	  for(std::size_t d=0; d<n; ++d)
+	    start[d+1]+=start[d];
+	  vertices.resize(entries.size());
+	  {
+	    std::vector<std::size_t> next(start.begin(), start.end()-1);
+	    for(Iter e=entries.begin(); e!=entries.end(); ++e)
+	      vertices[next[e->first]++]=e->second;
+	  }
+	  std::vector<std::pair<std::size_t,VertexDescriptor> >().swap(entries);
+
+	  // sort the subdomains independently
+	  std::vector<std::size_t> end(n);
+	  const std::ptrdiff_t domains=n;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,64)
+#endif
+	  for(std::ptrdiff_t d=0; d<domains; ++d){
+	    typename std::vector<VertexDescriptor>::iterator first=vertices.begin()+start[d],
+	      last=vertices.begin()+start[d+1];
+	    std::sort(first, last);
+	    end[d]=std::unique(first, last)-vertices.begin();
+	  }
+
+	  // remove the gaps left by the duplicates
+	  std::size_t k=0;
+	  for(std::size_t d=0; d<n; ++d){
+	    const std::size_t first=start[d];
+	    start[d]=k;
+	    for(std::size_t j=first; j<end[d]; ++j)
+	      vertices[k++]=vertices[j];
+	  }
+	  start[n]=k;
+	  vertices.resize(k);
+	}
+
+	/**
+	 * @brief Create the subdomains from the pairs added.
+	 * @param subdomains The vector to store the subdomains in.
+	 * @param n The number of subdomains.
+	 */
+	void build(Vector& subdomains, std::size_t n)
+	{
+	  std::vector<std::size_t> start;
+	  std::vector<VertexDescriptor> vertices;
+	  compress(n, start, vertices);
+
+	  subdomains.clear();
+	  subdomains.resize(n);
+	  const std::ptrdiff_t domains=n;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic,64)
+#endif
+	  for(std::ptrdiff_t d=0; d<domains; ++d)
+	    // the range is sorted, hence inserting takes linear time.
+	    subdomains[d].insert(vertices.begin()+start[d], vertices.begin()+start[d+1]);
+	}
+
+      private:
+	std::vector<std::pair<std::size_t,VertexDescriptor> > entries;
+      };
+
       struct VertexAdder
       {
-	VertexAdder(Vector& subdomains_, const AggregatesMap& aggregates_)
-	  : subdomains(subdomains_), max(-1), subdomain(-1), aggregates(aggregates_)
+	VertexAdder(SubdomainBuilder& builder_, const AggregatesMap& aggregates_)
+	  : builder(builder_), max(-1), subdomain(-1), aggregates(aggregates_)
 	{}
 	template<class T>
 	void operator()(const T& edge)
 	{
 	  if(aggregates[edge.target()]!=AggregatesMap::ISOLATED)
-	    subdomains[subdomain].insert(edge.target());
+	    builder.add(subdomain, edge.target());
 	}
 	int setAggregate(const AggregateDescriptor& aggregate_)
 	{
@@ -625,7 +788,7 @@ namespace Dune
 	  return max+1;
 	}
       private:
-	Vector& subdomains;
+	SubdomainBuilder& builder;
 	AggregateDescriptor max;
 	AggregateDescriptor subdomain;
 	const AggregatesMap& aggregates;
@@ -648,15 +811,15 @@ namespace Dune
       template<class VM>
       struct AggregateAdder
       {
-	AggregateAdder(Vector& subdomains_, const AggregatesMap& aggregates_, 
+	AggregateAdder(SubdomainBuilder& builder_, const AggregatesMap& aggregates_, 
 		       const MatrixGraph<const M>& graph_, VM& visitedMap_)
-	  : subdomains(subdomains_), subdomain(-1), aggregates(aggregates_),
-	    adder(subdomains_, aggregates_), graph(graph_), visitedMap(visitedMap_)
+	  : builder(builder_), subdomain(-1), aggregates(aggregates_),
+	    adder(builder_, aggregates_), graph(graph_), visitedMap(visitedMap_)
 	{}
 	template<class T>
 	void operator()(const T& edge)
 	{
-	  subdomains[subdomain].insert(edge.target());
+	  builder.add(aggregate, edge.target());
 	  // If we (the neighbouring vertex of the aggregate)
 	  // are not isolated, add the aggregate we belong to 
 	  // to the same subdomain using the OneOverlapAdder
@@ -673,7 +836,9 @@ namespace Dune
 	{
 	  adder.setAggregate(aggregate_);
 	  aggregate=aggregate_;
-	  return ++subdomain;
+	  ++subdomain;
+	  // The subdomain of an aggregate is the one the VertexAdder uses.
+	  return aggregate;
 	}
 	int noSubdomains() const
 	{
@@ -682,7 +847,7 @@ namespace Dune
 	
       private:
 	AggregateDescriptor aggregate;
-	Vector& subdomains;
+	SubdomainBuilder& builder;
 	int subdomain;
 	const AggregatesMap& aggregates;
 	VertexAdder adder;
@@ -690,34 +855,38 @@ namespace Dune
 	VM& visitedMap;
       };
       
-      void createPairDomains(const MatrixGraph<const M>& graph)
+      void createPairDomains(const MatrixGraph<const M>& graph, SubdomainBuilder& builder)
       {
 	typedef typename MatrixGraph<const M>::ConstVertexIterator VIter;
 	typedef typename MatrixGraph<const M>::ConstEdgeIterator EIter;
-	typedef typename M::size_type size_type;
 	
-	std::set<std::pair<size_type,size_type> > pairs;
+	// Collect the pairs bucketed by their smaller vertex.
 	int total=0;
 	for(VIter v=graph.begin(), ve=graph.end(); ve != v; ++v)
 	  for(EIter e = v.begin(), ee=v.end(); ee!=e; ++e)
 	    {
 	      ++total;
 	    if(e.source()<e.target())
-	      pairs.insert(std::make_pair(e.source(),e.target()));
+	      builder.add(e.source(), e.target());
 	    else
-	      pairs.insert(std::make_pair(e.target(),e.source()));
+	      builder.add(e.target(), e.source());
 	    }
 	
+	std::vector<std::size_t> start;
+	std::vector<VertexDescriptor> partners;
+	builder.compress(graph.noVertices(), start, partners);
 	
-	subdomains.resize(pairs.size());
-        Dune::dinfo <<std::endl<< "Created "<<pairs.size()<<" ("<<total<<") pair domains"<<std::endl<<std::endl;
-	typedef typename std::set<std::pair<size_type,size_type> >::const_iterator SIter;
+	subdomains.clear();
+	subdomains.resize(partners.size());
+        Dune::dinfo <<std::endl<< "Created "<<partners.size()<<" ("<<total<<") pair domains"<<std::endl<<std::endl;
 	typename Vector::iterator subdomain=subdomains.begin();
 	
-	for(SIter s=pairs.begin(), se =pairs.end(); se!=s; ++s)
+	// Same order as the lexicographically sorted pairs
+	for(std::size_t i=0; i+1 < start.size(); ++i)
+	  for(std::size_t j=start[i]; j<start[i+1]; ++j)
 	  {
-	    subdomain->insert(s->first);
-	    subdomain->insert(s->second);
+	    subdomain->insert(i);
+	    subdomain->insert(partners[j]);
 	    ++subdomain;
 	  }
 	std::size_t minsize=10000;
@@ -734,50 +903,46 @@ namespace Dune
       
       template<class Visitor>
       void createSubdomains(const M& matrix, const MatrixGraph<const M>& graph, 
-			    const AggregatesMap& amap, Visitor& overlapVisitor, 
+			    const AggregatesMap& amap, SubdomainBuilder& builder,
+			    Visitor& overlapVisitor, 
 			    IteratorPropertyMap<std::vector<bool>::iterator,IdentityMap>& visitedMap )
       {
 	// count  number ag aggregates. We asume that the
 	// aggregates are numbered consecutively from 0 exept
-	// for the isolated ones. All isolated vertices form 
-	// one aggregate, here.
+	// for the isolated ones. Each isolated vertex forms
+	// a subdomain of its own numbered after the aggregates.
 	int isolated=0;
-	AggregateDescriptor maxAggregate=0;
+	std::size_t noAggregates=0;
 	
 	for(std::size_t i=0; i < amap.noVertices(); ++i)
 	  if(amap[i]==AggregatesMap::ISOLATED)
 	    isolated++;
 	  else
-	    maxAggregate = std::max(maxAggregate, amap[i]);
-	
-	subdomains.resize(maxAggregate+1+isolated);
-
-	// reset the subdomains
-	for(typename Vector::size_type i=0; i < subdomains.size(); ++i)
-	  subdomains[i].clear();
+	    noAggregates = std::max<std::size_t>(noAggregates, amap[i]+1);
 	
 	// Create the subdomains from the aggregates mapping.
 	// For each aggregate we mark all entries and the 
 	// neighbouring vertices as belonging to the same subdomain
-	VertexAdder aggregateVisitor(subdomains, amap);
+	VertexAdder aggregateVisitor(builder, amap);
+	AggregateDescriptor nextIsolated=noAggregates;
 		
 	for(VertexDescriptor i=0; i < amap.noVertices(); ++i)
 	  if(!get(visitedMap, i)){
 	    AggregateDescriptor aggregate=amap[i];
 
-	    if(amap[i]==AggregatesMap::ISOLATED){
+	    if(amap[i]==AggregatesMap::ISOLATED)
 	      // isolated vertex gets its own aggregate
- 	      subdomains.push_back(Subdomain());
- 	      aggregate=subdomains.size()-1;
-	    }
+	      aggregate=nextIsolated++;
 	    overlapVisitor.setAggregate(aggregate);
 	    aggregateVisitor.setAggregate(aggregate);
-	    subdomains[aggregate].insert(i);
+	    builder.add(aggregate, i);
 	    typename AggregatesMap::VertexList vlist;	    
 	    amap.template breadthFirstSearch<false,false>(i, aggregate, graph, vlist, aggregateVisitor, 
 	    		    overlapVisitor, visitedMap);
 	  }
 	
+	builder.build(subdomains, noAggregates+isolated);
+	
 	std::size_t minsize=10000;
 	std::size_t maxsize=0;
 	int sum=0;
@@ -0,0 +1,198 @@
+// -*- tab-width: 8; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=8 sw=2 et sts=2:
+#ifndef DUNE_AMG_STATISTICS_HH
+#define DUNE_AMG_STATISTICS_HH
+
+#include<cstddef>
+#include<iomanip>
+#include<ostream>
+#include<vector>
+
+namespace Dune
+{
+  namespace Amg
+  {
+    /**
+     * @addtogroup ISTL_PAAMG
+     *
+     * @{
+     */
+    /** @file
+     * @brief Statistics about the setup and the cycles of the AMG.
+     */
+
+    /**
+     * @brief Statistics about one level of the AMG hierarchy.
+     *
+     * All numbers are local to the process.
+     */
+    struct AMGLevelStatistics
+    {
+      AMGLevelStatistics()
+        : rows(0), nonzeros(0), memory(0), setupMemory(0), aggregationTime(0),
+          galerkinTime(0), smootherSetupTime(0), smoothingTime(0), transferTime(0)
+      {}
+
+      /** @brief The number of (block) rows of the matrix. */
+      std::size_t rows;
+      /** @brief The number of scalar nonzeros of the matrix. */
+      std::size_t nonzeros;
+      /**
+       * @brief The estimated number of bytes of the matrix, the aggregates
+       * and the transfer data to the next coarser level.
+       */
+      std::size_t memory;
+      /**
+       * @brief The estimated number of bytes of the temporary graphs
+       * needed to coarsen this level.
+       */
+      std::size_t setupMemory;
+      /**
+       * @brief The time needed to aggregate this level, including the
+       * setup of the matrix graph and the coarse index set.
+       */
+      double aggregationTime;
+      /**
+       * @brief The time needed to compute the matrix of the next coarser
+       * level (and the transfer operators).
+       */
+      double galerkinTime;
+      /** @brief The time needed to set up the smoother of this level. */
+      double smootherSetupTime;
+      /** @brief The time spent in pre and post smoothing on this level. */
+      double smoothingTime;
+      /**
+       * @brief The time spent in the restriction to and the prolongation
+       * from the next coarser level.
+       */
+      double transferTime;
+    };
+
+    /**
+     * @brief Statistics about the setup and the cycles of the AMG.
+     *
+     * The level data is ordered from the finest to the coarsest level.
+     * The setup data is filled in by MatrixHierarchy and AMG, the solve
+     * data is accumulated by AMG from the call to pre on.
+     */
+    struct AMGStatistics
+    {
+      AMGStatistics()
+        : peakSetupMemory(0), setupTime(0), coarseSolverSetupTime(0), coarseSolveTime(0),
+          cycles(0)
+      {}
+
+      /** @brief The statistics of the levels. */
+      std::vector<AMGLevelStatistics> levels;
+      /**
+       * @brief The estimated peak number of bytes needed during the build
+       * of the matrix hierarchy.
+       *
+       * This is the maximum over the build of the sizes of the data
+       * structures alive at the same time, computed from their sizes and
+       * capacities. It is not measured from the memory of the process
+       * and does not include the overhead of the allocator.
+       */
+      std::size_t peakSetupMemory;
+      /** @brief The time needed to build (or load) the matrix hierarchy. */
+      double setupTime;
+      /** @brief The time needed to set up the coarse solver. */
+      double coarseSolverSetupTime;
+      /** @brief The time spent in the coarse solver. */
+      double coarseSolveTime;
+      /** @brief The number of cycles applied. */
+      std::size_t cycles;
+
+      /**
+       * @brief Get the operator complexity.
+       * @return The number of nonzeros of all levels divided by the number
+       * of nonzeros of the finest level.
+       */
+      double operatorComplexity() const
+      {
+        std::size_t nonzeros=0;
+        for(std::size_t l=0; l<levels.size(); ++l)
+          nonzeros+=levels[l].nonzeros;
+        return levels.empty() || levels[0].nonzeros==0 ? 0 :
+          static_cast<double>(nonzeros)/levels[0].nonzeros;
+      }
+
+      /**
+       * @brief Get the grid complexity.
+       * @return The number of rows of all levels divided by the number of
+       * rows of the finest level.
+       */
+      double gridComplexity() const
+      {
+        std::size_t rows=0;
+        for(std::size_t l=0; l<levels.size(); ++l)
+          rows+=levels[l].rows;
+        return levels.empty() || levels[0].rows==0 ? 0 :
+          static_cast<double>(rows)/levels[0].rows;
+      }
+
+      /**
+       * @brief Get the estimated number of bytes of the matrix hierarchy.
+       */
+      std::size_t memory() const
+      {
+        std::size_t bytes=0;
+        for(std::size_t l=0; l<levels.size(); ++l)
+          bytes+=levels[l].memory;
+        return bytes;
+      }
+
+      /** @brief Reset the data accumulated during the cycles. */
+      void clearSolveStatistics()
+      {
+        for(std::size_t l=0; l<levels.size(); ++l){
+          levels[l].smoothingTime=0;
+          levels[l].transferTime=0;
+        }
+        coarseSolveTime=0;
+        cycles=0;
+      }
+
+      /**
+       * @brief Print a table of the statistics.
+       * @param os The stream to print to.
+       */
+      void print(std::ostream& os) const
+      {
+        os<<"level        rows    nonzeros   aggregate    galerkin  smoothsetup"
+          <<"      smooth    transfer"<<std::endl;
+        for(std::size_t l=0; l<levels.size(); ++l){
+          const AMGLevelStatistics& s=levels[l];
+          os<<std::setw(5)<<l<<std::setw(12)<<s.rows<<std::setw(12)<<s.nonzeros
+            <<std::setw(12)<<s.aggregationTime<<std::setw(12)<<s.galerkinTime
+            <<std::setw(13)<<s.smootherSetupTime<<std::setw(12)<<s.smoothingTime
+            <<std::setw(12)<<s.transferTime<<std::endl;
+        }
+        os<<"operator complexity: "<<operatorComplexity()
+          <<", grid complexity: "<<gridComplexity()<<std::endl;
+        os<<"memory: "<<memory()/1024<<"kB, estimated peak setup memory: "
+          <<peakSetupMemory/1024<<"kB"<<std::endl;
+        os<<"setup: "<<setupTime<<"s, coarse solver setup: "<<coarseSolverSetupTime
+          <<"s, coarse solves: "<<coarseSolveTime<<"s, cycles: "<<cycles<<std::endl;
+      }
+    };
+
+    /**
+     * @brief Estimate the number of bytes allocated for a sparse matrix.
+     * @param matrix The matrix, e.g. a BCRSMatrix.
+     */
+    template<class M>
+    std::size_t matrixMemory(const M& matrix)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      std::size_t nonzeros=0;
+      for(RowIterator row=matrix.begin(); row!=matrix.end(); ++row)
+        nonzeros+=row->size();
+      return matrix.N()*sizeof(typename M::row_type)
+        +nonzeros*(sizeof(typename M::block_type)+sizeof(typename M::size_type));
+    }
+
+    /** @} */
+  } // namespace Amg
+} // namespace Dune
+#endif
@@ -16,12 +16,22 @@ namespace std
 #include"anisotropic.hh"
 #include<dune/common/timer.hh>
 #include<dune/istl/paamg/amg.hh>
+#include<dune/istl/paamg/mixedprecision.hh>
 #include<dune/istl/paamg/pinfo.hh>
+#include<dune/istl/paamg/reusepolicy.hh>
 #include<dune/common/parallel/indexset.hh>
 #include<dune/istl/solvers.hh>
+#include<dune/istl/overlappingschwarz.hh>
 #include<dune/common/collectivecommunication.hh>
+#include<cmath>
 #include<cstdlib>
 #include<ctime>
+#include<map>
+#include<set>
+#include<sstream>
+#ifdef _OPENMP
+#include<omp.h>
+#endif
 
 typedef double XREAL;
 
@@ -55,12 +65,135 @@ void randomize(const M& mat, V& b)
   mat.mv(static_cast<const V&>(x), b);
 }
 
+/**
+ * @brief The anisotropic problem with a random right hand side and
+ * the criterion used to build its AMG.
+ *
+ * @tparam M The matrix type.
+ * @tparam V The vector type.
+ * @tparam C The coarsening criterion.
+ */
+template<class M, class V,
+         class C=Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<M,Dune::Amg::FirstDiagonal> > >
+struct AnisotropicProblem
+{
+  typedef M BCRSMat;
+  typedef V Vector;
+  typedef Dune::MatrixAdapter<M,V,V> Operator;
+  typedef C Criterion;
+
+  AnisotropicProblem(int N, int coarsenTarget, int ml)
+    : mat(setupMatrix(N)), fop(mat), b(mat.N()), x(mat.M()), criterion(15,coarsenTarget)
+  {
+    x=0;
+    randomize(mat, b);
+    criterion.setDefaultValuesIsotropic(2);
+    criterion.setMaxLevel(ml);
+  }
 
+  static M setupMatrix(int N)
+  {
+    typedef Dune::ParallelIndexSet<int,LocalIndex,512> ParallelIndexSet;
+    ParallelIndexSet indices;
+    Dune::CollectiveCommunication<void*> c;
+    int n;
+    return setupAnisotropic2d<M::block_type::rows,typename M::field_type>(N, indices, c, &n, 1);
+  }
+
+  M mat;
+  Operator fop;
+  V b;
+  V x;
+  Criterion criterion;
+};
+
+/**
+ * @brief Arguments for one unrelaxed smoothing step.
+ */
+template<class Smoother>
+typename Dune::Amg::SmootherTraits<Smoother>::Arguments smootherArguments()
+{
+  typename Dune::Amg::SmootherTraits<Smoother>::Arguments smootherArgs;
+  smootherArgs.iterations = 1;
+  smootherArgs.relaxationFactor = 1;
+  return smootherArgs;
+}
+
+
+/**
+ * @brief Compare the coarse matrices of a hierarchy entry by entry with
+ * Galerkin products computed from scratch on the same aggregates.
+ *
+ * Levels with smoothed prolongations are compared with a newly set up
+ * triple product.
+ * @return The number of levels that differ.
+ */
+template<class H>
+int checkGalerkinProducts(const H& hierarchy)
+{
+  typedef typename H::Matrix Matrix;
+  typedef typename H::ParallelInformation PI;
+  typedef typename H::ParallelMatrixHierarchy::ConstIterator Iterator;
+  typedef typename H::ParallelInformationHierarchy::ConstIterator InfoIterator;
+
+  typename H::AggregatesMapList::const_iterator aggregates=hierarchy.aggregatesMaps().begin();
+  typename H::ProlongationList::const_iterator prolongation=hierarchy.prolongations().begin();
+  InfoIterator info=hierarchy.parallelInformation().finest();
+  int ret=0, level=1;
+  for(Iterator coarse=hierarchy.matrices().finest(); coarse!=hierarchy.matrices().coarsest();
+      ++aggregates, ++prolongation, ++info, ++level){
+    const Matrix& fine=coarse->getmat();
+    ++coarse;
+    const Matrix& matrix=coarse->getmat();
+    Matrix product(matrix);
+    if(*prolongation){
+      Dune::Amg::GalerkinTripleProduct<Matrix> tripleProduct;
+      tripleProduct.setup(**prolongation, fine, product);
+    }else{
+      Dune::Amg::BaseGalerkinProduct productBuilder;
+      productBuilder.calculate(fine, **aggregates, product, *info,
+                               Dune::NegateSet<typename PI::OwnerSet>());
+    }
+    if(product.N()!=matrix.N() || product.nonzeroes()!=matrix.nonzeroes()){
+      std::cerr<<"Coarse matrix on level "<<level<<" has the wrong pattern"<<std::endl;
+      ++ret;
+      continue;
+    }
+    const double tolerance=1e-10*product.frobenius_norm();
+    bool equal=true;
+    typename Matrix::ConstRowIterator row=matrix.begin();
+    for(typename Matrix::ConstRowIterator expectedRow=product.begin();
+        equal && expectedRow!=product.end(); ++expectedRow, ++row){
+      typename Matrix::ConstColIterator col=row->begin();
+      for(typename Matrix::ConstColIterator expected=expectedRow->begin();
+          equal && expected!=expectedRow->end(); ++expected, ++col){
+        typename Matrix::block_type diff=*col;
+        diff-=*expected;
+        equal = col.index()==expected.index() && diff.frobenius_norm()<=tolerance;
+      }
+      if(!equal){
+        std::cerr<<"Coarse matrix on level "<<level<<" differs from the Galerkin product in row "
+                 <<row.index()<<std::endl;
+        ++ret;
+      }
+    }
+  }
+  return ret;
+}
+
+/**
+ * @brief Solve the anisotropic problem with the AMG set up by parms.
+ *
+ * Afterwards the hierarchy is recalculated for scaled matrix entries,
+ * its coarse matrices are compared with the Galerkin products and the
+ * problem is solved again.
+ * @return The number of failed checks.
+ */
 template <int BS>
-void testAMG(int N, int coarsenTarget, int ml)
+int testAMG(int N, const Dune::Amg::Parameters& parms)
 {
     
-  std::cout<<"N="<<N<<" coarsenTarget="<<coarsenTarget<<" maxlevel="<<ml<<std::endl;
+  std::cout<<"N="<<N<<" coarsenTarget="<<parms.coarsenTarget()<<" maxlevel="<<parms.maxLevel()<<std::endl;
   
 
   typedef Dune::ParallelIndexSet<int,LocalIndex,512> ParallelIndexSet;
@@ -117,12 +250,7 @@ void testAMG(int N, int coarsenTarget, int ml)
   
   smootherArgs.relaxationFactor = 1;
   
-  Criterion criterion(15,coarsenTarget);
-  criterion.setDefaultValuesIsotropic(2); 
-  criterion.setAlpha(.67);
-  criterion.setBeta(1.0e-4);
-  criterion.setMaxLevel(ml);
-  criterion.setSkipIsolated(false);
+  Criterion criterion(parms);
   
   Dune::SeqScalarProduct<Vector> sp;
   typedef Dune::Amg::AMG<Operator,Vector,Smoother> AMG;
@@ -141,6 +269,7 @@ void testAMG(int N, int coarsenTarget, int ml)
     watch.reset();
   Dune::InverseOperatorResult r;
   amgCG.apply(x,b,r);
+  int ret = r.converged ? 0 : 1;
   
   XREAL solvetime = watch.elapsed();
   
@@ -148,15 +277,516 @@ void testAMG(int N, int coarsenTarget, int ml)
   
     std::cout<<"AMG building took "<<(buildtime/r.elapsed*r.iterations)<<" iterations"<<std::endl;
   std::cout<<"AMG building together with solving took "<<buildtime+solvetime<<std::endl;
-  
+  amg.statistics().print(std::cout);
+
+  // change the entries but not the pattern and reuse the aggregates
+  mat*=2.0;
+  watch.reset();
+  amg.recalculateHierarchy();
+  std::cout<<"Recalculating hierarchy took "<<watch.elapsed()<<" seconds"<<std::endl;
+  {
+    // the hierarchy of the AMG is only accessible through its stored form
+    typedef Dune::Amg::MatrixHierarchy<Operator,Dune::Amg::SequentialInformation> MatrixHierarchy;
+    std::stringstream stored;
+    amg.saveHierarchy(stored);
+    MatrixHierarchy recalculated(fop);
+    recalculated.load(stored);
+    ret+=checkGalerkinProducts(recalculated);
+  }
+  x=0;
+  randomize(mat, b);
+  amgCG.apply(x,b,r);
+  if(!r.converged)
+    ++ret;
+
   /*
   watch.reset();
   cg.apply(x,b,r);
 
   std::cout<<"CG solving took "<<watch.elapsed()<<" seconds"<<std::endl;
   */											  
+  if(ret)
+    std::cerr<<"AMG did not converge"<<std::endl;
+  return ret;
+}
+
+/**
+ * @brief The largest distance of a matrix entry from the diagonal.
+ */
+template<class M>
+std::size_t bandwidth(const M& mat)
+{
+  std::size_t width=0;
+  for(typename M::ConstRowIterator row=mat.begin(); row!=mat.end(); ++row)
+    for(typename M::ConstColIterator col=row->begin(); col!=row->end(); ++col)
+      width=std::max(width, static_cast<std::size_t>(std::max(row.index(), col.index())
+                                                     -std::min(row.index(), col.index())));
+  return width;
+}
+
+/**
+ * @brief Checks that renumbering the coarse levels does not increase
+ * the bandwidth of the coarse matrices.
+ *
+ * The hierarchy is built with parms with and without renumbering.
+ * @return The number of coarse levels whose bandwidth increased.
+ */
+int testRenumberBandwidth(int N, const Dune::Amg::Parameters& parms)
+{
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  typedef Dune::MatrixAdapter<BCRSMat,Vector,Vector> Operator;
+  typedef Dune::Amg::CoarsenCriterion<Dune::Amg::UnSymmetricCriterion<BCRSMat,Dune::Amg::FirstDiagonal> >
+    Criterion;
+  typedef Dune::Amg::SequentialInformation PI;
+  typedef Dune::Amg::MatrixHierarchy<Operator,PI> MatrixHierarchy;
+  typedef MatrixHierarchy::ParallelMatrixHierarchy::ConstIterator Iterator;
+
+  BCRSMat mat=AnisotropicProblem<BCRSMat,Vector>::setupMatrix(N);
+  Operator fop(mat);
+  std::vector<std::size_t> widths[2];
+  for(int renumber=0; renumber<2; ++renumber){
+    Dune::Amg::Parameters levelParms(parms);
+    levelParms.setRenumberCoarseLevels(renumber);
+    Criterion criterion(levelParms);
+    MatrixHierarchy hierarchy(fop);
+    hierarchy.build<Dune::NegateSet<PI::OwnerSet> >(criterion);
+    for(Iterator level=hierarchy.matrices().finest(); level!=hierarchy.matrices().coarsest();){
+      ++level;
+      widths[renumber].push_back(bandwidth(level->getmat()));
+    }
+  }
+
+  if(widths[0].size()!=widths[1].size()){
+    std::cerr<<"Renumbering changed the number of levels"<<std::endl;
+    return 1;
+  }
+  int ret=0;
+  for(std::size_t l=0; l<widths[0].size(); ++l){
+    std::cout<<"Coarse level "<<l+1<<" has bandwidth "<<widths[1][l]<<" with renumbering and "
+             <<widths[0][l]<<" without"<<std::endl;
+    if(widths[1][l]>widths[0][l]){
+      std::cerr<<"Renumbering increased the bandwidth on coarse level "<<l+1<<std::endl;
+      ++ret;
+    }
+  }
+  return ret;
 }
 
+template <int BS>
+int testMixedPrecisionAMG(int N, int coarsenTarget, int ml)
+{
+  std::cout<<"Mixed precision N="<<N<<" coarsenTarget="<<coarsenTarget<<" maxlevel="<<ml<<std::endl;
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,BS,BS> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,BS> > Vector;
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<float,BS,BS> > CoarseMat;
+  typedef Dune::BlockVector<Dune::FieldVector<float,BS> > CoarseVector;
+  typedef Dune::Amg::CoarsenCriterion<Dune::Amg::UnSymmetricCriterion<BCRSMat,Dune::Amg::FirstDiagonal> >
+    Criterion;
+  typedef AnisotropicProblem<BCRSMat,Vector,Criterion> Problem;
+  typedef Dune::Amg::CoarsenCriterion<Dune::Amg::UnSymmetricCriterion<CoarseMat,Dune::Amg::FirstDiagonal> >
+    CoarseCriterion;
+  typedef Dune::SeqSSOR<BCRSMat,Vector,Vector> Smoother;
+  typedef Dune::SeqSSOR<CoarseMat,CoarseVector,CoarseVector> CoarseSmoother;
+  typedef Dune::Amg::MixedPrecisionAMG<typename Problem::Operator,Vector,Smoother,CoarseSmoother> AMG;
+
+  Dune::Timer watch;
+  Problem p(N, coarsenTarget, ml);
+
+  CoarseCriterion coarseCriterion(15,coarsenTarget);
+  coarseCriterion.setDefaultValuesIsotropic(2);
+  coarseCriterion.setMaxLevel(ml-1);
+
+  AMG amg(p.fop, p.criterion, smootherArguments<Smoother>(), coarseCriterion,
+          smootherArguments<CoarseSmoother>());
+  std::cout<<"Building mixed precision hierarchy took "<<watch.elapsed()<<" seconds"<<std::endl;
+
+  Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-6,80,2);
+  Dune::InverseOperatorResult r;
+  amgCG.apply(p.x,p.b,r);
+  amg.coarseAMG().statistics().print(std::cout);
+  if(!r.converged){
+    std::cerr<<"Mixed precision AMG did not converge"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+template <class Smoother>
+int testAMGSmoother(int N, int coarsenTarget, int ml)
+{
+  std::cout<<"Smoother test N="<<N<<" coarsenTarget="<<coarsenTarget<<" maxlevel="<<ml<<std::endl;
+
+  typedef typename Smoother::matrix_type BCRSMat;
+  typedef typename Smoother::domain_type Vector;
+  typedef Dune::Amg::CoarsenCriterion<Dune::Amg::UnSymmetricCriterion<BCRSMat,Dune::Amg::FirstDiagonal> >
+    Criterion;
+  typedef AnisotropicProblem<BCRSMat,Vector,Criterion> Problem;
+
+  Problem p(N, coarsenTarget, ml);
+  Dune::Amg::AMG<typename Problem::Operator,Vector,Smoother> amg(p.fop, p.criterion,
+                                                                 smootherArguments<Smoother>());
+  Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-6,80,2);
+  Dune::InverseOperatorResult r;
+  amgCG.apply(p.x,p.b,r);
+  if(!r.converged){
+    std::cerr<<"AMG with custom smoother did not converge"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Check that the hybrid Gauss-Seidel with a single block is a
+ * SOR sweep.
+ *
+ * With one block there are no couplings to other blocks, so the l1
+ * scaling leaves the diagonal unchanged.
+ */
+int testL1GaussSeidelSweep(int N)
+{
+  std::cout<<"L1 Gauss-Seidel sweep test N="<<N<<std::endl;
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+
+  const BCRSMat mat = AnisotropicProblem<BCRSMat,Vector>::setupMatrix(N);
+  Vector d(mat.N()), v(mat.M()), sorV(mat.M());
+  randomize(mat, d);
+  v=0;
+  sorV=0;
+
+  // the hybrid Gauss-Seidel uses one block per thread
+#ifdef _OPENMP
+  const int threads=omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  Dune::Amg::SequentialInformation pinfo;
+  Dune::Amg::L1GaussSeidel<BCRSMat,Vector,Vector> l1gs(mat, 1, 1.2, pinfo);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+  Dune::SeqSOR<BCRSMat,Vector,Vector> sor(mat, 1, 1.2);
+
+  l1gs.apply(v, d);
+  sor.apply(sorV, d);
+  sorV-=v;
+  if(sorV.infinity_norm()>1e-12*v.infinity_norm()){
+    std::cerr<<"L1 Gauss-Seidel with one block differs from SOR by "<<sorV.infinity_norm()<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Check the sizes of the aggregates built by the MIS aggregation.
+ *
+ * No aggregate may exceed the maximum size. Only a few aggregates whose
+ * neighbours are all too large to take them may stay below the minimum.
+ */
+int testMISAggregation(int N)
+{
+  std::cout<<"MIS aggregation test N="<<N<<std::endl;
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  typedef Dune::Amg::MatrixGraph<const BCRSMat> MatrixGraph;
+  typedef Dune::Amg::PropertiesGraph<MatrixGraph,Dune::Amg::VertexProperties,
+    Dune::Amg::EdgeProperties> PropertiesGraph;
+  typedef PropertiesGraph::VertexDescriptor Vertex;
+  typedef Dune::Amg::SymmetricCriterion<BCRSMat,Dune::Amg::FirstDiagonal> Criterion;
+
+  const BCRSMat mat = AnisotropicProblem<BCRSMat,Vector>::setupMatrix(N);
+
+  MatrixGraph mg(mat);
+  PropertiesGraph pg(mg);
+  Criterion criterion;
+  criterion.setDefaultValuesIsotropic(2);
+  criterion.setAggregationAlgorithm(Dune::Amg::misAggregation);
+  Dune::Amg::AggregatesMap<Vertex> aggregates(pg.maxVertex()+1);
+  aggregates.buildAggregates(mat, pg, criterion, true);
+
+  std::map<Vertex,std::size_t> sizes;
+  for(std::size_t i=0; i<mat.N(); ++i)
+    ++sizes[aggregates[i]];
+  std::size_t small=0;
+  int ret=0;
+  for(std::map<Vertex,std::size_t>::const_iterator a=sizes.begin(); a!=sizes.end(); ++a){
+    if(a->second>criterion.maxAggregateSize()){
+      std::cerr<<"Aggregate "<<a->first<<" has "<<a->second<<" vertices"<<std::endl;
+      ret=1;
+    }
+    if(a->second<criterion.minAggregateSize())
+      ++small;
+  }
+  std::cout<<sizes.size()<<" aggregates, "<<small<<" below the minimum size"<<std::endl;
+  if(10*small>sizes.size()){
+    std::cerr<<"Too many aggregates below the minimum size"<<std::endl;
+    ret=1;
+  }
+  return ret;
+}
+
+/**
+ * @brief Solve with overlapping Schwarz smoothers for the overlap modes
+ * supported on all levels.
+ *
+ * Aggregate overlap is left out, as it is not implemented for the
+ * coarsest level, which has no aggregates.
+ *
+ * Checks that the subdomains built from the aggregates are one per
+ * aggregate and isolated vertex and none of them is empty.
+ */
+int testSchwarzSmoother(int N, int coarsenTarget, int ml)
+{
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  typedef AnisotropicProblem<BCRSMat,Vector> Problem;
+  typedef Problem::Operator Operator;
+  typedef Dune::SeqOverlappingSchwarz<BCRSMat,Vector,Dune::SymmetricMultiplicativeSchwarzMode,
+    Dune::ILU0SubdomainSolver<BCRSMat,Vector,Vector> > Smoother;
+  typedef Dune::Amg::SmootherTraits<Smoother>::Arguments SmootherArgs;
+  typedef Dune::Amg::SequentialInformation PI;
+  typedef Dune::Amg::MatrixHierarchy<Operator,PI> MatrixHierarchy;
+  typedef MatrixHierarchy::AggregatesMap AggregatesMap;
+
+  Problem p(N, coarsenTarget, ml);
+
+  // the aggregates of the finest level as numbered by the hierarchy
+  PI pinfo;
+  MatrixHierarchy hierarchy(p.fop, pinfo);
+  hierarchy.build<Dune::NegateSet<PI::OwnerSet> >(p.criterion);
+  const AggregatesMap& aggregates = **hierarchy.aggregatesMaps().begin();
+  std::set<AggregatesMap::AggregateDescriptor> aggregateIds;
+  std::size_t isolated=0;
+  for(std::size_t i=0; i<p.mat.N(); ++i)
+    if(aggregates[i]==AggregatesMap::ISOLATED)
+      ++isolated;
+    else
+      aggregateIds.insert(aggregates[i]);
+
+  const SmootherArgs::Overlap overlaps[3] = {SmootherArgs::vertex, SmootherArgs::pairwise,
+                                             SmootherArgs::none};
+  const char* names[3] = {"vertex", "pairwise", "none"};
+  int ret=0;
+  for(int o=0; o<3; ++o){
+    std::cout<<"Overlapping Schwarz smoother test N="<<N<<" overlap="<<names[o]<<std::endl;
+    SmootherArgs smootherArgs = smootherArguments<Smoother>();
+    smootherArgs.overlap = overlaps[o];
+    smootherArgs.onthefly = false;
+
+    Dune::Amg::ConstructionArgs<Smoother> cargs;
+    cargs.setArgs(smootherArgs);
+    if(overlaps[o]==SmootherArgs::pairwise)
+      cargs.setMatrix(p.mat);
+    else{
+      cargs.setMatrix(p.mat, aggregates);
+      if(cargs.getSubDomains().size()!=aggregateIds.size()+isolated){
+        std::cerr<<names[o]<<" overlap: "<<cargs.getSubDomains().size()<<" subdomains for "
+                 <<aggregateIds.size()<<" aggregates and "<<isolated<<" isolated vertices"<<std::endl;
+        ++ret;
+      }
+    }
+    for(std::size_t d=0; d<cargs.getSubDomains().size(); ++d)
+      if(cargs.getSubDomains()[d].empty()){
+        std::cerr<<names[o]<<" overlap: subdomain "<<d<<" is empty"<<std::endl;
+        ++ret;
+        break;
+      }
+
+    Dune::Amg::AMG<Operator,Vector,Smoother> amg(p.fop, p.criterion, smootherArgs);
+    Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-8,80,1);
+    Dune::InverseOperatorResult r;
+    Vector b(p.b);
+    p.x=0;
+    amgCG.apply(p.x,b,r);
+    if(!r.converged){
+      std::cerr<<"AMG with "<<names[o]<<" overlap did not converge"<<std::endl;
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+/**
+ * @brief Compare V-, W- and F-cycles with per level smoothing parameters.
+ *
+ * The F-cycle has to converge at least as fast as the V-cycle and
+ * must not depend on gamma.
+ */
+int testAMGCycles(int N, int coarsenTarget, int ml)
+{
+  std::cout<<"Cycle test N="<<N<<" coarsenTarget="<<coarsenTarget<<" maxlevel="<<ml<<std::endl;
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  typedef AnisotropicProblem<BCRSMat,Vector> Problem;
+  typedef Problem::Operator Operator;
+  typedef Dune::SeqSSOR<BCRSMat,Vector,Vector> Smoother;
+
+  Problem p(N, coarsenTarget, ml);
+  const Dune::Amg::SmootherTraits<Smoother>::Arguments smootherArgs = smootherArguments<Smoother>();
+  Problem::Criterion& criterion = p.criterion;
+  criterion.setNoPreSmoothSteps(1);
+  criterion.setNoPostSmoothSteps(1);
+  // smooth more on the cheap coarse levels
+  for(int level=1; level<ml; ++level){
+    criterion.setNoPreSmoothSteps(level, 2);
+    criterion.setNoPostSmoothSteps(level, 2);
+  }
+  criterion.setRelaxationFactor(0, 1.1);
+
+  int iterations[3];
+  const char* names[3] = {"V", "W", "F"};
+  for(int cycle=0; cycle<3; ++cycle){
+    criterion.setGamma(cycle==1 ? 2 : 1);
+    criterion.setFCycle(cycle==2);
+    Dune::Amg::AMG<Operator,Vector,Smoother> amg(p.fop, criterion, smootherArgs);
+    Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-8,80,1);
+    Dune::InverseOperatorResult r;
+    Vector b(p.b);
+    p.x=0;
+    amgCG.apply(p.x,b,r);
+    if(!r.converged){
+      std::cerr<<names[cycle]<<"-cycle did not converge"<<std::endl;
+      return 1;
+    }
+    iterations[cycle]=r.iterations;
+  }
+  if(iterations[2]>iterations[0]){
+    std::cerr<<"F-cycle needed more iterations than the V-cycle"<<std::endl;
+    return 1;
+  }
+
+  // gamma only matters below the second level, so coarsen further
+  criterion.setCoarsenTarget(20);
+  criterion.setFCycle(true);
+  double reductions[2];
+  for(int gamma=1; gamma<=2; ++gamma){
+    criterion.setGamma(gamma);
+    Dune::Amg::AMG<Operator,Vector,Smoother> amg(p.fop, criterion, smootherArgs);
+    Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-8,80,1);
+    Dune::InverseOperatorResult r;
+    Vector b(p.b);
+    p.x=0;
+    amgCG.apply(p.x,b,r);
+    reductions[gamma-1]=r.reduction;
+  }
+  if(reductions[0]!=reductions[1]){
+    std::cerr<<"F-cycle depends on gamma"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Solve with the additive AMG, whose level corrections are
+ * computed concurrently with OpenMP.
+ */
+int testAdditiveAMG(int N, int coarsenTarget, int ml)
+{
+  std::cout<<"Additive AMG test N="<<N<<" coarsenTarget="<<coarsenTarget<<" maxlevel="<<ml<<std::endl;
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  typedef AnisotropicProblem<BCRSMat,Vector> Problem;
+  typedef Dune::SeqSSOR<BCRSMat,Vector,Vector> Smoother;
+
+  Problem p(N, coarsenTarget, ml);
+  p.criterion.setAdditive(true);
+
+  Dune::Amg::AMG<Problem::Operator,Vector,Smoother> amg(p.fop, p.criterion,
+                                                        smootherArguments<Smoother>());
+#ifdef _OPENMP
+  {
+    // the concurrent corrections have to match those of a single thread
+    Vector x(p.x), b(p.b), v(p.x.size()), sequentialV(p.x.size());
+    const int threads=omp_get_max_threads();
+    amg.pre(x, b);
+    omp_set_num_threads(std::max(threads, 2));
+    amg.apply(v, b);
+    omp_set_num_threads(1);
+    amg.apply(sequentialV, b);
+    omp_set_num_threads(threads);
+    amg.post(x);
+    sequentialV-=v;
+    if(sequentialV.infinity_norm()!=0){
+      std::cerr<<"Concurrent additive correction differs by "<<sequentialV.infinity_norm()<<std::endl;
+      return 1;
+    }
+  }
+#endif
+  Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-8,200,1);
+  Dune::InverseOperatorResult r;
+  amgCG.apply(p.x,p.b,r);
+  amg.statistics().print(std::cout);
+  if(!r.converged){
+    std::cerr<<"Additive AMG did not converge"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief Solve a sequence of systems with increasing anisotropy.
+ *
+ * The aggregates built for the isotropic problem only fit the first
+ * systems. The policy has to rebuild the hierarchy at least once.
+ */
+int testHierarchyReuse(int N, int coarsenTarget, int ml)
+{
+  std::cout<<"Hierarchy reuse test N="<<N<<" coarsenTarget="<<coarsenTarget<<" maxlevel="<<ml<<std::endl;
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  typedef AnisotropicProblem<BCRSMat,Vector> Problem;
+  typedef Dune::SeqSSOR<BCRSMat,Vector,Vector> Smoother;
+
+  Problem p(N, coarsenTarget, ml);
+  BCRSMat& mat = p.mat;
+  Vector& b = p.b;
+  Vector& x = p.x;
+  const BCRSMat isotropic(mat);
+
+  Dune::Amg::AMG<Problem::Operator,Vector,Smoother> amg(p.fop, p.criterion, smootherArguments<Smoother>());
+  Dune::Amg::AdaptiveHierarchyReuse<Problem::Criterion> policy(p.criterion, 1.5);
+  Dune::CGSolver<Vector> amgCG(p.fop,amg,1e-8,200,1);
+
+  double eps=1;
+  for(int step=0; step<6; ++step, eps*=0.3){
+    if(step>0){
+      // weaken the couplings in one direction
+      for(std::size_t i=0; i<mat.N(); ++i){
+        double diagonal=isotropic[i][i][0][0];
+        for(BCRSMat::ColIterator col=mat[i].begin(); col!=mat[i].end(); ++col)
+          if(col.index()+N==i || i+N==col.index()){
+            *col=isotropic[i][col.index()];
+            *col*=eps;
+            diagonal-=(1-eps)*std::abs(isotropic[i][col.index()][0][0]);
+          }
+        mat[i][i]=diagonal;
+      }
+      policy.update(amg);
+    }
+    x=0;
+    randomize(mat, b);
+    Dune::InverseOperatorResult r;
+    amgCG.apply(x,b,r);
+    if(!r.converged){
+      std::cerr<<"AMG did not converge for anisotropy "<<eps<<std::endl;
+      return 1;
+    }
+    policy.record(r);
+  }
+  std::cout<<"Refreshed "<<policy.refreshes()<<" and rebuilt "<<policy.rebuilds()
+           <<" times"<<std::endl;
+  if(policy.rebuilds()==0){
+    std::cerr<<"The hierarchy was never rebuilt for the anisotropic problems"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
 
 int main(int argc, char** argv)
 {
@@ -174,7 +804,57 @@ int main(int argc, char** argv)
   if(argc>3)
     ml = atoi(argv[3]);
   
-  testAMG<1>(N, coarsenTarget, ml);
-  testAMG<2>(N, coarsenTarget, ml);
+  Dune::Amg::Parameters parms(ml, coarsenTarget);
+  parms.setDefaultValuesIsotropic(2);
+  parms.setAlpha(.67);
+  parms.setBeta(1.0e-4);
+  parms.setSkipIsolated(false);
+
+  int ret=0;
+  ret+=testAMG<1>(N, parms);
+  ret+=testAMG<2>(N, parms);
+  {
+    Dune::Amg::Parameters mis(parms);
+    mis.setAggregationAlgorithm(Dune::Amg::misAggregation);
+    ret+=testAMG<1>(N, mis);
+  }
+  {
+    Dune::Amg::Parameters pairwise(parms);
+    pairwise.setAggregationAlgorithm(Dune::Amg::pairwiseAggregation);
+    ret+=testAMG<1>(N, pairwise);
+  }
+  for(int variant=1; variant<4; ++variant){
+    // smoothed aggregation and/or explicit transfer operators
+    Dune::Amg::Parameters transfer(parms);
+    transfer.setSmoothedAggregation(variant&1);
+    transfer.setExplicitTransferOperators(variant&2);
+    ret+=testAMG<1>(N, transfer);
+  }
+  {
+    Dune::Amg::Parameters lean(parms);
+    lean.setLeanSetup(true);
+    ret+=testAMG<1>(N, lean);
+  }
+  {
+    Dune::Amg::Parameters renumber(parms);
+    renumber.setRenumberCoarseLevels(true);
+    ret+=testAMG<1>(N, renumber);
+    ret+=testRenumberBandwidth(N, parms);
+  }
+  ret+=testMISAggregation(N);
+  ret+=testMixedPrecisionAMG<1>(N, coarsenTarget, ml);
+  ret+=testMixedPrecisionAMG<2>(N, coarsenTarget, ml);
+
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,1,1> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,1> > Vector;
+  ret+=testAMGSmoother<Dune::Amg::L1Jacobi<BCRSMat,Vector,Vector> >(N, coarsenTarget, ml);
+  ret+=testAMGSmoother<Dune::Amg::L1GaussSeidel<BCRSMat,Vector,Vector> >(N, coarsenTarget, ml);
+  ret+=testL1GaussSeidelSweep(N);
+
+  ret+=testSchwarzSmoother(N, coarsenTarget, ml);
+  ret+=testAMGCycles(N, coarsenTarget, ml);
+  ret+=testAdditiveAMG(N, coarsenTarget, ml);
+  ret+=testHierarchyReuse(N, coarsenTarget, ml);
+  return ret;
 
 }
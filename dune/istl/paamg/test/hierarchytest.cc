@@ -8,6 +8,8 @@
 #include<dune/istl/schwarz.hh>
 #include<dune/common/mpicollectivecommunication.hh>
 #include"anisotropic.hh"
+#include<cstring>
+#include<sstream>
 
 int main(int argc, char** argv)
 {
@@ -75,7 +77,56 @@ int main(int argc, char** argv)
   std::vector<std::size_t> data;
   
   hierarchy.getCoarsestAggregatesOnFinest(data);
+
+  // Save a hierarchy without redistribution and load it again
+  criterion.setAccumulate(Dune::Amg::noAccu);
+  Hierarchy saved(op, pinfo);
+  saved.build<OverlapFlags>(criterion);
+  std::stringstream stream;
+  saved.save(stream);
+
+  timer.reset();
+  Hierarchy loaded(op, pinfo);
+  loaded.load(stream);
+  std::cout<<"Loading hierarchy took "<<timer.elapsed()<<std::endl;
+
+  int ret=0;
+  if(loaded.levels()!=saved.levels()){
+    std::cerr<<rank<<": loaded hierarchy has "<<loaded.levels()<<" levels instead of "
+             <<saved.levels()<<std::endl;
+    ret=1;
+  }else{
+    typedef Hierarchy::ParallelMatrixHierarchy::ConstIterator Iterator;
+    for(Iterator s=saved.matrices().finest(), l=loaded.matrices().finest(); 
+        s!=saved.matrices().coarsest(); ){
+      ++s; ++l;
+      BCRSMat diff(s->getmat());
+      diff-=l->getmat();
+      if(diff.frobenius_norm()>1e-12){
+        std::cerr<<rank<<": loaded coarse matrix differs!"<<std::endl;
+        ret=1;
+      }
+    }
+  }
+
+  // A matrix whose row sizes do not add up to the nonzeroes is rejected
+  {
+    std::stringstream matrixStream;
+    Dune::Amg::writeMatrix(matrixStream, mat);
+    std::string data=matrixStream.str();
+    BCRSMat::size_type nnz;
+    std::memcpy(&nnz, data.data()+2*sizeof(nnz), sizeof(nnz));
+    ++nnz;
+    data.replace(2*sizeof(nnz), sizeof(nnz), reinterpret_cast<const char*>(&nnz), sizeof(nnz));
+    std::istringstream corrupted(data);
+    try{
+      BCRSMat read;
+      Dune::Amg::readMatrix(corrupted, read);
+      std::cerr<<rank<<": inconsistent matrix was read!"<<std::endl;
+      ret=1;
+    }catch(const Dune::ISTLError&){}
+  }
   
   MPI_Finalize();
-  
+  return ret;
 }
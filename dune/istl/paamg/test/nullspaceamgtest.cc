@@ -0,0 +1,203 @@
+#include"config.h"
+
+#include<dune/common/fmatrix.hh>
+#include<dune/common/fvector.hh>
+#include<dune/common/timer.hh>
+#include<dune/istl/bcrsmatrix.hh>
+#include<dune/istl/bvector.hh>
+#include<dune/istl/paamg/amg.hh>
+#include<dune/istl/paamg/nullspace.hh>
+#include<dune/istl/solvers.hh>
+#include<algorithm>
+#include<cmath>
+#include<cstdlib>
+#include<iostream>
+#include<set>
+#include<vector>
+
+/**
+ * @brief Set up linear elasticity with linear elements on the unit cube.
+ *
+ * Each of the N^dim cubes is split into dim! simplices. The unknowns
+ * at x=0 are clamped.
+ */
+template<int dim>
+void setupElasticity(int N, Dune::BCRSMatrix<Dune::FieldMatrix<double,dim,dim> >& mat,
+                     std::vector<Dune::FieldVector<double,dim> >& coordinates)
+{
+  typedef Dune::FieldMatrix<double,dim,dim> Block;
+  typedef Dune::BCRSMatrix<Block> Matrix;
+
+  int nodes=1, cubes=1;
+  for(int d=0; d<dim; ++d){
+    nodes*=N+1;
+    cubes*=N;
+  }
+  coordinates.resize(nodes);
+  for(int k=0; k<nodes; ++k)
+    for(int d=0, r=k; d<dim; ++d, r/=N+1)
+      coordinates[k][d]=static_cast<double>(r%(N+1))/N;
+
+  std::vector<std::vector<int> > simplices;
+  for(int c=0; c<cubes; ++c){
+    int perm[dim], corner[dim];
+    for(int d=0, r=c; d<dim; ++d, r/=N){
+      corner[d]=r%N;
+      perm[d]=d;
+    }
+    // walk along the axes in all orders
+    do{
+      std::vector<int> simplex;
+      int x[dim];
+      std::copy(corner, corner+dim, x);
+      for(int v=0; v<=dim; ++v){
+        if(v>0)
+          ++x[perm[v-1]];
+        int index=0;
+        for(int d=dim-1; d>=0; --d)
+          index=index*(N+1)+x[d];
+        simplex.push_back(index);
+      }
+      simplices.push_back(simplex);
+    }while(std::next_permutation(perm, perm+dim));
+  }
+
+  std::vector<std::set<int> > pattern(nodes);
+  for(std::size_t e=0; e<simplices.size(); ++e)
+    for(int a=0; a<=dim; ++a)
+      for(int b=0; b<=dim; ++b)
+        pattern[simplices[e][a]].insert(simplices[e][b]);
+  int nnz=0;
+  for(int k=0; k<nodes; ++k)
+    nnz+=pattern[k].size();
+
+  mat.setSize(nodes, nodes, nnz);
+  mat.setBuildMode(Matrix::row_wise);
+  int k=0;
+  for(typename Matrix::CreateIterator ci=mat.createbegin(); ci!=mat.createend(); ++ci, ++k)
+    for(std::set<int>::const_iterator j=pattern[k].begin(); j!=pattern[k].end(); ++j)
+      ci.insert(*j);
+  mat=0;
+
+  const double lambda=1, mu=1;
+  for(std::size_t e=0; e<simplices.size(); ++e){
+    const std::vector<int>& s=simplices[e];
+    Block jacobian;
+    for(int i=0; i<dim; ++i)
+      for(int d=0; d<dim; ++d)
+        jacobian[i][d]=coordinates[s[i+1]][d]-coordinates[s[0]][d];
+    double volume=std::abs(jacobian.determinant());
+    for(int i=2; i<=dim; ++i)
+      volume/=i;
+    jacobian.invert();
+
+    // the gradients of the basis functions
+    std::vector<Dune::FieldVector<double,dim> > gradients(dim+1, Dune::FieldVector<double,dim>(0.0));
+    for(int i=0; i<dim; ++i)
+      for(int d=0; d<dim; ++d){
+        gradients[i+1][d]=jacobian[d][i];
+        gradients[0][d]-=jacobian[d][i];
+      }
+
+    for(int a=0; a<=dim; ++a)
+      for(int b=0; b<=dim; ++b){
+        Block local;
+        for(int i=0; i<dim; ++i)
+          for(int j=0; j<dim; ++j)
+            local[i][j]=volume*(lambda*gradients[a][i]*gradients[b][j]
+                                +mu*gradients[a][j]*gradients[b][i]
+                                +(i==j ? mu*(gradients[a]*gradients[b]) : 0));
+        mat[s[a]][s[b]]+=local;
+      }
+  }
+
+  for(k=0; k<nodes; ++k)
+    if(coordinates[k][0]==0){
+      typedef typename Matrix::ColIterator ColIterator;
+      for(ColIterator col=mat[k].begin(); col!=mat[k].end(); ++col){
+        *col=0;
+        mat[col.index()][k]=0;
+      }
+      for(int i=0; i<dim; ++i)
+        mat[k][k][i][i]=1;
+    }
+}
+
+template<int dim>
+int testNullspaceAMG(int N, int maxIterations)
+{
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,dim,dim> > BCRSMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,dim> > Vector;
+  typedef Dune::MatrixAdapter<BCRSMat,Vector,Vector> Operator;
+  typedef Dune::Amg::RigidBodyModes<dim> Modes;
+  typedef Dune::BCRSMatrix<Dune::FieldMatrix<double,Modes::size,Modes::size> > CoarseMat;
+  typedef Dune::BlockVector<Dune::FieldVector<double,Modes::size> > CoarseVector;
+  typedef Dune::SeqSSOR<BCRSMat,Vector,Vector> Smoother;
+  typedef Dune::SeqSSOR<CoarseMat,CoarseVector,CoarseVector> CoarseSmoother;
+  typedef Dune::Amg::NullspaceAMG<Operator,Vector,Smoother,CoarseSmoother> AMG;
+  typedef Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<BCRSMat,Dune::Amg::FrobeniusNorm> >
+    Criterion;
+  typedef Dune::Amg::CoarsenCriterion<Dune::Amg::SymmetricCriterion<CoarseMat,Dune::Amg::FrobeniusNorm> >
+    CoarseCriterion;
+
+  std::cout<<"Elasticity dim="<<dim<<" N="<<N<<std::endl;
+
+  BCRSMat mat;
+  std::vector<Dune::FieldVector<double,dim> > coordinates;
+  setupElasticity<dim>(N, mat, coordinates);
+  std::vector<typename AMG::NullspaceBlock> modes;
+  Modes::compute(coordinates, modes);
+
+  Vector b(mat.N()), x(mat.M());
+  x=0;
+  b=1;
+  for(std::size_t i=0; i<mat.N(); ++i)
+    if(coordinates[i][0]==0)
+      b[i]=0;
+
+  typename Dune::Amg::SmootherTraits<Smoother>::Arguments smootherArgs;
+  smootherArgs.iterations = 1;
+  smootherArgs.relaxationFactor = 1;
+  typename Dune::Amg::SmootherTraits<CoarseSmoother>::Arguments coarseSmootherArgs;
+  coarseSmootherArgs.iterations = 1;
+  coarseSmootherArgs.relaxationFactor = 1;
+
+  Criterion criterion(15,50);
+  criterion.setDefaultValuesIsotropic(dim);
+  criterion.setSmoothedAggregation(true);
+  CoarseCriterion coarseCriterion(15,50);
+  coarseCriterion.setDefaultValuesIsotropic(dim);
+
+  Dune::Timer watch;
+  Operator fop(mat);
+  AMG amg(fop, modes, criterion, smootherArgs, coarseCriterion, coarseSmootherArgs);
+  std::cout<<"Building hierarchy with "<<amg.levels()<<" levels took "<<watch.elapsed()
+           <<" seconds"<<std::endl;
+
+  Dune::CGSolver<Vector> amgCG(fop,amg,1e-8,maxIterations,2);
+  Dune::InverseOperatorResult r;
+  amgCG.apply(x,b,r);
+
+  if(!r.converged){
+    std::cerr<<"AMG with rigid body modes did not converge in "<<maxIterations
+             <<" iterations!"<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  int N=32;
+
+  if(argc>1)
+    N = atoi(argv[1]);
+
+  // The number of iterations has to be independent of the mesh size
+  int ret=0;
+  ret+=testNullspaceAMG<2>(N, 12);
+  ret+=testNullspaceAMG<2>(2*N, 12);
+  ret+=testNullspaceAMG<3>(N/4, 12);
+  ret+=testNullspaceAMG<3>(N/2, 12);
+  return ret;
+}
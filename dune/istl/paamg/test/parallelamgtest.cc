@@ -5,6 +5,7 @@
 #include"anisotropic.hh"
 #include<dune/common/timer.hh>
 #include<dune/istl/paamg/amg.hh>
+#include<dune/istl/paamg/kamg.hh>
 #include<dune/istl/paamg/pinfo.hh>
 #include<dune/common/parallel/indexset.hh>
 #include<dune/istl/schwarz.hh>
@@ -68,8 +69,10 @@ void MPI_err_handler(MPI_Comm *comm, int *err_code, ...){
 }
 
 template<int BS>
-void testAmg(int N, int coarsenTarget)
+int testAmg(int N, int coarsenTarget)
 {  
+  int ret=0;
+
   std::cout<<"==================================================="<<std::endl;
   std::cout<<"BS="<<BS<<" N="<<N<<" coarsenTarget="<<coarsenTarget<<std::endl;
   
@@ -182,17 +185,57 @@ void testAmg(int N, int coarsenTarget)
     std::cout<<"AMG building took "<<(buildtime/r.elapsed*r.iterations)<<" iterations"<<std::endl;
     std::cout<<"AMG building together with slving took "<<buildtime+solvetime<<std::endl;
   }
+
+  // solve the coarsest system redundantly on all processes
+  criterion.setAccumulate(Dune::Amg::noAccu);
+  criterion.setReplicatedCoarseSolve(true);
+  AMG ramg(fop, criterion, smootherArgs, comm);
+
+  b=0;
+  x=100;
   
+  setBoundary(x, b, N, comm.indexSet());
+  
+  Dune::CGSolver<Vector> ramgCG(fop, sp, ramg, 10e-8, 300, (rank==0)?2:0);
+  ramgCG.apply(x,b,r);
+
+  if(!r.converged){
+    if(rank==0)
+      std::cerr<<" AMG Cg solver with replicated coarse solve did not converge!"<<std::endl;
+    ++ret;
+  }
+
+  // Krylov cycle with the coarse levels agglomerated onto fewer processes
+  criterion.setAccumulate(Dune::Amg::successiveAccu);
+  criterion.setReplicatedCoarseSolve(false);
+  typedef Dune::Amg::KAMG<Operator,Vector,ParSmoother,Communication> KAMG;
+  KAMG kamg(fop, criterion, smootherArgs, 1, 1, 1, 3, 1e-1, comm);
+
+  b=0;
+  x=100;
+  
+  setBoundary(x, b, N, comm.indexSet());
+  
+  Dune::BiCGSTABSolver<Vector> kamgSolver(fop, sp, kamg, 10e-8, 300, (rank==0)?2:0);
+  kamgSolver.apply(x,b,r);
+
+  if(!r.converged){
+    if(rank==0)
+      std::cerr<<" KAMG BiCGSTAB solver did not converge!"<<std::endl;
+    ++ret;
+  }
+
+  return ret;
 }
 
 template<int BSStart, int BSEnd, int BSStep=1>
 struct AMGTester
 {
-  static void test(int N, int coarsenTarget)
+  static int test(int N, int coarsenTarget)
   {
-    testAmg<BSStart>(N, coarsenTarget);
+    int ret=testAmg<BSStart>(N, coarsenTarget);
     const int next = (BSStart+BSStep>BSEnd)?BSEnd:BSStart+BSStep;
-    AMGTester<next,BSEnd,BSStep>::test(N, coarsenTarget);
+    return ret+AMGTester<next,BSEnd,BSStep>::test(N, coarsenTarget);
   }
 }
 ;
@@ -200,9 +243,9 @@ struct AMGTester
 template<int BSStart,int BSStep>
 struct AMGTester<BSStart,BSStart,BSStep>
 {
-  static void test(int N, int coarsenTarget)
+  static int test(int N, int coarsenTarget)
   {
-    testAmg<BSStart>(N, coarsenTarget);
+    return testAmg<BSStart>(N, coarsenTarget);
   }
 };
 
@@ -227,9 +270,10 @@ int main(int argc, char** argv)
 #ifdef TEST_AGGLO
   N=UNKNOWNS;
 #endif
-  AMGTester<1,1>::test(N, coarsenTarget);
+  int ret=AMGTester<1,1>::test(N, coarsenTarget);
   //AMGTester<1,5>::test(N, coarsenTarget);
   //  AMGTester<10,10>::test(N, coarsenTarget);
   
   MPI_Finalize();
+  return ret;
 }
@@ -9,6 +9,8 @@
 #include<dune/istl/owneroverlapcopy.hh>
 #include<dune/istl/paamg/aggregates.hh>
 #include<dune/common/exceptions.hh>
+#include<cstddef>
+#include<vector>
 
 namespace Dune
 {
@@ -147,6 +149,207 @@ namespace Dune
       }
     }
 
+    /**
+     * @brief Prolongation and restriction stored as explicit sparse operators.
+     *
+     * Instead of looking up the aggregate of each fine unknown during every
+     * cycle, the prolongation P and the restriction R=P^T are stored in
+     * compressed row format, R sorted by coarse unknowns. Thus both
+     * restriction and prolongation are gathers over contiguous index arrays,
+     * which are done in parallel with OpenMP if enabled.
+     *
+     * For piecewise constant prolongations only the indices are stored, for
+     * smoothed aggregation the blocks of P are stored, too.
+     *
+     * @tparam B The type of the matrix blocks.
+     */
+    template<class B>
+    class SparseTransferOperator
+    {
+    public:
+      /** @brief The type of the blocks of the prolongation. */
+      typedef B block_type;
+      /** @brief The type of the indices. */
+      typedef std::size_t size_type;
+
+      /** @brief Constructor. */
+      SparseTransferOperator()
+        : coarseSize_(0)
+      {}
+
+      /**
+       * @brief Set up the piecewise constant operators of an aggregation.
+       * @param aggregates The consecutively numbered aggregates of the fine unknowns.
+       * @param coarseSize The number of coarse unknowns.
+       */
+      template<class V>
+      void setup(const AggregatesMap<V>& aggregates, size_type coarseSize);
+
+      /**
+       * @brief Set up the operators from a prolongation matrix.
+       * @param prolongation The prolongation matrix, e.g. of smoothed aggregation.
+       */
+      template<class M>
+      void setup(const M& prolongation);
+
+      /**
+       * @brief Restrict a fine vector: \f$ c = P^T f\f$.
+       */
+      template<class X>
+      void restrict(X& coarse, const X& fine) const;
+
+      /**
+       * @brief Prolongate a coarse vector and add it: \f$ f = f + d P c\f$.
+       */
+      template<class X, class T>
+      void prolongate(const X& coarse, X& fine, T damp) const;
+
+      /** @brief The number of fine unknowns. */
+      size_type fineSize() const
+      {
+        return prolongationStart_.size()-1;
+      }
+
+      /** @brief The number of coarse unknowns. */
+      size_type coarseSize() const
+      {
+        return coarseSize_;
+      }
+
+      /** @brief The number of bytes allocated for the operators. */
+      std::size_t memory() const
+      {
+        return (prolongationStart_.capacity()+prolongationIndex_.capacity()
+                +restrictionStart_.capacity()+restrictionIndex_.capacity())*sizeof(size_type)
+          +(prolongationWeights_.capacity()+restrictionWeights_.capacity())*sizeof(B);
+      }
+
+    private:
+      /** @brief Build the restriction as transpose of the prolongation. */
+      void transpose();
+
+      /** @brief The number of coarse unknowns. */
+      size_type coarseSize_;
+      /** @brief The start of the rows of P. */
+      std::vector<size_type> prolongationStart_;
+      /** @brief The coarse unknown of each entry of P. */
+      std::vector<size_type> prolongationIndex_;
+      /** @brief The blocks of P, empty if piecewise constant. */
+      std::vector<B> prolongationWeights_;
+      /** @brief The start of the rows of R. */
+      std::vector<size_type> restrictionStart_;
+      /** @brief The fine unknown of each entry of R. */
+      std::vector<size_type> restrictionIndex_;
+      /** @brief The (not transposed) blocks of P for each entry of R. */
+      std::vector<B> restrictionWeights_;
+    };
+
+    template<class B>
+    template<class V>
+    void SparseTransferOperator<B>::setup(const AggregatesMap<V>& aggregates, size_type coarseSize)
+    {
+      const size_type n=aggregates.noVertices();
+      coarseSize_=coarseSize;
+      prolongationStart_.resize(n+1);
+      prolongationIndex_.clear();
+      prolongationIndex_.reserve(n);
+      prolongationWeights_.clear();
+      prolongationStart_[0]=0;
+      for(size_type i=0; i<n; ++i){
+        if(aggregates[i]<AggregatesMap<V>::ISOLATED)
+          prolongationIndex_.push_back(aggregates[i]);
+        prolongationStart_[i+1]=prolongationIndex_.size();
+      }
+      transpose();
+    }
+
+    template<class B>
+    template<class M>
+    void SparseTransferOperator<B>::setup(const M& prolongation)
+    {
+      typedef typename M::ConstRowIterator RowIterator;
+      typedef typename M::ConstColIterator ColIterator;
+
+      coarseSize_=prolongation.M();
+      prolongationStart_.resize(prolongation.N()+1);
+      prolongationIndex_.resize(prolongation.nonzeroes());
+      prolongationWeights_.resize(prolongation.nonzeroes());
+      size_type entry=0;
+      prolongationStart_[0]=0;
+      for(RowIterator row=prolongation.begin(); row!=prolongation.end(); ++row){
+        for(ColIterator col=row->begin(); col!=row->end(); ++col, ++entry){
+          prolongationIndex_[entry]=col.index();
+          prolongationWeights_[entry]=*col;
+        }
+        prolongationStart_[row.index()+1]=entry;
+      }
+      transpose();
+    }
+
+    template<class B>
+    void SparseTransferOperator<B>::transpose()
+    {
+      const size_type n=fineSize();
+      restrictionStart_.assign(coarseSize_+1, 0);
+      for(size_type e=0; e<prolongationIndex_.size(); ++e)
+        ++restrictionStart_[prolongationIndex_[e]+1];
+      for(size_type k=0; k<coarseSize_; ++k)
+        restrictionStart_[k+1]+=restrictionStart_[k];
+
+      std::vector<size_type> position(restrictionStart_.begin(), restrictionStart_.end()-1);
+      restrictionIndex_.resize(prolongationIndex_.size());
+      restrictionWeights_.resize(prolongationWeights_.size());
+      for(size_type i=0; i<n; ++i)
+        for(size_type e=prolongationStart_[i]; e<prolongationStart_[i+1]; ++e){
+          size_type& p=position[prolongationIndex_[e]];
+          restrictionIndex_[p]=i;
+          if(!prolongationWeights_.empty())
+            restrictionWeights_[p]=prolongationWeights_[e];
+          ++p;
+        }
+    }
+
+    template<class B>
+    template<class X>
+    void SparseTransferOperator<B>::restrict(X& coarse, const X& fine) const
+    {
+      const std::ptrdiff_t n=coarseSize_;
+      const bool weighted=!restrictionWeights_.empty();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for(std::ptrdiff_t k=0; k<n; ++k){
+        typename X::block_type& c=coarse[k];
+        c=0;
+        if(weighted)
+          for(size_type e=restrictionStart_[k]; e<restrictionStart_[k+1]; ++e)
+            restrictionWeights_[e].umtv(fine[restrictionIndex_[e]], c);
+        else
+          for(size_type e=restrictionStart_[k]; e<restrictionStart_[k+1]; ++e)
+            c+=fine[restrictionIndex_[e]];
+      }
+    }
+
+    template<class B>
+    template<class X, class T>
+    void SparseTransferOperator<B>::prolongate(const X& coarse, X& fine, T damp) const
+    {
+      const std::ptrdiff_t n=fineSize();
+      const bool weighted=!prolongationWeights_.empty();
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for(std::ptrdiff_t i=0; i<n; ++i){
+        typename X::block_type& f=fine[i];
+        if(weighted)
+          for(size_type e=prolongationStart_[i]; e<prolongationStart_[i+1]; ++e)
+            prolongationWeights_[e].usmv(damp, coarse[prolongationIndex_[e]], f);
+        else
+          for(size_type e=prolongationStart_[i]; e<prolongationStart_[i+1]; ++e)
+            f.axpy(damp, coarse[prolongationIndex_[e]]);
+      }
+    }
+
 #if HAVE_MPI
     template<class V, class V1, class T1, class T2>
     template<typename T3>
@@ -0,0 +1,982 @@
+// -*- tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi: set ts=4 sw=2 et sts=2:
+
+#ifndef DUNE_RECYCLINGSOLVERS_HH
+#define DUNE_RECYCLINGSOLVERS_HH
+
+#include<algorithm>
+#include<cmath>
+#include<iostream>
+#include<limits>
+#include<vector>
+
+#include "istlexception.hh"
+#include "operators.hh"
+#include "preconditioners.hh"
+#include "scalarproducts.hh"
+#include "solvers.hh"
+#include <dune/common/timer.hh>
+#include <dune/common/ftraits.hh>
+#include <dune/common/static_assert.hh>
+
+/** \file
+
+    \brief Krylov solvers recycling a subspace between subsequent solves.
+
+    When a sequence of slowly varying systems is solved, the
+    eigenvectors belonging to the smallest eigenvalues change little
+    from one system to the next. The solvers in this file keep an
+    approximation of this invariant subspace across calls of apply()
+    and deflate it during the next solve.
+*/
+
+namespace Dune {
+
+  /** @addtogroup ISTL_Solvers
+      @{
+  */
+
+  /**
+   * @brief Small dense kernels used to update the recycled subspace.
+   *
+   * Matrices are stored row wise as vectors of vectors.
+   */
+  template<class T>
+  struct RecyclingDenseHelper
+  {
+    //! \brief The type of the dense matrices.
+    typedef std::vector<std::vector<T> > Matrix;
+
+    /**
+     * @brief Computes the Cholesky factorization \f$ B = L L^T\f$.
+     * @return false if B is not (numerically) positive definite.
+     */
+    static bool cholesky(const Matrix& b, Matrix& l)
+    {
+      const int n = b.size();
+      l.assign(n, std::vector<T>(n, T(0)));
+      for (int j=0; j<n; ++j) {
+        T d = b[j][j];
+        for (int k=0; k<j; ++k)
+          d -= l[j][k]*l[j][k];
+        if (!(d > 1e-14*std::abs(b[j][j])) || !(d > 0))
+          return false;
+        l[j][j] = std::sqrt(d);
+        for (int i=j+1; i<n; ++i) {
+          T s = b[i][j];
+          for (int k=0; k<j; ++k)
+            s -= l[i][k]*l[j][k];
+          l[i][j] = s/l[j][j];
+        }
+      }
+      return true;
+    }
+
+    /**
+     * @brief Computes all eigenpairs of a symmetric matrix with the
+     * cyclic Jacobi method.
+     *
+     * On return a is diagonal and the columns of v hold the eigenvectors.
+     */
+    static void jacobi(Matrix& a, Matrix& v)
+    {
+      const int n = a.size();
+      v.assign(n, std::vector<T>(n, T(0)));
+      for (int i=0; i<n; ++i)
+        v[i][i] = 1.0;
+
+      for (int sweep=0; sweep<100; ++sweep) {
+        T off = 0, diag = 0;
+        for (int i=0; i<n; ++i) {
+          diag += a[i][i]*a[i][i];
+          for (int j=i+1; j<n; ++j)
+            off += a[i][j]*a[i][j];
+        }
+        if (off <= 1e-30*diag || off == 0.0)
+          return;
+
+        for (int p=0; p<n; ++p)
+          for (int q=p+1; q<n; ++q) {
+            if (a[p][q] == 0.0)
+              continue;
+            T theta = (a[q][q]-a[p][p])/(2.0*a[p][q]);
+            T t = (theta >= 0 ? 1.0 : -1.0)/(std::abs(theta)+std::sqrt(theta*theta+1.0));
+            T c = 1.0/std::sqrt(t*t+1.0);
+            T s = t*c;
+            for (int k=0; k<n; ++k) {
+              T akp = a[k][p], akq = a[k][q];
+              a[k][p] = c*akp - s*akq;
+              a[k][q] = s*akp + c*akq;
+            }
+            for (int k=0; k<n; ++k) {
+              T apk = a[p][k], aqk = a[q][k];
+              a[p][k] = c*apk - s*aqk;
+              a[q][k] = s*apk + c*aqk;
+            }
+            for (int k=0; k<n; ++k) {
+              T vkp = v[k][p], vkq = v[k][q];
+              v[k][p] = c*vkp - s*vkq;
+              v[k][q] = s*vkp + c*vkq;
+            }
+          }
+      }
+    }
+
+    /**
+     * @brief Computes the eigenvectors belonging to the k smallest
+     * eigenvalues of the symmetric definite problem \f$ A y = \theta B y\f$.
+     *
+     * @param a The symmetric matrix A.
+     * @param b The symmetric positive definite matrix B.
+     * @param k The number of eigenvectors wanted.
+     * @param y The n x k matrix of eigenvectors, normalized to \f$ y^T B y = 1\f$.
+     * @return false if B is not positive definite.
+     */
+    static bool smallestEigenvectors(const Matrix& a, const Matrix& b, int k, Matrix& y)
+    {
+      const int n = a.size();
+      Matrix l, c(a), v;
+      if (!cholesky(b,l))
+        return false;
+
+      // c = L^{-1} A L^{-T}, computed column and row wise by forward substitution
+      for (int j=0; j<n; ++j)
+        for (int i=0; i<n; ++i) {
+          for (int m=0; m<i; ++m)
+            c[i][j] -= l[i][m]*c[m][j];
+          c[i][j] /= l[i][i];
+        }
+      for (int i=0; i<n; ++i)
+        for (int j=0; j<n; ++j) {
+          for (int m=0; m<j; ++m)
+            c[i][j] -= l[j][m]*c[i][m];
+          c[i][j] /= l[j][j];
+        }
+      for (int i=0; i<n; ++i)
+        for (int j=i+1; j<n; ++j)
+          c[i][j] = c[j][i] = 0.5*(c[i][j]+c[j][i]);
+
+      jacobi(c,v);
+
+      // select the smallest eigenvalues
+      std::vector<std::pair<T,int> > theta(n);
+      for (int i=0; i<n; ++i)
+        theta[i] = std::make_pair(c[i][i],i);
+      std::sort(theta.begin(), theta.end());
+
+      // y = L^{-T} v
+      y.assign(n, std::vector<T>(k, T(0)));
+      for (int j=0; j<k; ++j) {
+        int col = theta[j].second;
+        for (int i=n-1; i>=0; --i) {
+          T s = v[i][col];
+          for (int m=i+1; m<n; ++m)
+            s -= l[m][i]*y[m][j];
+          y[i][j] = s/l[i][i];
+        }
+      }
+      return true;
+    }
+  };
+
+  /*!
+    \brief Deflated conjugate gradient method recycling a subspace between solves.
+
+    Implements the preconditioned deflated CG method of Y. Saad, M. Yeung,
+    J. Erhel and F. Guyomarc'h, 'A deflated version of the conjugate
+    gradient algorithm', SIAM J. Sci. Comput. 21, 2000.
+    The search directions are kept A-orthogonal to a subspace W
+    spanned by approximate eigenvectors of \f$ M^{-1}A\f$ belonging to
+    the smallest eigenvalues. At the end of each call of apply() W is
+    replaced by the Ritz vectors of the space spanned by W and the first
+    search directions of the current solve. Thus W is refined over a
+    sequence of solves.
+
+    The operator may change between calls (as long as it stays
+    symmetric positive definite), as the products with W are recomputed
+    at the beginning of each solve. The preconditioner has to be
+    symmetric and linear.
+  */
+  template<class X>
+  class RecyclingCGSolver : public InverseOperator<X,X> {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted.
+    typedef typename X::field_type field_type;
+
+    /*!
+      \brief Set up recycling conjugate gradient solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+      \param k The dimension of the recycled subspace.
+      \param l The number of search directions of each solve used to
+      update the recycled subspace.
+    */
+    template<class L, class P>
+    RecyclingCGSolver (L& op, P& prec, double reduction, int k, int l, int maxit, int verbose) :
+      ssp(), _op(op), _prec(prec), _sp(ssp), _reduction(reduction), _k(k), _l(l),
+      _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
+        "L and P must have the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential),
+        "L must be sequential!");
+    }
+    /*!
+      \brief Set up recycling conjugate gradient solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,S&,P&,double,int,int)
+      \param k The dimension of the recycled subspace.
+      \param l The number of search directions of each solve used to
+      update the recycled subspace.
+    */
+    template<class L, class S, class P>
+    RecyclingCGSolver (L& op, S& sp, P& prec, double reduction, int k, int l, int maxit, int verbose) :
+      _op(op), _prec(prec), _sp(sp), _reduction(reduction), _k(k), _l(l),
+      _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
+        "L and P must have the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(S::category),
+        "L and S must have the same category!");
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      res.clear();                  // clear solver statistics
+      Timer watch;                // start a timer
+      _prec.pre(x,b);             // prepare preconditioner
+      _op.applyscaleadd(-1,x,b);  // overwrite b with defect
+
+      double def0 = _sp.norm(b);// compute norm
+      if (def0<1E-30)    // convergence check
+      {
+        _prec.post(x);
+        res.converged  = true;
+        res.iterations = 0;               // fill statistics
+        res.reduction = 0;
+        res.conv_rate  = 0;
+        res.elapsed=0;
+        if (_verbose>0)                 // final print
+          std::cout << "=== rate=" << res.conv_rate
+                    << ", T=" << res.elapsed << ", TIT=" << res.elapsed
+                    << ", IT=0" << std::endl;
+        return;
+      }
+
+      if (_verbose>0)             // printing
+      {
+        std::cout << "=== RecyclingCGSolver (recycled subspace "
+                  << _W.size() << ")" << std::endl;
+        if (_verbose>1) {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,def0);
+        }
+      }
+
+      X p(x);              // the search direction
+      X q(x);              // a temporary vector
+      X z(x);              // the preconditioned defect
+      X znew(x);           // the new preconditioned defect
+
+      // prepare deflation
+      setupDeflation(b);
+      std::vector<field_type> mu;
+      if (_W.size()>0) {
+        // project initial guess: x += W (W^T A W)^{-1} W^T r
+        project(b,mu);
+        for (size_t i=0; i<_W.size(); ++i) {
+          x.axpy(mu[i],_W[i]);
+          b.axpy(-mu[i],_AW[i]);
+        }
+      }
+
+      // the search directions and products kept to update W
+      _P.clear(); _AP.clear(); _MAP.clear();
+
+      // some local variables
+      double def=def0;   // loop variables
+      field_type rho,rholast,lambda,alpha,beta;
+
+      // determine initial search direction
+      z = 0;                          // clear correction
+      _prec.apply(z,b);               // apply preconditioner
+      rholast = _sp.dot(z,b);         // orthogonalization
+      p = z;
+      deflate(p,z,mu);
+
+      // the loop
+      int i=1;
+      for ( ; i<=_maxit; i++ )
+      {
+        // minimize in given search direction p
+        _op.apply(p,q);             // q=Ap
+        alpha = _sp.dot(p,q);       // scalar product
+        lambda = rholast/alpha;     // minimization
+        x.axpy(lambda,p);           // update solution
+        b.axpy(-lambda,q);          // update defect
+
+        // convergence test
+        double defnew=_sp.norm(b);// comp defect norm
+
+        if (_verbose>1)             // print
+          this->printOutput(std::cout,i,defnew,def);
+
+        def = defnew;               // update norm
+        bool converged = (def<def0*_reduction || def<1E-30);
+
+        // determine new search direction
+        znew = 0;                   // clear correction
+        if (!converged)
+          _prec.apply(znew,b);      // apply preconditioner
+
+        // remember direction: M^{-1}Ap = (z - znew)/lambda
+        if (static_cast<int>(_P.size())<_l && !converged) {
+          _P.push_back(p);
+          _AP.push_back(q);
+          _MAP.push_back(z);
+          _MAP.back() -= znew;
+          _MAP.back() *= 1.0/lambda;
+        }
+
+        if (converged)    // convergence check
+        {
+          res.converged  = true;
+          break;
+        }
+
+        z = znew;
+        rho = _sp.dot(z,b);         // orthogonalization
+        beta = rho/rholast;         // scaling factor
+        p *= beta;                  // scale old search direction
+        p += z;                     // orthogonalization with correction
+        deflate(p,z,mu);
+        rholast = rho;              // remember rho for recurrence
+      }
+
+      if (_verbose==1)                // printing for non verbose
+        this->printOutput(std::cout,i,def);
+
+      updateRecyclingSpace();
+      _prec.post(x);                  // postprocess preconditioner
+      res.iterations = i;               // fill statistics
+      res.reduction = def/def0;
+      res.conv_rate  = pow(res.reduction,1.0/i);
+      res.elapsed = watch.elapsed();
+
+      if (_verbose>0)                 // final print
+      {
+        std::cout << "=== rate=" << res.conv_rate
+                  << ", T=" << res.elapsed
+                  << ", TIT=" << res.elapsed/i
+                  << ", IT=" << i << std::endl;
+      }
+    }
+
+    /*!
+      \brief Apply inverse operator with given reduction factor.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction,
+      InverseOperatorResult& res)
+    {
+      std::swap(_reduction,reduction);
+      (*this).apply(x,b,res);
+      std::swap(_reduction,reduction);
+    }
+
+    //! \brief Get the current dimension of the recycled subspace.
+    int recycledSubspaceSize() const
+    {
+      return _W.size();
+    }
+
+    //! \brief Forget the recycled subspace, e.g. if the operator changed a lot.
+    void clearRecycledSubspace()
+    {
+      _W.clear(); _AW.clear(); _MAW.clear();
+    }
+
+  private:
+    typedef RecyclingDenseHelper<field_type> Helper;
+    typedef typename Helper::Matrix Matrix;
+
+    //! \brief Computes AW, M^{-1}AW and factorizes W^T A W.
+    void setupDeflation(const X& b)
+    {
+      const int k = _W.size();
+      if (k==0)
+        return;
+      _AW.assign(k,b);
+      _MAW.assign(k,b);
+      Matrix waw(k, std::vector<field_type>(k));
+      for (int i=0; i<k; ++i) {
+        _op.apply(_W[i],_AW[i]);
+        _MAW[i] = 0;
+        _prec.apply(_MAW[i],_AW[i]);
+      }
+      for (int i=0; i<k; ++i)
+        for (int j=0; j<=i; ++j)
+          waw[i][j] = waw[j][i] = _sp.dot(_W[i],_AW[j]);
+      if (!Helper::cholesky(waw,_WAWfactor)) {
+        if (_verbose>0)
+          std::cout << "=== RecyclingCGSolver: dropping degenerate recycled subspace"
+                    << std::endl;
+        clearRecycledSubspace();
+      }
+    }
+
+    //! \brief Computes mu = (W^T A W)^{-1} W^T v.
+    void project(const X& v, std::vector<field_type>& mu) const
+    {
+      const int k = _W.size();
+      mu.resize(k);
+      for (int i=0; i<k; ++i) {
+        mu[i] = _sp.dot(_W[i],v);
+        for (int m=0; m<i; ++m)
+          mu[i] -= _WAWfactor[i][m]*mu[m];
+        mu[i] /= _WAWfactor[i][i];
+      }
+      for (int i=k-1; i>=0; --i) {
+        for (int m=i+1; m<k; ++m)
+          mu[i] -= _WAWfactor[m][i]*mu[m];
+        mu[i] /= _WAWfactor[i][i];
+      }
+    }
+
+    //! \brief Makes p A-orthogonal to W: p -= W (W^T A W)^{-1} (AW)^T z.
+    void deflate(X& p, const X& z, std::vector<field_type>& mu) const
+    {
+      const int k = _W.size();
+      if (k==0)
+        return;
+      mu.resize(k);
+      for (int i=0; i<k; ++i) {
+        mu[i] = _sp.dot(_AW[i],z);
+        for (int m=0; m<i; ++m)
+          mu[i] -= _WAWfactor[i][m]*mu[m];
+        mu[i] /= _WAWfactor[i][i];
+      }
+      for (int i=k-1; i>=0; --i) {
+        for (int m=i+1; m<k; ++m)
+          mu[i] -= _WAWfactor[m][i]*mu[m];
+        mu[i] /= _WAWfactor[i][i];
+      }
+      for (int i=0; i<k; ++i)
+        p.axpy(-mu[i],_W[i]);
+    }
+
+    /**
+     * @brief Replaces W by the Ritz vectors of \f$ M^{-1}A\f$ in span{W,P}.
+     *
+     * Solves \f$ (AS)^T M^{-1} (AS) y = \theta S^T A S y\f$ with S=[W,P]
+     * and keeps the vectors belonging to the smallest \f$\theta\f$.
+     */
+    void updateRecyclingSpace()
+    {
+      const int kw = _W.size();
+      const int n = kw + _P.size();
+      const int k = std::min(_k,n);
+      if (k==0)
+        return;
+
+      // gather S, AS and M^{-1}AS
+      std::vector<const X*> s(n), as(n), mas(n);
+      for (int i=0; i<kw; ++i) {
+        s[i] = &_W[i]; as[i] = &_AW[i]; mas[i] = &_MAW[i];
+      }
+      for (int i=kw; i<n; ++i) {
+        s[i] = &_P[i-kw]; as[i] = &_AP[i-kw]; mas[i] = &_MAP[i-kw];
+      }
+
+      Matrix f(n, std::vector<field_type>(n)), g(f), y;
+      for (int i=0; i<n; ++i)
+        for (int j=0; j<=i; ++j) {
+          f[i][j] = f[j][i] = 0.5*(_sp.dot(*s[i],*as[j])+_sp.dot(*s[j],*as[i]));
+          g[i][j] = g[j][i] = 0.5*(_sp.dot(*as[i],*mas[j])+_sp.dot(*as[j],*mas[i]));
+        }
+
+      if (!Helper::smallestEigenvectors(g,f,k,y))
+        return;
+
+      std::vector<X> w(k,*s[0]);
+      for (int j=0; j<k; ++j) {
+        w[j] = 0;
+        for (int i=0; i<n; ++i)
+          w[j].axpy(y[i][j],*s[i]);
+      }
+      _W.swap(w);
+      _AW.clear(); _MAW.clear();
+      _P.clear(); _AP.clear(); _MAP.clear();
+    }
+
+    SeqScalarProduct<X> ssp;
+    LinearOperator<X,X>& _op;
+    Preconditioner<X,X>& _prec;
+    ScalarProduct<X>& _sp;
+    double _reduction;
+    int _k;
+    int _l;
+    int _maxit;
+    int _verbose;
+    // the recycled subspace and its images
+    std::vector<X> _W, _AW, _MAW;
+    Matrix _WAWfactor;
+    // search directions of the current solve
+    std::vector<X> _P, _AP, _MAP;
+  };
+
+  /**
+     \brief Restarted GMRes with deflated restarting and subspace
+     recycling between solves (GCRO-DR).
+
+     Implements the GCRO-DR method of M. L. Parks, E. de Sturler,
+     G. Mackey, D. D. Johnson and S. Maiti, 'Recycling Krylov subspaces
+     for sequences of linear systems', SIAM J. Sci. Comput. 28, 2006.
+     A subspace U of dimension k with \f$ C = AM^{-1}U\f$, \f$ C^TC = I\f$,
+     is kept across restarts and across calls of apply(). Each cycle
+     projects the defect onto the complement of C and builds a Krylov
+     space of dimension restart-k of \f$ (I-CC^T)AM^{-1}\f$.
+
+     After each cycle U is replaced by the k vectors of the search space
+     with the smallest ratio \f$ \|AM^{-1}u\|/\|u\|\f$, i.e. by
+     approximate right singular vectors instead of the harmonic Ritz
+     vectors of the original method. This keeps the update a symmetric
+     eigenvalue problem and coincides with the harmonic Ritz choice
+     for normal operators.
+
+     Unlike RestartedGMResSolver the preconditioner is applied from the
+     right, thus the convergence test uses the true defect. The
+     preconditioner has to be linear.
+  */
+  template<class X>
+  class RecyclingGMResSolver : public InverseOperator<X,X>
+  {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted
+    typedef typename X::field_type field_type;
+    //! \brief The real type of the field type
+    typedef typename FieldTraits<field_type>::real_type real_type;
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+      \param k The dimension of the recycled subspace.
+      \param restart The dimension of the search space of each cycle,
+      including the recycled subspace. Has to be larger than k.
+    */
+    template<class L, class P>
+    RecyclingGMResSolver (L& op, P& prec, double reduction, int k, int restart, int maxit, int verbose) :
+      _A_(op), _M(prec),
+      ssp(), _sp(ssp), _k(k), _restart(restart),
+      _reduction(reduction), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert(static_cast<int>(P::category) == static_cast<int>(L::category),
+        "P and L must be the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential),
+        "L must be sequential!");
+      if (restart<=k)
+        DUNE_THROW(ISTLError,"restart has to be larger than the recycled subspace");
+    }
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,S&,P&,double,int,int)
+      \param k The dimension of the recycled subspace.
+      \param restart The dimension of the search space of each cycle,
+      including the recycled subspace. Has to be larger than k.
+    */
+    template<class L, class S, class P>
+    RecyclingGMResSolver (L& op, S& sp, P& prec, double reduction, int k, int restart, int maxit, int verbose) :
+      _A_(op), _M(prec),
+      _sp(sp), _k(k), _restart(restart),
+      _reduction(reduction), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert(static_cast<int>(P::category) == static_cast<int>(L::category),
+        "P and L must have the same category!");
+      dune_static_assert(static_cast<int>(P::category) == static_cast<int>(S::category),
+        "P and S must have the same category!");
+      if (restart<=k)
+        DUNE_THROW(ISTLError,"restart has to be larger than the recycled subspace");
+    }
+
+    //! \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      apply(x,b,_reduction,res);
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction, InverseOperatorResult& res)
+    {
+      real_type norm, norm_old, norm_0;
+      int j = 1;
+
+      // helper vectors
+      X w(b);   // correction before preconditioning
+      X t(b);
+      std::vector<X> v(_restart+1,b);
+
+      Timer watch;                // start a timer
+
+      // clear solver statistics
+      res.clear();
+      _M.pre(x,b);
+      _A_.applyscaleadd(-1,x, /* => */ b); // b = b - Ax;
+      norm_0 = norm = norm_old = _sp.norm(b);
+
+      // print header
+      if (_verbose > 0)
+      {
+        std::cout << "=== RecyclingGMResSolver (recycled subspace "
+                  << _U.size() << ")" << std::endl;
+        if (_verbose > 1)
+        {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,norm_0);
+        }
+      }
+
+      if (norm_0 == 0.0 || norm <= reduction * norm_0) {
+        _M.post(x);                  // postprocess preconditioner
+        res.converged  = true;
+        res.elapsed = watch.elapsed();
+        if (_verbose > 0)                 // final print
+          print_result(res);
+        return;
+      }
+
+      // recompute C = A M^{-1} U for the current operator
+      setupRecyclingSpace(t);
+
+      while (j <= _maxit && res.converged != true) {
+        const int kk = _U.size();
+        const int mm = _restart - kk;
+
+        // project defect: w = U C^T r, v[0] = r - C C^T r
+        w = 0;
+        v[0] = b;
+        for (int i=0; i<kk; ++i) {
+          field_type c = _sp.dot(_C[i],b);
+          w.axpy(c,_U[i]);
+          v[0].axpy(-c,_C[i]);
+        }
+        real_type beta = _sp.norm(v[0]);
+        if (beta <= std::numeric_limits<real_type>::epsilon() * norm_0) {
+          // the defect lies in the recycled subspace and w solves the problem
+          t = 0.0;
+          _M.apply(t, w);
+          x += t;
+          _A_.applyscaleadd(-1,t, /* => */ b);
+          norm = _sp.norm(b);
+          res.converged = true;
+          break;
+        }
+        v[0] *= (1.0 / beta);
+
+        // the least squares problem min |s - G y| with
+        // G = [D B; 0 H] of size (kk+mm+1) x (kk+mm)
+        std::vector<real_type> d(kk);
+        Matrix g(kk+mm+1, std::vector<field_type>(kk+mm, field_type(0)));
+        for (int i=0; i<kk; ++i) {
+          d[i] = 1.0/_sp.norm(_U[i]);
+          g[i][i] = d[i];
+        }
+        Matrix h(g);   // the factorized least squares matrix
+        std::vector<field_type> s(kk+mm+1, field_type(0)), cs(kk+mm), sn(kk+mm);
+        s[kk] = beta;
+        for (int i=0; i<kk; ++i)
+          generatePlaneRotation(h[i][i], h[i+1][i], cs[i], sn[i]);
+
+        int i;
+        for (i = 0; i < mm && j <= _maxit && res.converged != true; i++, j++) {
+          const int col = kk+i;
+          // w_new = (I - C C^T) A M^{-1} v[i]
+          t = 0.0;
+          _M.apply(t, v[i]);
+          _A_.apply(t, v[i+1]);
+          for (int l=0; l<kk; ++l) {
+            g[l][col] = _sp.dot(_C[l], v[i+1]);
+            v[i+1].axpy(-g[l][col], _C[l]);
+          }
+          for (int l=0; l<=i; ++l) {
+            g[kk+l][col] = _sp.dot(v[l], v[i+1]);
+            v[i+1].axpy(-g[kk+l][col], v[l]);
+          }
+          g[kk+i+1][col] = _sp.norm(v[i+1]);
+          if (g[kk+i+1][col] != 0.0)
+            v[i+1] *= (1.0 / g[kk+i+1][col]);
+
+          for (int l=0; l<=col+1; ++l)
+            h[l][col] = g[l][col];
+          for (int l = 0; l < col; l++)
+            applyPlaneRotation(h[l][col], h[l+1][col], cs[l], sn[l]);
+          generatePlaneRotation(h[col][col], h[col+1][col], cs[col], sn[col]);
+          applyPlaneRotation(h[col][col], h[col+1][col], cs[col], sn[col]);
+          applyPlaneRotation(s[col], s[col+1], cs[col], sn[col]);
+
+          norm = std::abs(s[col+1]);
+
+          if (_verbose > 1)             // print
+            this->printOutput(std::cout,j,norm,norm_old);
+          norm_old = norm;
+
+          if (norm < reduction * norm_0)
+            res.converged = true;
+        }
+        const int n = kk+i;
+
+        // solve the least squares problem and update the correction
+        std::vector<field_type> y(s);
+        for (int l = n-1; l >= 0; l--) {
+          y[l] /= h[l][l];
+          for (int m = l-1; m >= 0; m--)
+            y[m] -= h[m][l] * y[l];
+        }
+        for (int l = 0; l < kk; l++)
+          w.axpy(y[l]*d[l], _U[l]);
+        for (int l = 0; l < i; l++)
+          w.axpy(y[kk+l], v[l]);
+
+        // x += M^{-1} w, r = b - A x
+        t = 0.0;
+        _M.apply(t, w);
+        x += t;
+        _A_.applyscaleadd(-1,t, /* => */ b);
+        norm = _sp.norm(b);
+
+        if (_verbose > 1)             // print
+          this->printOutput(std::cout,j,norm,norm_old);
+        norm_old = norm;
+
+        res.converged = (norm < reduction * norm_0);
+
+        updateRecyclingSpace(g, d, v, n, i);
+
+        if (res.converged != true && _verbose > 0)
+          std::cout << "=== RecyclingGMRes::restart\n";
+      }
+
+      _M.post(x);                  // postprocess preconditioner
+
+      res.iterations = j;
+      res.reduction = norm / norm_0;
+      res.conv_rate  = pow(res.reduction,1.0/j);
+      res.elapsed = watch.elapsed();
+
+      if (_verbose>0)
+        print_result(res);
+    }
+
+    //! \brief Get the current dimension of the recycled subspace.
+    int recycledSubspaceSize() const
+    {
+      return _U.size();
+    }
+
+    //! \brief Forget the recycled subspace, e.g. if the operator changed a lot.
+    void clearRecycledSubspace()
+    {
+      _U.clear(); _C.clear();
+    }
+
+  private:
+    typedef RecyclingDenseHelper<field_type> Helper;
+    typedef typename Helper::Matrix Matrix;
+
+    void
+    print_result (const InverseOperatorResult & res) const
+    {
+      int j = res.iterations>0?res.iterations:1;
+      std::cout << "=== rate=" << res.conv_rate
+                << ", T=" << res.elapsed
+                << ", TIT=" << res.elapsed/j
+                << ", IT=" << res.iterations
+                << std::endl;
+    }
+
+    /**
+     * @brief Computes C = A M^{-1} U and orthonormalizes it, updating U
+     * such that the relation is kept.
+     */
+    void setupRecyclingSpace(X& t)
+    {
+      const int k = _U.size();
+      if (k==0)
+        return;
+      _C.assign(k,t);
+      for (int i=0; i<k; ++i) {
+        t = 0.0;
+        _M.apply(t, _U[i]);
+        _A_.apply(t, _C[i]);
+      }
+      // modified Gram-Schmidt, applied to C and U alike
+      for (int i=0; i<k; ++i) {
+        for (int l=0; l<i; ++l) {
+          field_type r = _sp.dot(_C[l],_C[i]);
+          _C[i].axpy(-r,_C[l]);
+          _U[i].axpy(-r,_U[l]);
+        }
+        real_type r = _sp.norm(_C[i]);
+        if (!(r > 0.0)) {
+          if (_verbose>0)
+            std::cout << "=== RecyclingGMResSolver: dropping degenerate recycled subspace"
+                      << std::endl;
+          clearRecycledSubspace();
+          return;
+        }
+        _C[i] *= 1.0/r;
+        _U[i] *= 1.0/r;
+      }
+    }
+
+    /**
+     * @brief Replaces U and C after a cycle.
+     *
+     * With \f$ \hat V = [UD, V_i]\f$ and \f$ \hat W = [C, V_{i+1}]\f$ we
+     * have \f$ AM^{-1}\hat V = \hat W G\f$. The new U is \f$ \hat V Y\f$
+     * where Y holds the solutions of \f$ G^TG y = \sigma^2 \hat V^T\hat V y\f$
+     * for the k smallest \f$\sigma\f$.
+     */
+    void updateRecyclingSpace(const Matrix& g, const std::vector<real_type>& d,
+                              const std::vector<X>& v, int n, int i)
+    {
+      const int kk = _U.size();
+      const int k = std::min(_k,n);
+      if (k==0)
+        return;
+
+      // G^T G and \hat V^T \hat V
+      Matrix gtg(n, std::vector<field_type>(n, field_type(0))), vtv(gtg), y;
+      for (int a=0; a<n; ++a)
+        for (int b=0; b<=a; ++b) {
+          field_type sum = 0;
+          for (int r=0; r<=n; ++r)
+            sum += g[r][a]*g[r][b];
+          gtg[a][b] = gtg[b][a] = sum;
+        }
+      for (int a=0; a<n; ++a)
+        vtv[a][a] = 1.0;
+      for (int a=0; a<kk; ++a) {
+        for (int b=0; b<=a; ++b)
+          vtv[a][b] = vtv[b][a] = d[a]*d[b]*_sp.dot(_U[a],_U[b]);
+        for (int b=0; b<i; ++b)
+          vtv[a][kk+b] = vtv[kk+b][a] = d[a]*_sp.dot(_U[a],v[b]);
+      }
+
+      if (!Helper::smallestEigenvectors(gtg,vtv,k,y))
+        return;
+
+      // QR factorization G Y = Q R by modified Gram-Schmidt
+      Matrix q(n+1, std::vector<field_type>(k, field_type(0)));
+      Matrix r(k, std::vector<field_type>(k, field_type(0)));
+      for (int c=0; c<k; ++c)
+        for (int a=0; a<=n; ++a)
+          for (int b=0; b<n; ++b)
+            q[a][c] += g[a][b]*y[b][c];
+      for (int c=0; c<k; ++c) {
+        for (int l=0; l<c; ++l) {
+          field_type dot = 0;
+          for (int a=0; a<=n; ++a)
+            dot += q[a][l]*q[a][c];
+          r[l][c] = dot;
+          for (int a=0; a<=n; ++a)
+            q[a][c] -= dot*q[a][l];
+        }
+        field_type nrm = 0;
+        for (int a=0; a<=n; ++a)
+          nrm += q[a][c]*q[a][c];
+        r[c][c] = std::sqrt(nrm);
+        if (!(r[c][c] > 0.0))
+          return;
+        for (int a=0; a<=n; ++a)
+          q[a][c] /= r[c][c];
+      }
+
+      // Y R^{-1} by backward substitution on the rows of Y
+      for (int a=0; a<n; ++a)
+        for (int c=0; c<k; ++c) {
+          for (int l=0; l<c; ++l)
+            y[a][c] -= y[a][l]*r[l][c];
+          y[a][c] /= r[c][c];
+        }
+
+      // U = \hat V Y R^{-1}, C = \hat W Q
+      std::vector<X> u(k,v[0]), c(k,v[0]);
+      for (int l=0; l<k; ++l) {
+        u[l] = 0; c[l] = 0;
+        for (int a=0; a<kk; ++a) {
+          u[l].axpy(y[a][l]*d[a], _U[a]);
+          c[l].axpy(q[a][l], _C[a]);
+        }
+        for (int a=0; a<i; ++a)
+          u[l].axpy(y[kk+a][l], v[a]);
+        for (int a=0; a<=i; ++a)
+          c[l].axpy(q[kk+a][l], v[a]);
+      }
+      _U.swap(u);
+      _C.swap(c);
+    }
+
+    void
+    generatePlaneRotation(field_type &dx, field_type &dy, field_type &cs, field_type &sn)
+    {
+      if (dy == 0.0) {
+        cs = 1.0;
+        sn = 0.0;
+      } else if (std::abs(dy) > std::abs(dx)) {
+        field_type temp = dx / dy;
+        sn = 1.0 / std::sqrt( 1.0 + temp*temp );
+        cs = temp * sn;
+      } else {
+        field_type temp = dy / dx;
+        cs = 1.0 / std::sqrt( 1.0 + temp*temp );
+        sn = temp * cs;
+      }
+    }
+
+    void
+    applyPlaneRotation(field_type &dx, field_type &dy, field_type &cs, field_type &sn)
+    {
+      field_type temp  =  cs * dx + sn * dy;
+      dy = -sn * dx + cs * dy;
+      dx = temp;
+    }
+
+    LinearOperator<X,X>& _A_;
+    Preconditioner<X,X>& _M;
+    SeqScalarProduct<X> ssp;
+    ScalarProduct<X>& _sp;
+    int _k;
+    int _restart;
+    double _reduction;
+    int _maxit;
+    int _verbose;
+    // the recycled subspace U and C = A M^{-1} U
+    std::vector<X> _U, _C;
+  };
+
+  /** @} end documentation */
+
+} // end namespace
+
+#endif
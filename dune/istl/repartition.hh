@@ -3,7 +3,9 @@
 
 #include <cassert>
 #include <map>
+#include <set>
 #include <utility>
+#include <vector>
 
 #if HAVE_PARMETIS
 #include <parmetis.h>
@@ -456,6 +458,153 @@ namespace Dune
       delete[] domainMatrix;
 
     }
+
+    /**
+     * @brief Partition a weighted graph by greedy graph growing.
+     *
+     * The domains are grown one after another. A domain starts at the
+     * unassigned vertex with the lowest number and is grown by the
+     * unassigned vertex with the strongest connection to it until it
+     * holds its share of the remaining vertex weight. Each domain gets at
+     * least one vertex, the last domain takes all remaining vertices.
+     *
+     * @param weights The weights of the vertices.
+     * @param edges The adjacency of each vertex mapping the neighbour to
+     * the edge weight. Has to be symmetric.
+     * @param nparts The number of domains, at most the number of vertices.
+     * @param[out] domain The domain of each vertex.
+     */
+    inline void greedyGraphGrowing(const std::vector<int>& weights,
+                                   const std::vector<std::map<int,int> >& edges,
+                                   int nparts, std::vector<int>& domain)
+    {
+      typedef std::map<int,int>::const_iterator EdgeIterator;
+      int noVertices=weights.size();
+      assert(nparts<=noVertices);
+      domain.assign(noVertices, -1);
+
+      // The connection of the unassigned vertices to the current domain.
+      // The front is sorted by connection and prefers lower vertex numbers.
+      std::vector<int> connection(noVertices, 0);
+      std::set<std::pair<int,int> > front;
+      double remainingWeight=0;
+      for(int v=0; v<noVertices; ++v)
+        remainingWeight+=weights[v];
+      int unassigned=noVertices;
+      int seed=0;
+
+      for(int d=0; d<nparts; ++d){
+        double target=remainingWeight/(nparts-d);
+        double domainWeight=0;
+        int domainSize=0;
+
+        while(unassigned>nparts-d-1){
+          int next;
+          if(front.empty()){
+            // Start at the next unassigned vertex
+            while(domain[seed]>=0)
+              ++seed;
+            next=seed;
+          }else
+            next=-front.rbegin()->second;
+
+          if(domainSize>0 && d<nparts-1 && domainWeight+weights[next]/2.0>target)
+            break;
+
+          front.erase(std::make_pair(connection[next], -next));
+          domain[next]=d;
+          domainWeight+=weights[next];
+          remainingWeight-=weights[next];
+          ++domainSize;
+          --unassigned;
+
+          for(EdgeIterator e=edges[next].begin(); e!=edges[next].end(); ++e)
+            if(domain[e->first]<0){
+              front.erase(std::make_pair(connection[e->first], -e->first));
+              connection[e->first]+=e->second;
+              front.insert(std::make_pair(connection[e->first], -e->first));
+            }
+        }
+        // The next domain grows independently
+        for(std::set<std::pair<int,int> >::iterator f=front.begin(); f!=front.end(); ++f)
+          connection[-f->second]=0;
+        front.clear();
+      }
+    }
+
+    /**
+     * @brief Partition the graph of the processes without ParMETIS.
+     *
+     * Each process is a vertex weighted by the number of its owner
+     * vertices. Processes sharing indices are connected by an edge
+     * weighted by the number of shared indices. The graph is gathered on
+     * all processes and partitioned by greedyGraphGrowing. Each domain
+     * is mapped to the process of it holding most of the vertices.
+     *
+     * @param oocomm The parallel information with built remote indices.
+     * @param noVertices The number of local vertices. Vertices missing in
+     * the index set are counted as owner vertices.
+     * @param nparts The number of domains, at most the number of processes.
+     * @param[out] domainMapping The process each domain is mapped to.
+     * @return The domain of this process.
+     */
+    template<class T1, class T2>
+    int greedyCommGraphPartition(Dune::OwnerOverlapCopyCommunication<T1,T2>& oocomm,
+                                 std::size_t noVertices, int nparts,
+                                 std::vector<int>& domainMapping)
+    {
+      typedef typename Dune::OwnerOverlapCopyCommunication<T1,T2> OOComm;
+      typedef typename OOComm::OwnerSet OwnerSet;
+      typedef typename OOComm::ParallelIndexSet::const_iterator IndexIterator;
+      typedef typename OOComm::RemoteIndices::const_iterator NeighbourIterator;
+
+      MPI_Comm comm=oocomm.communicator();
+      int rank=oocomm.communicator().rank();
+      int size=oocomm.communicator().size();
+
+      int weight=noVertices;
+      for(IndexIterator index=oocomm.indexSet().begin(); index!=oocomm.indexSet().end(); ++index)
+        if(!OwnerSet::contains(index->local().attribute()))
+          --weight;
+
+      // pairs of neighbour process and number of shared indices
+      std::vector<int> adjacency;
+      for(NeighbourIterator n=oocomm.remoteIndices().begin(); n!=oocomm.remoteIndices().end(); ++n)
+        if(n->first!=rank){
+          adjacency.push_back(n->first);
+          adjacency.push_back(n->second.first->size());
+        }
+      int noAdjacency=adjacency.size();
+      adjacency.resize(noAdjacency+1);
+
+      std::vector<int> weights(size), noAdjacencies(size), displ(size+1, 0);
+      MPI_Allgather(&weight, 1, MPI_INT, &weights[0], 1, MPI_INT, comm);
+      MPI_Allgather(&noAdjacency, 1, MPI_INT, &noAdjacencies[0], 1, MPI_INT, comm);
+      for(int p=0; p<size; ++p)
+        displ[p+1]=displ[p]+noAdjacencies[p];
+      std::vector<int> gadjacency(displ[size]+1);
+      MPI_Allgatherv(&adjacency[0], noAdjacency, MPI_INT, &gadjacency[0],
+                     &noAdjacencies[0], &displ[0], MPI_INT, comm);
+
+      std::vector<std::map<int,int> > edges(size);
+      for(int p=0; p<size; ++p)
+        for(int i=displ[p]; i<displ[p+1]; i+=2){
+          edges[p][gadjacency[i]]+=gadjacency[i+1];
+          edges[gadjacency[i]][p]+=gadjacency[i+1];
+        }
+
+      std::vector<int> domain;
+      greedyGraphGrowing(weights, edges, nparts, domain);
+
+      domainMapping.assign(nparts, -1);
+      for(int p=0; p<size; ++p)
+        if(domainMapping[domain[p]]<0 || weights[p]>weights[domainMapping[domain[p]]])
+          domainMapping[domain[p]]=p;
+
+      Dune::dinfo<<rank<<": greedy partition domain "<<domain[rank]<<" on process "
+                 <<domainMapping[domain[rank]]<<std::endl;
+      return domain[rank];
+    }
   
     struct SortFirst
     {
@@ -828,6 +977,15 @@ namespace Dune
 #if !HAVE_PARMETIS
     int* part = new int[1];
     part[0]=0;
+    if(nparts>1){
+      // No ParMETIS available, use the built-in partitioner
+      std::vector<int> domainMapping;
+      int domain = greedyCommGraphPartition(oocomm, mat.N(), nparts, domainMapping);
+      part[0]=domainMapping[domain];
+      if(verbose && oocomm.communicator().rank()==0)
+	std::cout<<"Greedy partitioning of the communication graph took "<<time.elapsed()<<std::endl;
+      time.reset();
+    }
 #else
     idxtype* part = new idxtype[1]; // where all our data moves to
 
@@ -1198,7 +1356,9 @@ namespace Dune
    * @brief execute a graph repartition for a giving graph and indexset.
    *
    * This function provides repartition functionality using the 
-   * PARMETIS library
+   * PARMETIS library. Without ParMETIS the graph of the processes is
+   * partitioned by greedyCommGraphPartition, i.e. the vertices of a
+   * process are never split.
    *
    * @param graph The given graph to repartition
    * @param oocomm The parallel information about the graph.
@@ -1270,12 +1430,22 @@ namespace Dune
     for(std::size_t i=0; i < indexMap.numOfOwnVtx(); ++i)
       part[i]=mype;
 
+    std::vector<int> domainMapping(nparts);
+
 #if !HAVE_PARMETIS
-    if(oocomm.communicator().rank()==0 && nparts>1)
-      std::cerr<<"ParMETIS not activated. Will repartition to 1 domain instead of requested "
-	       <<nparts<<" domains."<<std::endl;
-    nparts=1; // No parmetis available, fallback to agglomerating to 1 process
-    
+    if(nparts>1){
+      // No ParMETIS available, partition the graph of the processes instead.
+      myDomain = greedyCommGraphPartition(oocomm, graph.noVertices(), nparts, domainMapping);
+      for(std::size_t i=0; i<indexMap.numOfOwnVtx();++i)
+	part[i]=myDomain;
+
+      if(verbose){
+        oocomm.communicator().barrier();
+        if(oocomm.communicator().rank()==0)
+          std::cout<<"Greedy partitioning took "<<time.elapsed()<<std::endl;
+      }
+      time.reset();
+    }else
 #else
 
     if(nparts>1){
@@ -1387,11 +1557,12 @@ namespace Dune
     //    result
     //
   
-    std::vector<int> domainMapping(nparts);
-    if(nparts>1)
-      getDomain(comm, part, indexMap.numOfOwnVtx(), nparts, &myDomain, domainMapping);
-    else
+    if(nparts==1)
       domainMapping[0]=0;
+#if HAVE_PARMETIS
+    else
+      getDomain(comm, part, indexMap.numOfOwnVtx(), nparts, &myDomain, domainMapping);
+#endif
     
 #ifdef DEBUG_REPART
     std::cout<<mype<<": myDomain: "<<myDomain<<std::endl;
@@ -4,11 +4,13 @@
 #ifndef DUNE_SOLVERS_HH
 #define DUNE_SOLVERS_HH
 
+#include<algorithm>
 #include<cmath>
 #include<complex>
 #include<iostream>
 #include<iomanip>
 #include<string>
+#include<vector>
 
 #include "istlexception.hh"
 #include "operators.hh"
@@ -59,6 +61,9 @@ namespace Dune {
       converged = false;
       conv_rate = 1;
       elapsed = 0;
+      condition_estimate = -1;
+      min_eigenvalue_estimate = -1;
+      max_eigenvalue_estimate = -1;
     }
 
     /** \brief Number of iterations */
@@ -75,6 +80,18 @@ namespace Dune {
 
     /** \brief Elapsed time in seconds */
     double elapsed;
+
+    /**
+     * \brief Estimate of the condition number of the (preconditioned)
+     * operator, -1 if the solver did not compute one.
+     */
+    double condition_estimate;
+
+    /** \brief Estimate of the smallest eigenvalue, -1 if not available. */
+    double min_eigenvalue_estimate;
+
+    /** \brief Estimate of the largest eigenvalue, -1 if not available. */
+    double max_eigenvalue_estimate;
   };
 
 
@@ -490,10 +507,15 @@ namespace Dune {
       \brief Set up conjugate gradient solver.
 
       \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+      \param condition_estimate Whether to estimate the extreme eigenvalues
+      and the condition number of the preconditioned operator from the
+      Lanczos coefficients of the iteration [default=false].
     */
     template<class L, class P>
-    CGSolver (L& op, P& prec, double reduction, int maxit, int verbose) :
-      ssp(), _op(op), _prec(prec), _sp(ssp), _reduction(reduction), _maxit(maxit), _verbose(verbose)
+    CGSolver (L& op, P& prec, double reduction, int maxit, int verbose,
+              bool condition_estimate = false) :
+      ssp(), _op(op), _prec(prec), _sp(ssp), _reduction(reduction), _maxit(maxit), _verbose(verbose),
+      _condition_estimate(condition_estimate)
     {
       dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
         "L and P must have the same category!");
@@ -504,10 +526,15 @@ namespace Dune {
       \brief Set up conjugate gradient solver.
 
       \copydoc LoopSolver::LoopSolver(L&,S&,P&,double,int,int)
+      \param condition_estimate Whether to estimate the extreme eigenvalues
+      and the condition number of the preconditioned operator from the
+      Lanczos coefficients of the iteration [default=false].
     */
     template<class L, class S, class P>
-    CGSolver (L& op, S& sp, P& prec, double reduction, int maxit, int verbose) :
-      _op(op), _prec(prec), _sp(sp), _reduction(reduction), _maxit(maxit), _verbose(verbose)
+    CGSolver (L& op, S& sp, P& prec, double reduction, int maxit, int verbose,
+              bool condition_estimate = false) :
+      _op(op), _prec(prec), _sp(sp), _reduction(reduction), _maxit(maxit), _verbose(verbose),
+      _condition_estimate(condition_estimate)
     {
       dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
         "L and P must have the same category!");
@@ -558,6 +585,9 @@ namespace Dune {
       double def=def0;   // loop variables
       field_type rho,rholast,lambda,alpha,beta;
 
+      // the coefficients of the Lanczos process
+      std::vector<field_type> lambdas, betas;
+
       // determine initial search direction
       p = 0;                          // clear correction
       _prec.apply(p,b);               // apply preconditioner
@@ -571,6 +601,8 @@ namespace Dune {
         _op.apply(p,q);             // q=Ap
         alpha = _sp.dot(p,q);       // scalar product
         lambda = rholast/alpha;     // minimization
+        if (_condition_estimate)
+          lambdas.push_back(lambda);
         x.axpy(lambda,p);           // update solution
         b.axpy(-lambda,q);          // update defect
 
@@ -592,6 +624,8 @@ namespace Dune {
         _prec.apply(q,b);           // apply preconditioner
         rho = _sp.dot(q,b);         // orthogonalization
         beta = rho/rholast;         // scaling factor
+        if (_condition_estimate)
+          betas.push_back(beta);
         p *= beta;                  // scale old search direction
         p += q;                     // orthogonalization with correction
         rholast = rho;              // remember rho for recurrence
@@ -606,12 +640,20 @@ namespace Dune {
       res.conv_rate  = pow(res.reduction,1.0/i);
       res.elapsed = watch.elapsed();
 
+      if (_condition_estimate)
+        estimateSpectrum(lambdas,betas,res);
+
       if (_verbose>0)                 // final print
       {
         std::cout << "=== rate=" << res.conv_rate
                   << ", T=" << res.elapsed
                   << ", TIT=" << res.elapsed/i
                   << ", IT=" << i << std::endl;
+        if (_condition_estimate)
+          std::cout << "=== eigenvalues in [" << res.min_eigenvalue_estimate
+                    << ", " << res.max_eigenvalue_estimate
+                    << "], condition estimate=" << res.condition_estimate
+                    << std::endl;
       }
     }
 
@@ -629,6 +671,70 @@ namespace Dune {
     }
 
   private:
+    /**
+     * @brief Computes the extreme eigenvalues of the Lanczos matrix.
+     *
+     * The symmetric tridiagonal Lanczos matrix T of the preconditioned
+     * operator is given by the CG coefficients as
+     * \f$ T_{jj} = 1/\lambda_j + \beta_{j-1}/\lambda_{j-1}\f$ and
+     * \f$ T_{j,j+1} = \sqrt{\beta_j}/\lambda_j\f$. Its extreme eigenvalues
+     * are computed by bisection using Sturm sequences.
+     */
+    static void estimateSpectrum(const std::vector<field_type>& lambdas,
+                                 const std::vector<field_type>& betas,
+                                 InverseOperatorResult& res)
+    {
+      const int n = lambdas.size();
+      if (n==0)
+        return;
+      std::vector<double> d(n), e(n,0.0);
+      for (int j=0; j<n; ++j) {
+        d[j] = 1.0/lambdas[j];
+        if (j>0)
+          d[j] += betas[j-1]/lambdas[j-1];
+        if (j<n-1)
+          e[j] = std::sqrt(std::abs(betas[j]))/lambdas[j];
+      }
+
+      // Gershgorin bounds
+      double lower = d[0], upper = d[0];
+      for (int j=0; j<n; ++j) {
+        double r = std::abs(e[j]) + (j>0 ? std::abs(e[j-1]) : 0.0);
+        lower = std::min(lower, d[j]-r);
+        upper = std::max(upper, d[j]+r);
+      }
+
+      res.min_eigenvalue_estimate = bisect(d,e,lower,upper,1);
+      res.max_eigenvalue_estimate = bisect(d,e,lower,upper,n);
+      if (res.min_eigenvalue_estimate>0)
+        res.condition_estimate = res.max_eigenvalue_estimate/res.min_eigenvalue_estimate;
+    }
+
+    //! \brief Computes the k-th smallest eigenvalue of a tridiagonal matrix.
+    static double bisect(const std::vector<double>& d, const std::vector<double>& e,
+                         double lower, double upper, int k)
+    {
+      for (int it=0; it<100 && upper-lower>1e-14*std::max(std::abs(lower),std::abs(upper)); ++it) {
+        double mid = 0.5*(lower+upper);
+        // count the eigenvalues smaller than mid
+        int count = 0;
+        double q = 1.0;
+        for (size_t j=0; j<d.size(); ++j) {
+          double off = j>0 ? e[j-1]*e[j-1] : 0.0;
+          q = d[j] - mid - (j>0 ? off/q : 0.0);
+          if (q==0.0)
+            q = 1e-300;
+          if (q<0)
+            ++count;
+        }
+        if (count>=k)
+          upper = mid;
+        else
+          lower = mid;
+      }
+      return 0.5*(lower+upper);
+    }
+
     SeqScalarProduct<X> ssp;
     LinearOperator<X,X>& _op;
     Preconditioner<X,X>& _prec;
@@ -636,6 +742,7 @@ namespace Dune {
     double _reduction;
     int _maxit;
     int _verbose;
+    bool _condition_estimate;
   };
 
 
@@ -900,6 +1007,617 @@ namespace Dune {
     int _verbose;
   };
 
+  /*!
+    \brief Bi-conjugate Gradient Stabilized (BiCGStab(l))
+
+    Implements BiCGStab(l) as described in G. L. G. Sleijpen and
+    D. R. Fokkema, 'BiCGstab(l) for linear equations involving unsymmetric
+    matrices with complex spectrum', ETNA 1, pp. 11-32, 1993.
+
+    Each cycle performs l BiCG steps followed by a minimal residual
+    polynomial of degree l. Compared to BiCGSTABSolver (which is the
+    special case l=1) this is considerably less prone to breakdown for
+    operators with eigenvalues close to the imaginary axis, e.g. convection
+    dominated problems. The solver needs 2l+5 vectors of storage regardless
+    of the number of iterations. Each iteration reported corresponds to
+    one BiCG step, i.e. two applications of the operator.
+
+    The preconditioner is applied from the right and has to be linear.
+  */
+  template<class X>
+  class BiCGSTABLSolver : public InverseOperator<X,X> {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted
+    typedef typename X::field_type field_type;
+    //! \brief The real type of the field type (is the same of using real numbers, but differs for std::complex)
+    typedef typename FieldTraits<field_type>::real_type real_type;
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+      \param l The degree of the minimal residual polynomial (l>=1).
+    */
+    template<class L, class P>
+    BiCGSTABLSolver (L& op, P& prec,
+      double reduction, int l, int maxit, int verbose) :
+      ssp(), _op(op), _prec(prec), _sp(ssp), _reduction(reduction), _l(l), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert(static_cast<int>(L::category) == static_cast<int>(P::category), "L and P must be of the same category!");
+      dune_static_assert(static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential), "L must be sequential!");
+      if(_l<1)
+        DUNE_THROW(ISTLError, "BiCGSTABLSolver needs l>=1");
+    }
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,S&,P&,double,int,int)
+      \param l The degree of the minimal residual polynomial (l>=1).
+    */
+    template<class L, class S, class P>
+    BiCGSTABLSolver (L& op, S& sp, P& prec,
+      double reduction, int l, int maxit, int verbose) :
+      _op(op), _prec(prec), _sp(sp), _reduction(reduction), _l(l), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
+        "L and P must have the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(S::category),
+        "L and S must have the same category!");
+      if(_l<1)
+        DUNE_THROW(ISTLError, "BiCGSTABLSolver needs l>=1");
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      const double EPSILON=1e-80;
+      const int l=_l;
+      real_type norm, norm_old, norm_0;
+
+      res.clear();                // clear solver statistics
+      Timer watch;                // start a timer
+      _prec.pre(x,b);             // prepare preconditioner
+      _op.applyscaleadd(-1,x,b);  // overwrite b with defect
+
+      // r[0] is the defect, r[j] = (AM^-1)^j r[0] during the BiCG part.
+      // The correction is accumulated in xt and preconditioned only once
+      // at the end, i.e. x = x_0 + M^-1 xt.
+      std::vector<X> r(l+1,b);
+      std::vector<X> u(l+1,b);
+      X rt(b);                    // the shadow residual
+      X xt(b);                    // the (unpreconditioned) correction
+      X y(x);                     // temporary for preconditioning
+
+      for(int j=0; j<=l; ++j)
+        u[j]=0;
+      xt=0;
+
+      // coefficients of the minimal residual part
+      std::vector<std::vector<field_type> > tau(l+1, std::vector<field_type>(l+1));
+      std::vector<field_type> sigma(l+1), gamma(l+1), gammap(l+1), gammapp(l+1);
+
+      norm = norm_old = norm_0 = _sp.norm(r[0]);
+
+      if (_verbose>0)             // printing
+      {
+        std::cout << "=== BiCGSTABLSolver" << std::endl;
+        if (_verbose>1)
+        {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,norm_0);
+        }
+      }
+
+      if ( norm<1E-30 )
+      {
+        res.converged = true;
+        _prec.post(x);                  // postprocess preconditioner
+        res.iterations = 0;             // fill statistics
+        res.reduction = 0;
+        res.conv_rate  = 0;
+        res.elapsed = watch.elapsed();
+        return;
+      }
+
+      field_type rho0=1, rho1, alpha=0, beta, omega=1;
+      int it=0;
+
+      while ( it<_maxit && !res.converged )
+      {
+        rho0 *= -omega;
+
+        //
+        // BiCG part
+        //
+        for (int j=0; j<l; ++j)
+        {
+          rho1 = _sp.dot(rt,r[j]);
+          if (std::abs(rho0) <= EPSILON)
+            DUNE_THROW(ISTLError,"breakdown in BiCGSTAB(l) - rho "
+              << rho0 << " <= EPSILON " << EPSILON
+              << " after " << it << " iterations");
+          beta = alpha*rho1/rho0;
+          rho0 = rho1;
+
+          for (int i=0; i<=j; ++i)
+          {
+            // u[i] = r[i] - beta u[i]
+            u[i] *= -beta;
+            u[i] += r[i];
+          }
+          applyPreconditionedOperator(u[j],y,u[j+1]);
+
+          field_type h = _sp.dot(rt,u[j+1]);
+          if ( std::abs(h) <= EPSILON )
+            DUNE_THROW(ISTLError,"breakdown in BiCGSTAB(l) - h "
+              << h << " <= EPSILON " << EPSILON
+              << " after " << it << " iterations");
+          alpha = rho0/h;
+
+          for (int i=0; i<=j; ++i)
+            r[i].axpy(-alpha,u[i+1]);
+          applyPreconditionedOperator(r[j],y,r[j+1]);
+          xt.axpy(alpha,u[0]);
+
+          ++it;
+          norm = _sp.norm(r[0]);
+          if (_verbose>1)             // print
+            this->printOutput(std::cout,it,norm,norm_old);
+          norm_old = norm;
+
+          if ( norm < (_reduction * norm_0) || norm<1E-30 || it>=_maxit )
+          {
+            res.converged = ( norm < (_reduction * norm_0) || norm<1E-30 );
+            break;
+          }
+        }
+
+        if ( res.converged || it>=_maxit )
+          break;
+
+        //
+        // minimal residual part (modified Gram-Schmidt)
+        //
+        for (int j=1; j<=l; ++j)
+        {
+          for (int i=1; i<j; ++i)
+          {
+            tau[i][j] = _sp.dot(r[i],r[j])/sigma[i];
+            r[j].axpy(-tau[i][j],r[i]);
+          }
+          sigma[j] = _sp.dot(r[j],r[j]);
+          if ( std::abs(sigma[j]) <= EPSILON )
+            DUNE_THROW(ISTLError,"breakdown in BiCGSTAB(l) - sigma "
+              << sigma[j] << " <= EPSILON " << EPSILON
+              << " after " << it << " iterations");
+          gammap[j] = _sp.dot(r[j],r[0])/sigma[j];
+        }
+
+        gamma[l] = gammap[l];
+        omega = gamma[l];
+        for (int j=l-1; j>=1; --j)
+        {
+          gamma[j] = gammap[j];
+          for (int i=j+1; i<=l; ++i)
+            gamma[j] -= tau[j][i]*gamma[i];
+        }
+        for (int j=1; j<l; ++j)
+        {
+          gammapp[j] = gamma[j+1];
+          for (int i=j+1; i<l; ++i)
+            gammapp[j] += tau[j][i]*gamma[i+1];
+        }
+
+        xt.axpy(gamma[1],r[0]);
+        r[0].axpy(-gammap[l],r[l]);
+        u[0].axpy(-gamma[l],u[l]);
+        for (int j=1; j<l; ++j)
+        {
+          u[0].axpy(-gamma[j],u[j]);
+          xt.axpy(gammapp[j],r[j]);
+          r[0].axpy(-gammap[j],r[j]);
+        }
+
+        norm = _sp.norm(r[0]);
+        if (_verbose>1)             // print
+          this->printOutput(std::cout,it,norm,norm_old);
+        norm_old = norm;
+
+        if ( norm < (_reduction * norm_0) || norm<1E-30 )
+          res.converged = true;
+
+        if ( std::abs(omega) <= EPSILON && !res.converged )
+          DUNE_THROW(ISTLError,"breakdown in BiCGSTAB(l) - omega "
+            << omega << " <= EPSILON " << EPSILON
+            << " after " << it << " iterations");
+      }
+
+      // x = x_0 + M^-1 xt
+      y = 0;
+      _prec.apply(y,xt);
+      x += y;
+
+      if (_verbose==1)                // printing for non verbose
+        this->printOutput(std::cout,it,norm);
+
+      _prec.post(x);                  // postprocess preconditioner
+      res.iterations = it;            // fill statistics
+      res.reduction = norm/norm_0;
+      res.conv_rate  = pow(res.reduction,1.0/it);
+      res.elapsed = watch.elapsed();
+      if (_verbose>0)                 // final print
+        std::cout << "=== rate=" << res.conv_rate
+                  << ", T=" << res.elapsed
+                  << ", TIT=" << res.elapsed/it
+                  << ", IT=" << it << std::endl;
+    }
+
+    /*!
+      \brief Apply inverse operator with given reduction factor.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction, InverseOperatorResult& res)
+    {
+      std::swap(_reduction,reduction);
+      (*this).apply(x,b,res);
+      std::swap(_reduction,reduction);
+    }
+
+  private:
+    //! \brief Computes \f$ v = AM^{-1} d\f$ using y as temporary.
+    void applyPreconditionedOperator(const X& d, X& y, X& v)
+    {
+      y = 0;
+      _prec.apply(y,d);
+      _op.apply(y,v);
+    }
+
+    SeqScalarProduct<X> ssp;
+    LinearOperator<X,X>& _op;
+    Preconditioner<X,X>& _prec;
+    ScalarProduct<X>& _sp;
+    double _reduction;
+    int _l;
+    int _maxit;
+    int _verbose;
+  };
+
+  /*!
+    \brief Induced Dimension Reduction method (IDR(s))
+
+    Implements IDR(s) with biorthogonalization as described in
+    M. B. van Gijzen and P. Sonneveld, 'Algorithm 913: An elegant IDR(s)
+    variant that efficiently exploits biorthogonality properties',
+    ACM TOMS 38(1), 2011.
+
+    IDR(s) needs at most N+N/s matrix vector products to terminate in
+    exact arithmetic and 3s+4 vectors of storage. IDR(1) is mathematically
+    equivalent to BiCGSTAB; larger s (typically 4 or 8) make the method
+    much more robust for strongly nonsymmetric operators while the memory
+    stays fixed.
+
+    The shadow space is spanned by s pseudo random vectors that are
+    generated deterministically, i.e. repeated solves yield identical
+    iterates. The preconditioner is applied from the right. Each
+    iteration reported corresponds to one application of the operator.
+  */
+  template<class X>
+  class IDRSSolver : public InverseOperator<X,X> {
+  public:
+    //! \brief The domain type of the operator to be inverted.
+    typedef X domain_type;
+    //! \brief The range type of the operator to be inverted.
+    typedef X range_type;
+    //! \brief The field type of the operator to be inverted
+    typedef typename X::field_type field_type;
+    //! \brief The real type of the field type (is the same of using real numbers, but differs for std::complex)
+    typedef typename FieldTraits<field_type>::real_type real_type;
+
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,P&,double,int,int)
+      \param s The dimension of the shadow space (s>=1).
+    */
+    template<class L, class P>
+    IDRSSolver (L& op, P& prec,
+      double reduction, int s, int maxit, int verbose) :
+      ssp(), _op(op), _prec(prec), _sp(ssp), _reduction(reduction), _s(s), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert(static_cast<int>(L::category) == static_cast<int>(P::category), "L and P must be of the same category!");
+      dune_static_assert(static_cast<int>(L::category) == static_cast<int>(SolverCategory::sequential), "L must be sequential!");
+      if(_s<1)
+        DUNE_THROW(ISTLError, "IDRSSolver needs s>=1");
+    }
+    /*!
+      \brief Set up solver.
+
+      \copydoc LoopSolver::LoopSolver(L&,S&,P&,double,int,int)
+      \param s The dimension of the shadow space (s>=1).
+    */
+    template<class L, class S, class P>
+    IDRSSolver (L& op, S& sp, P& prec,
+      double reduction, int s, int maxit, int verbose) :
+      _op(op), _prec(prec), _sp(sp), _reduction(reduction), _s(s), _maxit(maxit), _verbose(verbose)
+    {
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(P::category),
+        "L and P must have the same category!");
+      dune_static_assert( static_cast<int>(L::category) == static_cast<int>(S::category),
+        "L and S must have the same category!");
+      if(_s<1)
+        DUNE_THROW(ISTLError, "IDRSSolver needs s>=1");
+    }
+
+    /*!
+      \brief Apply inverse operator.
+
+      \copydoc InverseOperator::apply(X&,Y&,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, InverseOperatorResult& res)
+    {
+      const double EPSILON=1e-80;
+      // angle threshold for the computation of omega ("maintaining the convergence")
+      const real_type kappa=0.7;
+      const int s=_s;
+      real_type norm, norm_old, norm_0;
+
+      res.clear();                // clear solver statistics
+      Timer watch;                // start a timer
+      _prec.pre(x,b);             // prepare preconditioner
+      _op.applyscaleadd(-1,x,b);  // overwrite b with defect
+
+      X& r=b;
+      std::vector<X> P(s,r);      // the shadow space
+      std::vector<X> G(s,r);      // G = AU
+      std::vector<X> U(s,x);      // the search directions
+      X v(x);
+      X w(r);
+
+      // set up orthonormal pseudo random shadow space
+      RandomGenerator gen;
+      for (int k=0; k<s; ++k)
+      {
+        RandomFill<X::blocklevel>::fill(P[k],gen);
+        for (int i=0; i<k; ++i)
+          P[k].axpy(-_sp.dot(P[i],P[k]),P[i]);
+        P[k] /= _sp.norm(P[k]);
+        G[k] = 0;
+        U[k] = 0;
+      }
+
+      // M = P^T G, lower triangular due to the biorthogonalization
+      std::vector<std::vector<field_type> > M(s, std::vector<field_type>(s,0.0));
+      for (int k=0; k<s; ++k)
+        M[k][k] = 1.0;
+      std::vector<field_type> f(s), c(s);
+      field_type omega = 1.0;
+
+      norm = norm_old = norm_0 = _sp.norm(r);
+
+      if (_verbose>0)             // printing
+      {
+        std::cout << "=== IDRSSolver" << std::endl;
+        if (_verbose>1)
+        {
+          this->printHeader(std::cout);
+          this->printOutput(std::cout,0,norm_0);
+        }
+      }
+
+      if ( norm<1E-30 )
+      {
+        res.converged = true;
+        _prec.post(x);                  // postprocess preconditioner
+        res.iterations = 0;             // fill statistics
+        res.reduction = 0;
+        res.conv_rate  = 0;
+        res.elapsed = watch.elapsed();
+        return;
+      }
+
+      int it=0;
+      while ( it<_maxit && !res.converged )
+      {
+        for (int i=0; i<s; ++i)
+          f[i] = _sp.dot(P[i],r);
+
+        for (int k=0; k<s; ++k)
+        {
+          // solve the lower triangular system M(k:s,k:s) c = f(k:s)
+          for (int i=k; i<s; ++i)
+          {
+            c[i] = f[i];
+            for (int j=k; j<i; ++j)
+              c[i] -= M[i][j]*c[j];
+            c[i] /= M[i][i];
+          }
+
+          // w = r - G(:,k:s) c
+          w = r;
+          for (int i=k; i<s; ++i)
+            w.axpy(-c[i],G[i]);
+
+          // U(:,k) = omega M^-1 w + U(:,k:s) c
+          v = 0;
+          _prec.apply(v,w);
+          U[k] *= c[k];
+          U[k].axpy(omega,v);
+          for (int i=k+1; i<s; ++i)
+            U[k].axpy(c[i],U[i]);
+          _op.apply(U[k],G[k]);
+
+          // make G(:,k) orthogonal to P(:,0:k-1)
+          for (int i=0; i<k; ++i)
+          {
+            field_type alpha = _sp.dot(P[i],G[k])/M[i][i];
+            G[k].axpy(-alpha,G[i]);
+            U[k].axpy(-alpha,U[i]);
+          }
+
+          for (int i=k; i<s; ++i)
+            M[i][k] = _sp.dot(P[i],G[k]);
+
+          if (std::abs(M[k][k]) <= EPSILON)
+            DUNE_THROW(ISTLError,"breakdown in IDR(s) - M_kk "
+              << M[k][k] << " <= EPSILON " << EPSILON
+              << " after " << it << " iterations");
+
+          // make r orthogonal to P(:,0:k)
+          field_type beta = f[k]/M[k][k];
+          r.axpy(-beta,G[k]);
+          x.axpy(beta,U[k]);
+
+          ++it;
+          norm = _sp.norm(r);
+          if (_verbose>1)             // print
+            this->printOutput(std::cout,it,norm,norm_old);
+          norm_old = norm;
+
+          if ( norm < (_reduction * norm_0) || norm<1E-30 )
+          {
+            res.converged = true;
+            break;
+          }
+          if (it>=_maxit)
+            break;
+
+          for (int i=k+1; i<s; ++i)
+            f[i] -= beta*M[i][k];
+        }
+
+        if ( res.converged || it>=_maxit )
+          break;
+
+        //
+        // dimension reduction step: enter the next Sonneveld space
+        //
+        v = 0;
+        _prec.apply(v,r);
+        _op.apply(v,w);
+
+        real_type normt = _sp.norm(w);
+        field_type tr = _sp.dot(w,r);
+        if (normt <= EPSILON)
+          DUNE_THROW(ISTLError,"breakdown in IDR(s) - |t| "
+            << normt << " <= EPSILON " << EPSILON
+            << " after " << it << " iterations");
+        omega = tr/(normt*normt);
+        real_type rho = std::abs(tr/(normt*norm));
+        if (rho < kappa)
+          omega *= kappa/rho;
+        if (std::abs(omega) <= EPSILON)
+          DUNE_THROW(ISTLError,"breakdown in IDR(s) - omega "
+            << omega << " <= EPSILON " << EPSILON
+            << " after " << it << " iterations");
+
+        r.axpy(-omega,w);
+        x.axpy(omega,v);
+
+        ++it;
+        norm = _sp.norm(r);
+        if (_verbose>1)             // print
+          this->printOutput(std::cout,it,norm,norm_old);
+        norm_old = norm;
+
+        if ( norm < (_reduction * norm_0) || norm<1E-30 )
+          res.converged = true;
+      }
+
+      if (_verbose==1)                // printing for non verbose
+        this->printOutput(std::cout,it,norm);
+
+      _prec.post(x);                  // postprocess preconditioner
+      res.iterations = it;            // fill statistics
+      res.reduction = norm/norm_0;
+      res.conv_rate  = pow(res.reduction,1.0/it);
+      res.elapsed = watch.elapsed();
+      if (_verbose>0)                 // final print
+        std::cout << "=== rate=" << res.conv_rate
+                  << ", T=" << res.elapsed
+                  << ", TIT=" << res.elapsed/it
+                  << ", IT=" << it << std::endl;
+    }
+
+    /*!
+      \brief Apply inverse operator with given reduction factor.
+
+      \copydoc InverseOperator::apply(X&,Y&,double,InverseOperatorResult&)
+    */
+    virtual void apply (X& x, X& b, double reduction, InverseOperatorResult& res)
+    {
+      std::swap(_reduction,reduction);
+      (*this).apply(x,b,res);
+      std::swap(_reduction,reduction);
+    }
+
+  private:
+    /**
+     * @brief Linear congruential generator for the shadow space.
+     *
+     * Returns numbers uniformly distributed in [-1,1). We do not use
+     * std::rand to leave the global state of the user untouched.
+     */
+    struct RandomGenerator
+    {
+      RandomGenerator()
+        : state(12345u)
+      {}
+
+      double operator()()
+      {
+        state = 1664525u*state+1013904223u;
+        return state/2147483648.0-1.0;
+      }
+
+      unsigned int state;
+    };
+
+    /**
+     * @brief Fills a block vector with the numbers of a generator.
+     *
+     * The unused parameter T allows the specialization for the scalar
+     * entries inside the class.
+     */
+    template<int level, class T=void>
+    struct RandomFill
+    {
+      template<class V, class G>
+      static void fill (V& v, G& gen)
+      {
+        for (typename V::iterator i=v.begin(); i!=v.end(); ++i)
+          RandomFill<level-1>::fill(*i,gen);
+      }
+    };
+
+    template<class T>
+    struct RandomFill<0,T>
+    {
+      template<class K, class G>
+      static void fill (K& k, G& gen)
+      {
+        k = gen();
+      }
+    };
+
+    SeqScalarProduct<X> ssp;
+    LinearOperator<X,X>& _op;
+    Preconditioner<X,X>& _prec;
+    ScalarProduct<X>& _sp;
+    double _reduction;
+    int _s;
+    int _maxit;
+    int _verbose;
+  };
+
   /*! \brief Minimal Residual Method (MINRES)
 
     Symmetrically Preconditioned MINRES as in A. Greenbaum, 'Iterative Methods for Solving Linear Systems', pp. 121
@@ -51,6 +51,7 @@
 #include<dune/common/fvector.hh>
 #include<dune/common/typetraits.hh>
 #include<limits>
+#include<vector>
 
 namespace Dune
 {
@@ -429,6 +430,21 @@ namespace Dune
      */
     template<class S>
     void setMatrix(const Matrix& mat, const S& mrs);
+
+    /** 
+     * @brief Initialize data from a given set of matrix rows and columns
+     *
+     * Instead of allocating an index map of the size of the matrix a
+     * workspace is used, such that many small subsets can be extracted
+     * cheaply, e.g. the subdomains of an overlapping Schwarz method.
+     * @tparam The type of the row index set.
+     * @param mat the matrix with the values
+     * @param mrs The set of row (and column) indices to represent
+     * @param subMatrixIndex Workspace of size mat.N() with all entries
+     * set to the maximum of size_type. The entries are restored on return.
+     */
+    template<class S>
+    void setMatrix(const Matrix& mat, const S& mrs, std::vector<size_type>& subMatrixIndex);
     /** @brief free allocated space. */
     void free();
   private: 
@@ -505,6 +521,8 @@ namespace Dune
     template<typename Iter, typename Set>
     void addRowNnz(const Iter& row, const Set& s)const;
 
+    void addNnz(size_type nnz)const;
+
     void allocate();
         
     template<typename Iter>
@@ -577,6 +595,12 @@ namespace Dune
       }
   }
 
+  template<class T, class A, int n, int m>
+  void SuperMatrixInitializer<BCRSMatrix<FieldMatrix<T,n,m>,A> >::addNnz(size_type nnz)const
+  {
+    mat->Nnz_+=nnz;
+  }
+
   template<class T, class A, int n, int m>
   void SuperMatrixInitializer<BCRSMatrix<FieldMatrix<T,n,m>,A> >::allocate()
   {
@@ -691,8 +715,30 @@ namespace Dune
     initializer.createMatrix();
   }
 
+  template<class F, class M,class S>
+  void copyToSuperMatrix(F& initializer, const MatrixRowSubset<M,S>& mrs,
+                         std::vector<typename M::size_type>& subMatrixIndex);
+
   template<class F, class M,class S>
   void copyToSuperMatrix(F& initializer, const MatrixRowSubset<M,S>& mrs)
+  {
+    typedef typename M::size_type size_type;
+    std::vector<size_type> subMatrixIndex(mrs.matrix().N(), 
+                                          std::numeric_limits<size_type>::max());
+    copyToSuperMatrix(initializer, mrs, subMatrixIndex);
+  }
+
+  /**
+   * @brief Copy a subset of rows and columns using a workspace.
+   *
+   * @param subMatrixIndex A vector containing the corresponding indices in
+   * the to create submatrix. All entries have to be the maximum of size_type
+   * on entry, i.e. the index will not appear in the submatrix. They are
+   * restored on return.
+   */
+  template<class F, class M,class S>
+  void copyToSuperMatrix(F& initializer, const MatrixRowSubset<M,S>& mrs,
+                         std::vector<typename M::size_type>& subMatrixIndex)
   {
     typedef MatrixRowSubset<M,S> MRS;
     typedef typename MRS::RowIndexSet SIS;
@@ -700,28 +746,26 @@ namespace Dune
     typedef typename MRS::const_iterator Iter;
     typedef typename std::iterator_traits<Iter>::value_type row_type;
     typedef typename row_type::const_iterator CIter;
-
-    // Calculate upper Bound for nonzeros
-    for(Iter row=mrs.begin(); row!= mrs.end(); ++row)
-      initializer.addRowNnz(row, mrs.rowIndexSet());
-
-    initializer.allocate();
-
     typedef typename MRS::Matrix::size_type size_type;
+    const size_type unused=std::numeric_limits<size_type>::max();
 
-    // A vector containing the corresponding indices in
-    // the to create submatrix.
-    // If an entry is the maximum of size_type then this index will not appear in 
-    // the submatrix.
-    std::vector<size_type> subMatrixIndex(mrs.matrix().N(), 
-					 std::numeric_limits<size_type>::max());
     size_type s=0;
     for(SIter index = mrs.rowIndexSet().begin(); index!=mrs.rowIndexSet().end(); ++index)
       subMatrixIndex[*index]=s++;
-    
+
+    // Count the nonzeros of the submatrix
+    size_type nnz=0;
+    for(Iter row=mrs.begin(); row!= mrs.end(); ++row)
+      for(CIter col=row->begin(); col != row->end(); ++col)
+	if(subMatrixIndex[col.index()]!=unused)
+          ++nnz;
+    initializer.addNnz(nnz);
+
+    initializer.allocate();
+
     for(Iter row=mrs.begin(); row!= mrs.end(); ++row)
       for(CIter col=row->begin(); col != row->end(); ++col){
-	if(subMatrixIndex[col.index()]!=std::numeric_limits<size_type>::max())
+	if(subMatrixIndex[col.index()]!=unused)
 	  // This column is in our subset (use submatrix column index)
 	  initializer.countEntries(subMatrixIndex[col.index()]);
     }
@@ -730,11 +774,14 @@ namespace Dune
     
     for(Iter row=mrs.begin(); row!= mrs.end(); ++row)
       for(CIter col=row->begin(); col != row->end(); ++col){
-	if(subMatrixIndex[col.index()]!=std::numeric_limits<size_type>::max())
+	if(subMatrixIndex[col.index()]!=unused)
 	  // This value is in our submatrix -> copy (use submatrix indices
 	  initializer.copyValue(col, subMatrixIndex[row.index()], subMatrixIndex[col.index()]);
     }
     initializer.createMatrix();
+
+    for(SIter index = mrs.rowIndexSet().begin(); index!=mrs.rowIndexSet().end(); ++index)
+      subMatrixIndex[*index]=unused;
   }
 
 #ifndef DOXYGEN
@@ -860,6 +907,20 @@ namespace Dune
 #endif
   }
 
+   template<class B, class TA, int n, int m>
+   template<class S>
+  void SuperLUMatrix<BCRSMatrix<FieldMatrix<B,n,m>,TA> >
+   ::setMatrix(const Matrix& mat, const S& mrs, std::vector<size_type>& subMatrixIndex)
+  {
+    if(N_+M_+Nnz_!=0)
+      free();
+    N_=mrs.size()*n;
+    M_=mrs.size()*m;
+    SuperMatrixInitializer<Matrix> initializer(*this);
+    
+    copyToSuperMatrix(initializer, MatrixRowSubset<Matrix,S>(mat,mrs), subMatrixIndex);
+  }
+
   template<class B, class TA, int n, int m>
   SuperLUMatrix<BCRSMatrix<FieldMatrix<B,n,m>,TA> >::~SuperLUMatrix()
   {
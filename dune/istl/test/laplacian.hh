@@ -90,6 +90,20 @@ void setupLaplacian(Dune::BCRSMatrix<B>& A, int N)
     }
   }
 }
+/**
+ * @brief Adds a first order upwind convection term in x direction.
+ */
+template<class M>
+void addConvection(M& mat, int N, double c)
+{
+  for(typename M::RowIterator i = mat.begin(); i != mat.end(); ++i){
+    int x = i.index()%N;
+    if(x>0)
+      (*i)[i.index()-1][0][0] -= c;
+    (*i)[i.index()][0][0] += c;
+  }
+}
+
 template<int BS>
 void setBoundary(Dune::BlockVector<Dune::FieldVector<double,BS> >& lhs, 
 		 Dune::BlockVector<Dune::FieldVector<double,BS> >& rhs,
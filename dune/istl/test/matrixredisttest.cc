@@ -142,5 +142,8 @@ int main(int argc, char** argv)
   }
   
   testRepart<1>(N,coarsenTarget);
+  if(procs>2)
+    // agglomerate to more than one process
+    testRepart<1>(N,procs/2);
   MPI_Finalize();
 }
@@ -0,0 +1,91 @@
+#include"config.h"
+#include<cmath>
+#include<dune/istl/bvector.hh>
+#include<dune/istl/operators.hh>
+#include<dune/istl/preconditioners.hh>
+#include<dune/istl/solvers.hh>
+#include<dune/istl/mixedprecision.hh>
+#include<dune/common/fmatrix.hh>
+#include<dune/common/fvector.hh>
+#include<dune/common/stdstreams.hh>
+#include"laplacian.hh"
+
+template<class Solver, class Vector, class M>
+int testSolver(Solver& solver, const M& mat, const Vector& x0, const char* name)
+{
+  Vector x(x0.N()), b(x0.N());
+  mat.mv(x0, b);
+  x=0;
+
+  Dune::InverseOperatorResult r;
+  solver.apply(x, b, r);
+  x -= x0;
+
+  // the accuracy has to be well beyond single precision
+  if(!r.converged || x.two_norm()>1e-9*x0.two_norm()){
+    Dune::derr<<name<<" failed: error="<<x.two_norm()<<" converged="
+              <<r.converged<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  int N=30;
+
+  if(argc>1)
+    N = atoi(argv[1]);
+
+  typedef Dune::FieldMatrix<double,1,1> MatrixBlock;
+  typedef Dune::BCRSMatrix<MatrixBlock> BCRSMat;
+  typedef Dune::FieldVector<double,1> VectorBlock;
+  typedef Dune::BlockVector<VectorBlock> Vector;
+  typedef Dune::MatrixAdapter<BCRSMat,Vector,Vector> Operator;
+
+  typedef Dune::FieldMatrix<float,1,1> MatrixBlockF;
+  typedef Dune::BCRSMatrix<MatrixBlockF> BCRSMatF;
+  typedef Dune::FieldVector<float,1> VectorBlockF;
+  typedef Dune::BlockVector<VectorBlockF> VectorF;
+  typedef Dune::MatrixAdapter<BCRSMatF,VectorF,VectorF> OperatorF;
+
+  BCRSMat mat;
+  setupLaplacian(mat,N);
+  Operator fop(mat);
+
+  BCRSMatF matf;
+  Dune::convertMatrix(mat,matf);
+  OperatorF fopf(matf);
+
+  int ret=0;
+
+  // the copy has to be exact for this matrix
+  Vector x0(N*N), y(N*N), y2(N*N);
+  VectorF xf, yf(N*N);
+  for(int i=0; i < N*N; ++i)
+    x0[i] = std::sin(0.1*i);
+  mat.mv(x0,y);
+  Dune::convertVector(x0,xf);
+  matf.mv(xf,yf);
+  Dune::convertVector(yf,y2);
+  y2 -= y;
+  if(y2.two_norm()>1e-6*y.two_norm()){
+    Dune::derr<<"convertMatrix failed"<<std::endl;
+    ++ret;
+  }
+
+  Dune::SeqSSOR<BCRSMatF,VectorF,VectorF> ssor(matf,1,1.0);
+  Dune::CGSolver<VectorF> cg(fopf,ssor,1e-3,500,0);
+  {
+    Dune::IterativeRefinementSolver<Vector,VectorF> solver(fop,cg,1e-12,1e-3,20,2);
+    ret += testSolver(solver, mat, x0, "IterativeRefinementSolver CG");
+  }
+
+  Dune::SeqILU0<BCRSMatF,VectorF,VectorF> ilu(matf,1.0);
+  {
+    Dune::IterativeRefinementSolver<Vector,VectorF> solver(fop,ilu,1e-12,2000,1);
+    ret += testSolver(solver, mat, x0, "IterativeRefinementSolver ILU0");
+  }
+
+  return ret;
+}
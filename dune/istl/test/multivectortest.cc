@@ -0,0 +1,176 @@
+#include"config.h"
+#include<cmath>
+#include<complex>
+#include<dune/istl/bvector.hh>
+#include<dune/istl/multivector.hh>
+#include<dune/istl/operators.hh>
+#include<dune/istl/preconditioners.hh>
+#include<dune/istl/blocksolvers.hh>
+#include<dune/common/fmatrix.hh>
+#include<dune/common/fvector.hh>
+#include<dune/common/stdstreams.hh>
+#include"laplacian.hh"
+
+/**
+ * @brief Fills the columns of x with linearly independent vectors.
+ */
+template<class MV>
+void fill(MV& x)
+{
+  for(typename MV::size_type i=0; i<x.N(); ++i)
+    for(int c=0; c<MV::columns; ++c)
+      x[i][0][c] = std::sin(0.1*(c+1)*i) + 0.5*c;
+}
+
+/**
+ * @brief Checks the multi vector kernels against the single vector ones.
+ */
+template<class M, class MV>
+int testKernels(const M& mat, const MV& x)
+{
+  typedef typename MV::column_type Vector;
+  int ret=0;
+  MV y(x.N()), z(x.N());
+  typename MV::coefficient_type c;
+  Vector xc, yc, t(x.N());
+
+  mat.mvmulti(x,y);
+  for(int k=0; k<MV::columns; ++k){
+    x.column(k,xc);
+    y.column(k,yc);
+    mat.mv(xc,t);
+    t -= yc;
+    if(t.two_norm()>1e-12*yc.two_norm()){
+      Dune::derr<<"mvmulti differs from mv in column "<<k<<std::endl;
+      ++ret;
+    }
+  }
+
+  x.transposedMult(y,c);
+  for(int a=0; a<MV::columns; ++a)
+    for(int b=0; b<MV::columns; ++b){
+      x.column(a,xc);
+      y.column(b,yc);
+      if(std::abs(c[a][b]-xc*yc)>1e-10*std::abs(xc*yc)){
+        Dune::derr<<"transposedMult wrong in entry "<<a<<","<<b<<std::endl;
+        ++ret;
+      }
+    }
+
+  // (X C) - X C = 0
+  z=x;
+  z.rightmultiply(c);
+  c *= -1.0;
+  z.rightmultiplyadd(x,c);
+  typename MV::column_norm_type norms, xnorms;
+  z.columnNorms(norms);
+  x.columnNorms(xnorms);
+  if(norms.infinity_norm()>1e-10*c.infinity_norm()*xnorms.one_norm()){
+    Dune::derr<<"rightmultiply and rightmultiplyadd disagree"<<std::endl;
+    ++ret;
+  }
+  return ret;
+}
+
+/**
+ * @brief Checks that transposedMult conjugates the entries of X.
+ */
+int testComplexTransposedMult()
+{
+  typedef std::complex<double> Complex;
+  typedef Dune::BlockMultiVector<Dune::FieldVector<Complex,1>,2> MV;
+  MV x(3), y(3);
+  MV::coefficient_type c;
+  for(MV::size_type i=0; i<x.N(); ++i)
+    for(int a=0; a<MV::columns; ++a){
+      x[i][0][a] = Complex(i+1.0, a+1.0);
+      y[i][0][a] = Complex(a-2.0*i, 1.0);
+    }
+
+  int ret=0;
+  x.transposedMult(y,c);
+  for(int a=0; a<MV::columns; ++a)
+    for(int b=0; b<MV::columns; ++b){
+      Complex expected=0;
+      for(MV::size_type i=0; i<x.N(); ++i)
+        expected += std::conj(x[i][0][a])*y[i][0][b];
+      if(std::abs(c[a][b]-expected)>1e-12*std::abs(expected)){
+        Dune::derr<<"complex transposedMult wrong in entry "<<a<<","<<b<<std::endl;
+        ++ret;
+      }
+    }
+  return ret;
+}
+
+template<class Solver, class MV, class M>
+int testSolver(Solver& solver, const M& mat, const MV& x0, const char* name)
+{
+  typedef typename MV::column_type Vector;
+  MV x(x0.N()), b(x0.N());
+  mat.mvmulti(x0, b);
+  x=0;
+
+  Dune::InverseOperatorResult r;
+  solver.apply(x, b, r);
+  x -= x0;
+
+  int ret=0;
+  Vector e, e0;
+  for(int k=0; k<MV::columns; ++k){
+    x.column(k,e);
+    x0.column(k,e0);
+    if(!r.converged || e.two_norm()>1e-6*e0.two_norm()){
+      Dune::derr<<name<<" failed in column "<<k<<": error="<<e.two_norm()
+                <<" converged="<<r.converged<<std::endl;
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+int main(int argc, char** argv)
+{
+  int N=30;
+
+  if(argc>1)
+    N = atoi(argv[1]);
+
+  typedef Dune::FieldMatrix<double,1,1> MatrixBlock;
+  typedef Dune::BCRSMatrix<MatrixBlock> BCRSMat;
+  typedef Dune::FieldVector<double,1> VectorBlock;
+  typedef Dune::BlockVector<VectorBlock> Vector;
+  typedef Dune::BlockMultiVector<VectorBlock,4> MultiVector;
+  typedef Dune::MultiVectorMatrixAdapter<BCRSMat,MultiVector,MultiVector> Operator;
+
+  BCRSMat mat;
+  setupLaplacian(mat,N);
+
+  MultiVector x0(N*N);
+  fill(x0);
+
+  int ret=testKernels(mat,x0);
+  ret += testComplexTransposedMult();
+
+  Operator op(mat);
+  Dune::SeqSSOR<BCRSMat,Vector,Vector> ssor(mat,1,1.0);
+  Dune::MultiVectorPreconditioner<MultiVector> prec(ssor);
+  Dune::Richardson<MultiVector,MultiVector> richardson(1.0);
+
+  Dune::BlockCGSolver<MultiVector> bcg(op,prec,1e-10,200,2);
+  ret += testSolver(bcg,mat,x0,"BlockCG SSOR");
+  Dune::BlockCGSolver<MultiVector> bcg0(op,richardson,1e-10,500,1);
+  ret += testSolver(bcg0,mat,x0,"BlockCG");
+
+  Dune::BlockGMResSolver<MultiVector> bgmres(op,prec,1e-10,20,200,2);
+  ret += testSolver(bgmres,mat,x0,"BlockGMRes SSOR");
+
+  addConvection(mat,N,4.0);
+  Dune::SeqILU0<BCRSMat,Vector,Vector> ilu(mat,1.0);
+  Dune::MultiVectorPreconditioner<MultiVector> iluprec(ilu);
+  Dune::BlockGMResSolver<MultiVector> bgmres2(op,iluprec,1e-10,10,500,1);
+  ret += testSolver(bgmres2,mat,x0,"BlockGMRes ILU0 convection");
+  Dune::BlockGMResSolver<MultiVector> bgmres3(op,richardson,1e-10,30,1000,1);
+  ret += testSolver(bgmres3,mat,x0,"BlockGMRes convection");
+
+  return ret;
+}
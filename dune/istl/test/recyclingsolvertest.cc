@@ -0,0 +1,143 @@
+#include"config.h"
+#include<cmath>
+#include<dune/istl/bvector.hh>
+#include<dune/istl/operators.hh>
+#include<dune/istl/preconditioners.hh>
+#include<dune/istl/solvers.hh>
+#include<dune/istl/recyclingsolvers.hh>
+#include<dune/common/fmatrix.hh>
+#include<dune/common/fvector.hh>
+#include<dune/common/stdstreams.hh>
+#include"laplacian.hh"
+
+/**
+ * @brief Sets up the matrix of time step t of a slowly varying sequence.
+ *
+ * The Laplacian gets a small varying reaction term and, if c is nonzero,
+ * an upwind convection term in x direction.
+ */
+template<class M>
+void setupStep(M& mat, int N, int t, double c)
+{
+  setupLaplacian(mat,N);
+  addConvection(mat,N,c);
+  for(typename M::RowIterator i = mat.begin(); i != mat.end(); ++i)
+    (*i)[i.index()][0][0] += 1e-3*(1.0+std::sin(0.3*t+0.01*i.index()));
+}
+
+/**
+ * @brief Solves the sequence with the given solvers and compares the
+ * iteration counts.
+ */
+template<class Solver, class RecyclingSolver, class M, class Vector>
+int testSequence(Solver& solver, RecyclingSolver& rsolver, M& mat, int N,
+                 double c, Vector& x0, const char* name)
+{
+  int ret=0, its=0, rits=0;
+  for(int t=0; t<8; ++t){
+    setupStep(mat,N,t,c);
+    for(typename Vector::size_type i=0; i<x0.N(); ++i)
+      x0[i] = std::sin(0.1*i+0.2*t);
+
+    Vector x(x0.N()), b(x0.N());
+    Dune::InverseOperatorResult r;
+
+    mat.mv(x0,b);
+    x = 0;
+    solver.apply(x,b,r);
+    its += r.iterations;
+
+    mat.mv(x0,b);
+    x = 0;
+    rsolver.apply(x,b,r);
+    rits += r.iterations;
+    x -= x0;
+    if(!r.converged || x.two_norm()>1e-6*x0.two_norm()){
+      Dune::derr<<name<<" failed in step "<<t<<": error="<<x.two_norm()
+                <<" converged="<<r.converged<<std::endl;
+      ++ret;
+    }
+  }
+  std::cout<<name<<": "<<rits<<" iterations with recycling, "<<its
+           <<" without"<<std::endl;
+  if(rits>=its){
+    Dune::derr<<name<<" did not reduce the number of iterations"<<std::endl;
+    ++ret;
+  }
+  return ret;
+}
+
+/**
+ * @brief Solves a system whose defect lies in the recycled subspace.
+ *
+ * The projected defect vanishes and must not be normalized.
+ */
+template<class RecyclingSolver, class M, class Vector>
+int testRecycledDefect(RecyclingSolver& rsolver, const M& mat, const char* name)
+{
+  int ret=0;
+  for(int t=0; t<2; ++t){
+    Vector x(mat.M()), b(mat.N());
+    Dune::InverseOperatorResult r;
+    x = 0;
+    b = 1;
+    rsolver.apply(x,b,r);
+    b = 1;
+    mat.mmv(x,b);
+    if(!r.converged || !(b.two_norm()<1e-8)){
+      Dune::derr<<name<<" failed for a recycled defect in solve "<<t
+                <<": defect="<<b.two_norm()<<" converged="<<r.converged<<std::endl;
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+int main(int argc, char** argv)
+{
+  int N=40;
+
+  if(argc>1)
+    N = atoi(argv[1]);
+
+  typedef Dune::FieldMatrix<double,1,1> MatrixBlock;
+  typedef Dune::BCRSMatrix<MatrixBlock> BCRSMat;
+  typedef Dune::FieldVector<double,1> VectorBlock;
+  typedef Dune::BlockVector<VectorBlock> Vector;
+  typedef Dune::MatrixAdapter<BCRSMat,Vector,Vector> Operator;
+
+  BCRSMat mat;
+  setupStep(mat,N,0,0.0);
+  Operator fop(mat);
+  Vector x0(N*N);
+
+  Dune::SeqSSOR<BCRSMat,Vector,Vector> ssor(mat,1,1.0);
+  Dune::Richardson<Vector,Vector> id(1.0);
+
+  int ret=0;
+  {
+    Dune::CGSolver<Vector> cg(fop,ssor,1e-8,1000,0);
+    Dune::RecyclingCGSolver<Vector> rcg(fop,ssor,1e-8,8,40,1000,0);
+    ret += testSequence(cg,rcg,mat,N,0.0,x0,"RecyclingCGSolver SSOR");
+  }
+  {
+    Dune::CGSolver<Vector> cg(fop,id,1e-8,1000,0);
+    Dune::RecyclingCGSolver<Vector> rcg(fop,id,1e-8,8,40,1000,0);
+    ret += testSequence(cg,rcg,mat,N,0.0,x0,"RecyclingCGSolver");
+  }
+
+  {
+    Dune::RestartedGMResSolver<Vector> gmres(fop,id,1e-8,30,2000,0);
+    Dune::RecyclingGMResSolver<Vector> rgmres(fop,id,1e-8,10,30,2000,0);
+    ret += testSequence(gmres,rgmres,mat,N,2.0,x0,"RecyclingGMResSolver");
+  }
+  {
+    BCRSMat single;
+    setupLaplacian(single,1);
+    Operator sop(single);
+    Dune::RecyclingGMResSolver<Vector> rgmres(sop,id,1e-8,1,2,100,0);
+    ret += testRecycledDefect<Dune::RecyclingGMResSolver<Vector>,BCRSMat,Vector>(rgmres,single,"RecyclingGMResSolver");
+  }
+
+  return ret;
+}
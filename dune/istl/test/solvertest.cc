@@ -0,0 +1,101 @@
+#include"config.h"
+#include<cmath>
+#include<dune/istl/bvector.hh>
+#include<dune/istl/operators.hh>
+#include<dune/istl/preconditioners.hh>
+#include<dune/istl/solvers.hh>
+#include<dune/common/fmatrix.hh>
+#include<dune/common/fvector.hh>
+#include<dune/common/stdstreams.hh>
+#include"laplacian.hh"
+
+template<class Solver, class Vector, class M>
+int testSolver(Solver& solver, const M& mat, const Vector& x0, const char* name)
+{
+  Vector x(x0.N()), b(x0.N());
+  mat.mv(x0, b);
+  x=0;
+
+  Dune::InverseOperatorResult r;
+  solver.apply(x, b, r);
+  x -= x0;
+
+  if(!r.converged || x.two_norm()>1e-6*x0.two_norm()){
+    Dune::derr<<name<<" failed: error="<<x.two_norm()<<" converged="
+              <<r.converged<<std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  int N=30;
+
+  if(argc>1)
+    N = atoi(argv[1]);
+
+  typedef Dune::FieldMatrix<double,1,1> MatrixBlock;
+  typedef Dune::BCRSMatrix<MatrixBlock> BCRSMat;
+  typedef Dune::FieldVector<double,1> VectorBlock;
+  typedef Dune::BlockVector<VectorBlock> Vector;
+  typedef Dune::MatrixAdapter<BCRSMat,Vector,Vector> Operator;
+
+  BCRSMat mat;
+  setupLaplacian(mat,N);
+
+  int ret=0;
+
+  {
+    // the extreme eigenvalues of the Laplacian are known
+    const double pi = 3.14159265358979323846;
+    const double lmin = 4.0-4.0*std::cos(pi/(N+1)), lmax = 4.0+4.0*std::cos(pi/(N+1));
+    Operator op(mat);
+    Dune::Richardson<Vector,Vector> id(1.0);
+    Dune::CGSolver<Vector> solver(op, id, 1e-10, 1000, 1, true);
+    Vector x(N*N), b(N*N);
+    for(int i=0; i < N*N; ++i)
+      b[i] = std::sin(0.1*i);
+    x=0;
+    Dune::InverseOperatorResult r;
+    solver.apply(x, b, r);
+    if(std::abs(r.min_eigenvalue_estimate-lmin)>1e-3*lmin
+       || std::abs(r.max_eigenvalue_estimate-lmax)>1e-3*lmax
+       || std::abs(r.condition_estimate-lmax/lmin)>1e-2*lmax/lmin){
+      Dune::derr<<"CGSolver spectral estimate failed: ["<<r.min_eigenvalue_estimate
+                <<", "<<r.max_eigenvalue_estimate<<"] instead of ["<<lmin<<", "
+                <<lmax<<"]"<<std::endl;
+      ++ret;
+    }
+  }
+
+  addConvection(mat,N,4.0);
+
+  Operator fop(mat);
+  Vector x0(N*N);
+  for(int i=0; i < N*N; ++i)
+    x0[i] = std::sin(0.1*i);
+
+  Dune::SeqILU0<BCRSMat,Vector,Vector> ilu(mat,1.0);
+  Dune::Richardson<Vector,Vector> id(1.0);
+
+  for(int l=1; l<=4; ++l){
+    Dune::BiCGSTABLSolver<Vector> solver(fop, ilu, 1e-10, l, 500, 1);
+    ret += testSolver(solver, mat, x0, "BiCGSTABLSolver");
+  }
+  {
+    Dune::BiCGSTABLSolver<Vector> solver(fop, id, 1e-10, 2, 5000, 1);
+    ret += testSolver(solver, mat, x0, "BiCGSTABLSolver (unpreconditioned)");
+  }
+
+  for(int s=1; s<=8; s*=2){
+    Dune::IDRSSolver<Vector> solver(fop, ilu, 1e-10, s, 500, 1);
+    ret += testSolver(solver, mat, x0, "IDRSSolver");
+  }
+  {
+    Dune::IDRSSolver<Vector> solver(fop, id, 1e-10, 4, 5000, 1);
+    ret += testSolver(solver, mat, x0, "IDRSSolver (unpreconditioned)");
+  }
+
+  return ret;
+}
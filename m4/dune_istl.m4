@@ -11,9 +11,22 @@ AC_DEFUN([DUNE_ISTL_CHECKS],
   AC_REQUIRE([AC_PROG_F77])
   AC_REQUIRE([ACX_BLAS])
   DUNE_BOOST_BASE(, [ DUNE_BOOST_FUSION ] , [] )
+
+  # OpenMP is used by the threaded parts of the AMG and of the overlapping
+  # Schwarz setup. OPENMP_CXXFLAGS has to be added to the compile and link
+  # flags of a program to enable them.
+  AC_LANG_PUSH([C++])
+  AC_OPENMP
+  AC_LANG_POP([C++])
+  if test "x$OPENMP_CXXFLAGS" != "x" ; then
+    with_openmp="yes ($OPENMP_CXXFLAGS)"
+  else
+    with_openmp="no"
+  fi
   
   # add summary entries for tests not maintained by dune
   DUNE_ADD_SUMMARY_ENTRY([METIS],[$with_metis])
+  DUNE_ADD_SUMMARY_ENTRY([OpenMP],[$with_openmp])
   DUNE_ADD_SUMMARY_ENTRY([BLAS],[$acx_blas_ok])
 ])
 